@@ -4,6 +4,7 @@
 #include "pd4j/class_loader.h"
 #include "pd4j/lua_glue.h"
 #include "pd4j/memory.h"
+#include "pd4j/native.h"
 #include "pd4j/utf8.h"
 
 PlaydateAPI *pd;
@@ -17,6 +18,8 @@ int eventHandler(PlaydateAPI* playdate, PDSystemEvent event, uint32_t arg) {
 	if (event == kEventInit) {
 		pd = playdate;
 		
+		pd4j_native_register_all();
+		
 		uint8_t *name;
 		size_t sz = pd4j_utf8_to_java(&name, "Main", 4);
 		
@@ -5,6 +5,8 @@
 
 #include "class.h"
 #include "class_loader.h"
+#include "descriptor.h"
+#include "link.h"
 #include "memory.h"
 #include "module.h"
 #include "resolve.h"
@@ -17,6 +19,9 @@ static pd4j_class_reference byteClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'B'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -29,7 +34,7 @@ static pd4j_thread_reference byteThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference charClassRef = {
@@ -38,6 +43,9 @@ static pd4j_class_reference charClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'C'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -50,7 +58,7 @@ static pd4j_thread_reference charThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference doubleClassRef = {
@@ -59,6 +67,9 @@ static pd4j_class_reference doubleClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'D'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -71,7 +82,7 @@ static pd4j_thread_reference doubleThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference floatClassRef = {
@@ -80,6 +91,9 @@ static pd4j_class_reference floatClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'F'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -92,7 +106,7 @@ static pd4j_thread_reference floatThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference intClassRef = {
@@ -101,6 +115,9 @@ static pd4j_class_reference intClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'I'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -113,7 +130,7 @@ static pd4j_thread_reference intThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference longClassRef = {
@@ -122,6 +139,9 @@ static pd4j_class_reference longClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'J'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -134,7 +154,7 @@ static pd4j_thread_reference longThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference shortClassRef = {
@@ -143,6 +163,9 @@ static pd4j_class_reference shortClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'S'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -155,7 +178,7 @@ static pd4j_thread_reference shortThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference voidClassRef = {
@@ -164,6 +187,9 @@ static pd4j_class_reference voidClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'V'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -176,7 +202,7 @@ static pd4j_thread_reference voidThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 static pd4j_class_reference booleanClassRef = {
@@ -185,6 +211,9 @@ static pd4j_class_reference booleanClassRef = {
 	NULL,
 	pd4j_CLASS_PRIMITIVE,
 	{.primitiveType = (uint8_t)'Z'},
+	NULL,
+	NULL,
+	0,
 	NULL
 };
 
@@ -197,7 +226,7 @@ static pd4j_thread_reference booleanThreadRef = {
 		0,
 		NULL
 	}},
-	{NULL, 0}
+	0
 };
 
 pd4j_class_attribute *pd4j_class_attribute_name(pd4j_class *class, const uint8_t *name) {
@@ -220,6 +249,14 @@ pd4j_class_attribute *pd4j_class_property_attribute_name(pd4j_class_property *pr
 	return NULL;
 }
 
+pd4j_class_method_descriptor *pd4j_class_property_method_descriptor(pd4j_class_property *method, pd4j_thread *thread) {
+	if (method->parsedDescriptor == NULL) {
+		method->parsedDescriptor = pd4j_descriptor_parse_method_descriptor(method->descriptor, thread);
+	}
+	
+	return method->parsedDescriptor;
+}
+
 bool pd4j_class_constant_utf8(pd4j_class *class, uint16_t idx, uint8_t **value) {
 	if (idx > class->numConstants) {
 		return false;
@@ -275,52 +312,76 @@ bool pd4j_class_constant_float(pd4j_class *class, uint16_t idx, float *value) {
 	return true;
 }
 
-bool pd4j_class_constant_long(pd4j_class *class, uint16_t idx, int64_t *value) {
-	if (idx > class->numConstants) {
+// 8-byte constants take two entries, the high word in the first and the low word in the second
+static bool pd4j_class_constant_wide(pd4j_class *class, uint16_t idx, pd4j_class_constant_tag tag, uint64_t *value) {
+	if (idx == 0 || idx + 1 >= class->numConstants) {
 		return false;
 	}
 	
-	pd4j_class_constant constant = class->constantPool[idx - 1];
-	pd4j_class_constant constant2 = class->constantPool[idx];
+	pd4j_class_constant *constant = &class->constantPool[idx - 1];
+	pd4j_class_constant *constant2 = &class->constantPool[idx];
 	
-	if (constant.tag != pd4j_CONSTANT_LONG) {
+	if (constant->tag != tag) {
 		return false;
 	}
-	if (constant2.tag != pd4j_CONSTANT_NONE) {
+	if (constant2->tag != pd4j_CONSTANT_NONE) {
 		return false;
 	}
 	
-	if (value != NULL) {
-		uint32_t *rawValue = (uint32_t *)value;
+	*value = ((uint64_t)constant->data.raw << 32) | constant2->data.raw;
+	return true;
+}
+
+bool pd4j_class_constant_long(pd4j_class *class, uint16_t idx, int64_t *value) {
+	uint64_t bits;
 	
-		rawValue[0] = constant2.data.raw;
-		rawValue[1] = constant.data.raw;
+	if (!pd4j_class_constant_wide(class, idx, pd4j_CONSTANT_LONG, &bits)) {
+		return false;
+	}
+	
+	if (value != NULL) {
+		*value = (int64_t)bits;
 	}
 	return true;
 }
 
 bool pd4j_class_constant_double(pd4j_class *class, uint16_t idx, double *value) {
-	if (idx > class->numConstants) {
+	uint64_t bits;
+	
+	if (!pd4j_class_constant_wide(class, idx, pd4j_CONSTANT_DOUBLE, &bits)) {
 		return false;
 	}
 	
-	pd4j_class_constant constant = class->constantPool[idx - 1];
-	pd4j_class_constant constant2 = class->constantPool[idx];
-	
-	if (constant.tag != pd4j_CONSTANT_DOUBLE) {
-		return false;
+	if (value != NULL) {
+		memcpy(value, &bits, sizeof(double));
 	}
-	if (constant2.tag != pd4j_CONSTANT_NONE) {
-		return false;
+	return true;
+}
+
+int32_t pd4j_class_line_number(pd4j_class_attribute *codeAttribute, uint32_t pcOffset) {
+	pd4j_class_line_number_table_entry *table = codeAttribute->parsedData.code.lineNumberTable;
+	uint16_t length = codeAttribute->parsedData.code.lineNumberTableLength;
+	
+	if (length == 0 || pcOffset < table[0].startPcIndex) {
+		return -1;
 	}
 	
-	if (value != NULL) {
-		uint32_t *rawValue = (uint32_t *)value;
+	// the last entry starting at or before the offset
+	uint16_t low = 0;
+	uint16_t high = length - 1;
 	
-		rawValue[0] = constant2.data.raw;
-		rawValue[1] = constant.data.raw;
+	while (low < high) {
+		uint16_t mid = (uint16_t)((low + high + 1) / 2);
+		
+		if (table[mid].startPcIndex <= pcOffset) {
+			low = mid;
+		}
+		else {
+			high = mid - 1;
+		}
 	}
-	return true;
+	
+	return table[low].lineNumber;
 }
 
 bool pd4j_class_is_subclass(pd4j_class_reference *subClass, pd4j_class_reference *superClass) {
@@ -347,6 +408,57 @@ bool pd4j_class_is_subclass(pd4j_class_reference *subClass, pd4j_class_reference
 	return true;
 }
 
+static bool pd4j_class_build_superclasses(pd4j_class_reference *classRef) {
+	if (classRef->superclasses != NULL) {
+		return true;
+	}
+	
+	pd4j_class_reference *superRef = NULL;
+	uint16_t depth = 0;
+	
+	if (classRef->data.class->superClass != NULL) {
+		superRef = pd4j_class_loader_get_loaded(classRef->definingLoader, classRef->data.class->superClass);
+	}
+	
+	if (superRef != NULL && superRef->type == pd4j_CLASS_CLASS) {
+		if (!pd4j_class_build_superclasses(superRef)) {
+			return false;
+		}
+		
+		depth = superRef->superDepth + 1;
+	}
+	
+	classRef->superclasses = pd4j_malloc((depth + 1) * sizeof(pd4j_class_reference *));
+	if (classRef->superclasses == NULL) {
+		return false;
+	}
+	
+	if (depth > 0) {
+		memcpy(classRef->superclasses, superRef->superclasses, depth * sizeof(pd4j_class_reference *));
+	}
+	
+	classRef->superclasses[depth] = classRef;
+	classRef->superDepth = depth;
+	
+	return true;
+}
+
+bool pd4j_class_extends(pd4j_class_reference *subClass, pd4j_class_reference *superClass) {
+	if (subClass == superClass) {
+		return true;
+	}
+	else if (subClass->type != pd4j_CLASS_CLASS || superClass->type != pd4j_CLASS_CLASS) {
+		return false;
+	}
+	
+	// a class's superclass is always found at the same depth in the superclasses of its subclasses
+	if (pd4j_class_build_superclasses(subClass) && pd4j_class_build_superclasses(superClass)) {
+		return superClass->superDepth < subClass->superDepth && subClass->superclasses[superClass->superDepth] == superClass;
+	}
+	
+	return pd4j_class_is_subclass(subClass, superClass);
+}
+
 bool pd4j_class_can_cast(pd4j_class_reference *class1, pd4j_class_reference *class2) {
 	if (strcmp((const char *)(class1->data.class->thisClass), (const char *)(class2->data.class->thisClass)) == 0) {
 		return true;
@@ -525,12 +637,17 @@ pd4j_thread_reference *pd4j_class_get_resolved_class_reference(pd4j_class_refere
 		}
 	}
 	
+	// every resolving class shares the same run-time reference (and static fields)
+	if (classRef->mirror != NULL) {
+		pd4j_free(thRef, sizeof(pd4j_thread_reference));
+		return classRef->mirror;
+	}
+	
 	thRef->kind = pd4j_REF_CLASS;
 	thRef->data.class.name = className;
 	thRef->data.class.loaded = classRef;
 	thRef->data.class.staticFields = NULL;
-	thRef->monitor.owner = NULL;
-	thRef->monitor.entryCount = 0;
+	thRef->lockWord = 0;
 	thRef->resolved = true;
 	
 	thRef->data.class.numConstants = classRef->data.class->numConstants;
@@ -557,7 +674,11 @@ pd4j_thread_reference *pd4j_class_get_resolved_class_reference(pd4j_class_refere
 	resolved->isClassName = true;
 	resolved->data.className = className;
 	
+	// set before initialization so that the class initialization method can link against it
+	classRef->mirror = thRef;
+	
 	if (!pd4j_thread_initialize_class(thread, thRef)) {
+		classRef->mirror = NULL;
 		pd4j_free(thRef, sizeof(pd4j_thread_reference));
 		return NULL;
 	}
@@ -617,8 +738,8 @@ pd4j_thread_reference *pd4j_class_get_resolved_string_reference(pd4j_class_refer
 	arrRef->data.instance.numInstanceFields = chars->size;
 	arrRef->data.instance.instanceFields = stringData;
 	arrRef->data.instance.class = arrayOfChars;
-	arrRef->monitor.owner = NULL;
-	arrRef->monitor.entryCount = 0;
+	arrRef->data.instance.backtrace = NULL;
+	arrRef->lockWord = 0;
 	arrRef->resolved = true;
 	
 	pd4j_thread_reference *stringClass = pd4j_class_get_resolved_class_reference(ref, thread, (uint8_t *)"Ljava/lang/String;");
@@ -632,8 +753,9 @@ pd4j_thread_reference *pd4j_class_get_resolved_string_reference(pd4j_class_refer
 	initRef.data.method.name = (uint8_t *)"<init>";
 	initRef.data.method.descriptor = (uint8_t *)"([C)V";
 	initRef.data.method.class = stringClass;
-	initRef.monitor.owner = NULL;
-	initRef.monitor.entryCount = 0;
+	initRef.data.method.declaringClass = NULL;
+	initRef.data.method.property = NULL;
+	initRef.lockWord = 0;
 	
 	pd4j_thread_stack_entry stackEntry;
 	stackEntry.tag = pd4j_VARIABLE_REFERENCE;
@@ -653,20 +775,20 @@ pd4j_thread_reference *pd4j_class_get_resolved_string_reference(pd4j_class_refer
 	internMethodRef.data.method.name = (uint8_t *)"intern";
 	internMethodRef.data.method.descriptor = (uint8_t *)"()Ljava/lang/String;";
 	internMethodRef.data.method.class = stringClass;
-	internMethodRef.monitor.owner = NULL;
-	internMethodRef.monitor.entryCount = 0;
+	internMethodRef.data.method.declaringClass = NULL;
+	internMethodRef.data.method.property = NULL;
+	internMethodRef.lockWord = 0;
 	
 	pd4j_thread_invoke_instance_method(thread, thRef, &internMethodRef);
 	
-	pd4j_thread_stack_entry *internedRef = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry internedRef;
+	pd4j_thread_arg_pop(thread, &internedRef);
 	
-	if (internedRef->data.referenceValue != thRef) {
+	if (internedRef.data.referenceValue != thRef) {
 		pd4j_thread_reference_destroy(thRef);
-		thRef = internedRef->data.referenceValue;
+		thRef = internedRef.data.referenceValue;
 	}
 	
-	pd4j_free(internedRef, sizeof(pd4j_thread_stack_entry));
-	
 	return thRef;
 }
 
@@ -709,6 +831,14 @@ pd4j_thread_reference *pd4j_class_get_primitive_class_reference(uint8_t type) {
 	return thRef;
 }
 
+pd4j_thread_reference *pd4j_class_get_mirror(pd4j_class_reference *ref, pd4j_thread *thread) {
+	if (ref->mirror == NULL) {
+		pd4j_class_get_resolved_class_reference(ref, thread, ref->name);
+	}
+	
+	return ref->mirror;
+}
+
 void pd4j_class_destroy_constants(pd4j_class *class, uint16_t upTo) {
 	for (uint16_t i = 0; i < upTo; i++) {
 		pd4j_class_constant *constant = &class->constantPool[i];
@@ -742,6 +872,13 @@ void pd4j_class_destroy_fields(pd4j_class *class, uint16_t upTo) {
 void pd4j_class_destroy_methods(pd4j_class *class, uint16_t upTo) {
 	for (uint16_t i = 0; i < upTo; i++) {
 		pd4j_class_property *method = &class->methods[i];
+		if (method->link != NULL) {
+			pd4j_link_method_destroy(method->link);
+		}
+		if (method->parsedDescriptor != NULL) {
+			pd4j_descriptor_destroy_method_descriptor(method->parsedDescriptor);
+		}
+		
 		for (uint16_t j = 0; j < method->numAttributes; j++) {
 			if (strcmp((const char *)(method->attributes[j].name), "Code") == 0 && method->attributes[j].parsedData.code.exceptionTableLength > 0) {
 				pd4j_free(method->attributes[j].parsedData.code.exceptionTable, method->attributes[j].parsedData.code.exceptionTableLength * sizeof(pd4j_class_exception_table_entry));
@@ -860,5 +997,9 @@ void pd4j_class_reference_destroy(pd4j_class_reference *ref) {
 		pd4j_free(ref->constant2Reference, sizeof(pd4j_list));
 	}
 	
+	if (ref->superclasses != NULL) {
+		pd4j_free(ref->superclasses, (ref->superDepth + 1) * sizeof(pd4j_class_reference *));
+	}
+	
 	pd4j_free(ref, sizeof(pd4j_class_reference));
 }
\ No newline at end of file
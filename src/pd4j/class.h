@@ -106,6 +106,7 @@ typedef struct {
 	uint8_t *startPc;
 	uint8_t *endPc;
 	uint8_t *handlerPc;
+	// NULL for handlers that catch everything
 	uint8_t *catchType;
 } pd4j_class_exception_table_entry;
 
@@ -137,6 +138,7 @@ typedef struct {
 } pd4j_class_record_component_entry;
 
 typedef struct pd4j_module pd4j_module;
+typedef struct pd4j_link_method pd4j_link_method;
 
 struct pd4j_class_attribute {
 	uint8_t *name;
@@ -156,6 +158,10 @@ struct pd4j_class_attribute {
 			
 			uint16_t lineNumberTableLength;
 			pd4j_class_line_number_table_entry *lineNumberTable;
+			
+			// raw StackMapTable attribute data, decoded when the method is verified
+			uint32_t stackMapTableLength;
+			uint8_t *stackMapTable;
 		} code;
 		struct {
 			uint16_t numBootstrapMethods;
@@ -190,6 +196,23 @@ struct pd4j_class_attribute {
 	} parsedData;
 };
 
+typedef struct {
+	// the first character of the type's descriptor, '[' for arrays and 'L' for classes
+	uint8_t kind;
+	// where the type starts in the method's descriptor, for reading the class name of references
+	uint16_t offset;
+} pd4j_class_method_descriptor_type;
+
+// a method descriptor parsed once and shared by every reference to the method
+typedef struct {
+	uint16_t numArgs;
+	// slots taken by the arguments, not counting the receiver
+	uint16_t numArgSlots;
+	// the return type, with 'V' as its kind for void methods
+	pd4j_class_method_descriptor_type returnType;
+	pd4j_class_method_descriptor_type args[];
+} pd4j_class_method_descriptor;
+
 typedef struct {
 	pd4j_class_property_access_flags accessFlags;
 	
@@ -201,6 +224,13 @@ typedef struct {
 	
 	bool synthetic;
 	uint8_t *signature;
+	
+	// run-time data for methods, created the first time the method is invoked
+	pd4j_link_method *link;
+	// the parsed descriptor of a method, created the first time it's needed
+	pd4j_class_method_descriptor *parsedDescriptor;
+	// set for methods once a loaded class overrides them
+	bool overridden;
 } pd4j_class_property;
 
 typedef struct {
@@ -270,6 +300,11 @@ struct pd4j_class_reference {
 	} data;
 	// components should be pd4j_class_resolved_reference *
 	pd4j_list *constant2Reference;
+	// canonical run-time reference to this class, shared by all linked methods
+	struct pd4j_thread_reference *mirror;
+	// the class and its superclasses from the root down, built the first time pd4j_class_extends needs it
+	uint16_t superDepth;
+	struct pd4j_class_reference **superclasses;
 };
 
 typedef struct pd4j_thread_reference pd4j_thread_reference;
@@ -290,6 +325,11 @@ typedef struct pd4j_thread pd4j_thread;
 
 pd4j_class_attribute *pd4j_class_attribute_name(pd4j_class *class, const uint8_t *name);
 pd4j_class_attribute *pd4j_class_property_attribute_name(pd4j_class_property *property, const uint8_t *name);
+// throws ClassFormatError if the method's descriptor is malformed
+pd4j_class_method_descriptor *pd4j_class_property_method_descriptor(pd4j_class_property *method, pd4j_thread *thread);
+
+// the source line of the instruction at pcOffset in a Code attribute, or -1 if it has no line number table
+int32_t pd4j_class_line_number(pd4j_class_attribute *codeAttribute, uint32_t pcOffset);
 
 bool pd4j_class_constant_utf8(pd4j_class *class, uint16_t idx, uint8_t **value);
 bool pd4j_class_constant_int(pd4j_class *class, uint16_t idx, int32_t *value);
@@ -298,6 +338,8 @@ bool pd4j_class_constant_long(pd4j_class *class, uint16_t idx, int64_t *value);
 bool pd4j_class_constant_double(pd4j_class *class, uint16_t idx, double *value);
 
 bool pd4j_class_is_subclass(pd4j_class_reference *subClass, pd4j_class_reference *superClass);
+// whether subClass is superClass or extends it, checked in constant time once both classes have been checked before
+bool pd4j_class_extends(pd4j_class_reference *subClass, pd4j_class_reference *superClass);
 bool pd4j_class_can_cast(pd4j_class_reference *class1, pd4j_class_reference *class2);
 bool pd4j_class_same_package(pd4j_class_reference *class1, pd4j_class_reference *class2);
 
@@ -311,6 +353,7 @@ pd4j_thread_reference *pd4j_class_get_resolved_class_reference(pd4j_class_refere
 pd4j_thread_reference *pd4j_class_get_resolved_string_reference(pd4j_class_reference *ref, pd4j_thread *thread, uint8_t *stringValue);
 
 pd4j_thread_reference *pd4j_class_get_primitive_class_reference(uint8_t type);
+pd4j_thread_reference *pd4j_class_get_mirror(pd4j_class_reference *ref, pd4j_thread *thread);
 
 void pd4j_class_destroy_constants(pd4j_class *class, uint16_t upTo);
 void pd4j_class_destroy_fields(pd4j_class *class, uint16_t upTo);
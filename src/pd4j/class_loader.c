@@ -7,6 +7,7 @@
 #include "class.h"
 #include "class_loader.h"
 #include "file.h"
+#include "link.h"
 #include "list.h"
 #include "memory.h"
 #include "module.h"
@@ -33,6 +34,7 @@ struct pd4j_class_loader {
 	// components should be pd4j_class_reference *
 	pd4j_list *loadedClasses;
 	struct pd4j_class_loader *parent;
+	pd4j_thread_implicit_pool *implicitPool;
 };
 
 static pd4j_class_loader *bootClassLoader = NULL;
@@ -59,6 +61,7 @@ pd4j_class_loader *pd4j_class_loader_new(pd4j_class_loader *parent) {
 		ret->loadedClasses = pd4j_list_new(4);
 		
 		ret->parent = parent;
+		ret->implicitPool = NULL;
 	}
 	
 	return ret;
@@ -269,17 +272,17 @@ static bool pd4j_class_loader_read_constants(pd4j_class_loader *loader, pd4j_cla
 			case pd4j_CONSTANT_DOUBLE: {
 				// "In retrospect, making 8-byte constants take two constant pool entries was a poor choice." -Oracle
 				
+				// the high word goes in the constant's own entry and the low word in the unusable one after it
 				if (!pd4j_class_loader_read32(loader, &constant->data.raw)) {
 					pd4j_class_destroy_constants(class, i);
 					return false;
 				}
-				constant->data.raw = REVERSE32(constant->data.raw);
 				
 				if (!pd4j_class_loader_read32(loader, &class->constantPool[i + 1].data.raw)) {
 					pd4j_class_destroy_constants(class, i);
 					return false;
 				}
-				class->constantPool[i].data.raw = REVERSE32(class->constantPool[i + 1].data.raw);
+				class->constantPool[i + 1].tag = pd4j_CONSTANT_NONE;
 				
 				i += 2;
 				break;
@@ -477,6 +480,8 @@ static bool pd4j_class_loader_read_fields(pd4j_class_loader *loader, pd4j_class
 		pd4j_class_property *field = &class->fields[i];
 		field->numAttributes = 0;
 		field->synthetic = false;
+		field->link = NULL;
+		field->overridden = false;
 		
 		if (!pd4j_class_loader_read16(loader, &accessFlags)) {
 			return false;
@@ -632,6 +637,9 @@ static bool pd4j_class_loader_read_methods(pd4j_class_loader *loader, pd4j_class
 		pd4j_class_property *method = &class->methods[i];
 		method->numAttributes = 0;
 		method->synthetic = false;
+		method->link = NULL;
+		method->parsedDescriptor = NULL;
+		method->overridden = false;
 		
 		if (!pd4j_class_loader_read16(loader, &accessFlags)) {
 			return false;
@@ -722,6 +730,8 @@ static bool pd4j_class_loader_read_methods(pd4j_class_loader *loader, pd4j_class
 				attr->parsedData.code.exceptionTable = pd4j_malloc(attr->parsedData.code.exceptionTableLength * sizeof(pd4j_class_exception_table_entry));
 				attr->parsedData.code.lineNumberTableLength = 0;
 				attr->parsedData.code.lineNumberTable = NULL;
+				attr->parsedData.code.stackMapTableLength = 0;
+				attr->parsedData.code.stackMapTable = NULL;
 				
 				if (attr->parsedData.code.exceptionTable == NULL) {
 					strncpy(loader->err, "Unable to allocate class file method exception table: Out of memory", 511);
@@ -747,6 +757,12 @@ static bool pd4j_class_loader_read_methods(pd4j_class_loader *loader, pd4j_class
 					tmp = *(data16++);
 					tmp = REVERSE16(tmp);
 					
+					// handlers with no catch type catch everything, like those of finally blocks
+					if (tmp == 0) {
+						entry->catchType = NULL;
+						continue;
+					}
+					
 					if (tmp > class->numConstants) {
 						strncpy(loader->err, "Malformed class file: Method exception table catch type is not a valid constant", 511);
 						loader->hasErr = true;
@@ -785,34 +801,47 @@ static bool pd4j_class_loader_read_methods(pd4j_class_loader *loader, pd4j_class
 						return false;
 					}
 					
+					tmp = *(data16++);
+					uint32_t attrLength = REVERSE16(tmp);
+					tmp = *(data16++);
+					attrLength = (attrLength << 16) | REVERSE16(tmp);
+					
+					uint8_t *attrData = (uint8_t *)data16;
+					
+					if (attrLength > (uint32_t)(&attr->data[attr->dataLength] - attrData)) {
+						strncpy(loader->err, "Malformed class file: Method code attribute runs past the end of the Code attribute", 511);
+						loader->hasErr = true;
+						pd4j_class_destroy_methods(class, i + 1);
+						return false;
+					}
+					
 					if (strcmp((const char *)attrName, "LineNumberTable") == 0) {
-						data16 += 2;
-						
 						tmp = *(data16++);
 						attr->parsedData.code.lineNumberTableLength = REVERSE16(tmp);
-						attr->parsedData.code.lineNumberTable = (pd4j_class_line_number_table_entry *)(data16++);
+						attr->parsedData.code.lineNumberTable = (pd4j_class_line_number_table_entry *)data16;
 						
+						// kept sorted by PC so stack traces can look lines up by binary search
 						for (uint16_t l = 0; l < attr->parsedData.code.lineNumberTableLength; l++) {
-							attr->parsedData.code.lineNumberTable[l].startPcIndex = REVERSE16(attr->parsedData.code.lineNumberTable[l].startPcIndex);
-							attr->parsedData.code.lineNumberTable[l].lineNumber = REVERSE16(attr->parsedData.code.lineNumberTable[l].lineNumber);
+							pd4j_class_line_number_table_entry entry = attr->parsedData.code.lineNumberTable[l];
+							uint16_t m = l;
+							
+							entry.startPcIndex = REVERSE16(entry.startPcIndex);
+							entry.lineNumber = REVERSE16(entry.lineNumber);
+							
+							for (; m > 0 && attr->parsedData.code.lineNumberTable[m - 1].startPcIndex > entry.startPcIndex; m--) {
+								attr->parsedData.code.lineNumberTable[m] = attr->parsedData.code.lineNumberTable[m - 1];
+							}
+							
+							attr->parsedData.code.lineNumberTable[m] = entry;
 						}
-						
-						data16 += (attr->parsedData.code.lineNumberTableLength * sizeof(pd4j_class_line_number_table_entry)) >> 1;
-						break;
 					}
-					else {
-						tmp = *(data16++);
-						uint32_t attrLength = REVERSE16(tmp);
-						tmp = *(data16++);
-						attrLength = (attrLength << 16) | REVERSE16(tmp);
-						
-						uint8_t data[attrLength];
-						
-						if (pd4j_class_loader_read(loader, data, attrLength) < attrLength) {
-							pd4j_class_destroy_methods(class, i + 1);
-							return false;
-						}
+					else if (strcmp((const char *)attrName, "StackMapTable") == 0) {
+						attr->parsedData.code.stackMapTableLength = attrLength;
+						attr->parsedData.code.stackMapTable = attrData;
 					}
+					
+					// the other attributes are already in memory with the rest of the Code attribute, so they only need skipping
+					data16 = (uint16_t *)(attrData + attrLength);
 				}
 			}
 			else if (strcmp((const char *)(attr->name), "Exceptions") == 0) {
@@ -2098,6 +2127,10 @@ pd4j_class_reference *pd4j_class_loader_load(pd4j_class_loader *loader, pd4j_thr
 		newRef->type = pd4j_CLASS_ARRAY;
 		newRef->data.array.baseType = ref;
 		newRef->data.array.dimensions = arrayDimensions;
+		newRef->constant2Reference = NULL;
+		newRef->mirror = NULL;
+		newRef->superDepth = 0;
+		newRef->superclasses = NULL;
 		
 		pd4j_list_add(loader->loadedClasses, newRef);
 		return newRef;
@@ -2167,6 +2200,9 @@ pd4j_class_reference *pd4j_class_loader_load(pd4j_class_loader *loader, pd4j_thr
 	ref->type = pd4j_CLASS_CLASS;
 	ref->data.class = class;
 	ref->constant2Reference = NULL;
+	ref->mirror = NULL;
+	ref->superDepth = 0;
+	ref->superclasses = NULL;
 	
 	class->numConstants = 0;
 	class->numFields = 0;
@@ -2351,6 +2387,8 @@ pd4j_class_reference *pd4j_class_loader_load(pd4j_class_loader *loader, pd4j_thr
 	pd4j_list_pop(loader->loadingClasses);
 	pd4j_list_add(loader->loadedClasses, ref);
 	
+	pd4j_link_class_loaded(ref);
+	
 	return ref;
 }
 
@@ -2362,9 +2400,21 @@ void pd4j_class_loader_destroy(pd4j_class_loader *loader) {
 	pd4j_list_destroy(loader->loadedClasses);
 	pd4j_list_destroy(loader->loadingClasses);
 	
+	if (loader->implicitPool != NULL) {
+		pd4j_thread_implicit_pool_destroy(loader->implicitPool);
+	}
+	
 	if (loader->fh != NULL) {
 		pd4j_file_close(loader->fh);
 	}
 	
 	pd4j_free(loader, sizeof(pd4j_class_loader));
+}
+
+pd4j_thread_implicit_pool *pd4j_class_loader_get_implicit_pool(pd4j_class_loader *loader) {
+	return loader->implicitPool;
+}
+
+void pd4j_class_loader_set_implicit_pool(pd4j_class_loader *loader, pd4j_thread_implicit_pool *pool) {
+	loader->implicitPool = pool;
 }
\ No newline at end of file
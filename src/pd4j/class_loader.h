@@ -19,4 +19,8 @@ void pd4j_class_loader_destroy(pd4j_class_loader *loader);
 pd4j_class_reference *pd4j_class_loader_get_loaded(pd4j_class_loader *loader, uint8_t *className);
 pd4j_class_reference *pd4j_class_loader_load(pd4j_class_loader *loader, pd4j_thread *thread, uint8_t *className);
 
+// the implicit exceptions made for classes from this loader, or NULL if they haven't been; the loader destroys them with itself
+pd4j_thread_implicit_pool *pd4j_class_loader_get_implicit_pool(pd4j_class_loader *loader);
+void pd4j_class_loader_set_implicit_pool(pd4j_class_loader *loader, pd4j_thread_implicit_pool *pool);
+
 #endif
\ No newline at end of file
@@ -129,8 +129,7 @@ bool pd4j_descriptor_parse_class(uint8_t *descriptor, pd4j_class_reference *load
 	thVar->resolved = true;
 	thVar->kind = pd4j_REF_CLASS;
 	thVar->data = classRef->data;
-	thVar->monitor.owner = NULL;
-	thVar->monitor.entryCount = 0;
+	thVar->lockWord = 0;
 	
 	pd4j_free(newDescriptor, newDescriptorLen);
 	
@@ -266,3 +265,85 @@ bool pd4j_descriptor_parse_method(uint8_t *descriptor, pd4j_class_reference *loa
 	
 	return true;
 }
+
+// returns the end of the field type at the start of descriptor, or NULL if there isn't one
+static uint8_t *pd4j_descriptor_skip_type(uint8_t *descriptor) {
+	uint8_t *end = descriptor;
+	
+	while (*end == '[') {
+		end++;
+	}
+	
+	switch (*end) {
+		case 'B':
+		case 'C':
+		case 'D':
+		case 'F':
+		case 'I':
+		case 'J':
+		case 'S':
+		case 'Z':
+			return end + 1;
+		case 'L': {
+			uint8_t *nameEnd = (uint8_t *)strchr((char *)end, ';');
+			return (nameEnd == NULL || nameEnd == end + 1) ? NULL : nameEnd + 1;
+		}
+		default:
+			return NULL;
+	}
+}
+
+pd4j_class_method_descriptor *pd4j_descriptor_parse_method_descriptor(uint8_t *descriptor, pd4j_thread *thread) {
+	uint16_t numArgs = 0;
+	uint8_t *buf = descriptor + 1;
+	
+	if (descriptor[0] != '(') {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: Method descriptor doesn't start with an argument list");
+		return NULL;
+	}
+	
+	while (*buf != ')') {
+		buf = pd4j_descriptor_skip_type(buf);
+		
+		if (buf == NULL || numArgs == 255) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: Invalid argument type in method descriptor");
+			return NULL;
+		}
+		
+		numArgs++;
+	}
+	
+	uint8_t *returnEnd = (buf[1] == 'V') ? buf + 2 : pd4j_descriptor_skip_type(buf + 1);
+	
+	if (returnEnd == NULL || *returnEnd != '\0') {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: Invalid return type in method descriptor");
+		return NULL;
+	}
+	
+	pd4j_class_method_descriptor *parsed = pd4j_malloc(sizeof(pd4j_class_method_descriptor) + numArgs * sizeof(pd4j_class_method_descriptor_type));
+	if (parsed == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate parsed method descriptor: Out of memory");
+		return NULL;
+	}
+	
+	parsed->numArgs = numArgs;
+	parsed->numArgSlots = 0;
+	parsed->returnType.kind = buf[1];
+	parsed->returnType.offset = (uint16_t)(buf + 1 - descriptor);
+	
+	buf = descriptor + 1;
+	
+	for (uint16_t i = 0; i < numArgs; i++) {
+		parsed->args[i].kind = *buf;
+		parsed->args[i].offset = (uint16_t)(buf - descriptor);
+		parsed->numArgSlots += (*buf == 'J' || *buf == 'D') ? 2 : 1;
+		
+		buf = pd4j_descriptor_skip_type(buf);
+	}
+	
+	return parsed;
+}
+
+void pd4j_descriptor_destroy_method_descriptor(pd4j_class_method_descriptor *parsed) {
+	pd4j_free(parsed, sizeof(pd4j_class_method_descriptor) + parsed->numArgs * sizeof(pd4j_class_method_descriptor_type));
+}
@@ -14,4 +14,8 @@ size_t pd4j_descriptor_from_method_reference(uint8_t **descriptor, pd4j_thread_r
 bool pd4j_descriptor_parse_class(uint8_t *descriptor, pd4j_class_reference *loadingClass, pd4j_thread *thread, pd4j_thread_reference *thVar);
 bool pd4j_descriptor_parse_method(uint8_t *descriptor, pd4j_class_reference *loadingClass, pd4j_thread *thread, pd4j_thread_reference *thVar);
 
+// parses a method descriptor without resolving any of the classes it names, throwing ClassFormatError if it's malformed
+pd4j_class_method_descriptor *pd4j_descriptor_parse_method_descriptor(uint8_t *descriptor, pd4j_thread *thread);
+void pd4j_descriptor_destroy_method_descriptor(pd4j_class_method_descriptor *parsed);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,2140 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api_ptr.h"
+#include "class.h"
+#include "class_loader.h"
+#include "descriptor.h"
+#include "link.h"
+#include "list.h"
+#include "memory.h"
+#include "resolve.h"
+#include "superinstructions.h"
+#include "thread.h"
+#include "verify.h"
+
+// size of the global cache used by megamorphic call sites (must be a power of two)
+#define PD4J_LINK_MEGAMORPHIC_CACHE_SIZE 256
+
+static const uint8_t pd4j_link_opcode_lengths[256] = {
+	// 0x00 - 0x0f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x10 - 0x1f
+	2, 3, 2, 3, 3, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1,
+	// 0x20 - 0x2f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x30 - 0x3f
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1,
+	// 0x40 - 0x4f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x50 - 0x5f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x60 - 0x6f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x70 - 0x7f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x80 - 0x8f
+	1, 1, 1, 1, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	// 0x90 - 0x9f
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3, 3, 3, 3, 3,
+	// 0xa0 - 0xaf
+	3, 3, 3, 3, 3, 3, 3, 3, 3, 2, 0, 0, 1, 1, 1, 1,
+	// 0xb0 - 0xbf
+	1, 1, 3, 3, 3, 3, 3, 3, 3, 5, 5, 3, 2, 3, 1, 1,
+	// 0xc0 - 0xcf
+	3, 3, 1, 1, 0, 4, 3, 3, 5, 5, 0, 3, 3, 3, 5, 3,
+	// 0xd0 - 0xdf (superinstructions take the length of their first instruction, so linked code can still be walked)
+	1, 2, 2, 2, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0,
+	// 0xe0 - 0xef
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	// 0xf0 - 0xff
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const char *pd4j_link_call_site_state_names[] = {
+	"unresolved",
+	"uninitialized",
+	"monomorphic",
+	"polymorphic",
+	"megamorphic",
+	"bound",
+	"devirtualized"
+};
+
+typedef struct {
+	pd4j_class_reference *receiverClass;
+	pd4j_class_property *resolvedMethod;
+	pd4j_link_method *target;
+} pd4j_link_megamorphic_entry;
+
+static pd4j_link_megamorphic_entry megamorphicCache[PD4J_LINK_MEGAMORPHIC_CACHE_SIZE];
+
+// a call site bound on the assumption that its target is not overridden
+typedef struct {
+	pd4j_class_property *target;
+	pd4j_link_method *caller;
+	pd4j_link_call_site *site;
+} pd4j_link_dependency;
+
+// components should be pd4j_link_dependency *
+static pd4j_list *dependencies = NULL;
+
+static int32_t pd4j_link_read32(uint8_t *ptr) {
+	return (int32_t)(((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | (uint32_t)ptr[3]);
+}
+
+uint32_t pd4j_link_instruction_length(uint8_t *code, uint32_t offset) {
+	uint8_t opcode = code[offset];
+	
+	switch (opcode) {
+		case 0xaa:
+		case pd4j_OPCODE_TABLESWITCH_QUICK: {
+			// tableswitch (operands are aligned to a multiple of 4 bytes from the start of the code)
+			uint32_t operands = (offset + 4) & ~(uint32_t)3;
+			int32_t lowValue = pd4j_link_read32(&code[operands + 4]);
+			int32_t highValue = pd4j_link_read32(&code[operands + 8]);
+			
+			if (highValue < lowValue) {
+				return 0;
+			}
+			
+			return operands + 12 + 4 * (uint32_t)(highValue - lowValue + 1) - offset;
+		}
+		case 0xab:
+		case pd4j_OPCODE_LOOKUPSWITCH_QUICK: {
+			// lookupswitch
+			uint32_t operands = (offset + 4) & ~(uint32_t)3;
+			int32_t numPairs = pd4j_link_read32(&code[operands + 4]);
+			
+			if (numPairs < 0) {
+				return 0;
+			}
+			
+			return operands + 8 + 8 * (uint32_t)numPairs - offset;
+		}
+		case 0xc4: {
+			// wide
+			return (code[offset + 1] == 0x84) ? 6 : 4;
+		}
+		default:
+			return pd4j_link_opcode_lengths[opcode];
+	}
+}
+
+static pd4j_class_property *pd4j_link_find_method(pd4j_class *class, uint8_t *name, uint8_t *descriptor) {
+	for (uint16_t i = 0; i < class->numMethods; i++) {
+		if (strcmp((const char *)name, (const char *)(class->methods[i].name)) == 0 && strcmp((const char *)descriptor, (const char *)(class->methods[i].descriptor)) == 0) {
+			return &class->methods[i];
+		}
+	}
+	
+	return NULL;
+}
+
+static pd4j_class_reference *pd4j_link_superclass(pd4j_class_reference *classRef) {
+	if (classRef->type != pd4j_CLASS_CLASS || classRef->data.class->superClass == NULL) {
+		return NULL;
+	}
+	
+	return pd4j_class_loader_get_loaded(classRef->definingLoader, classRef->data.class->superClass);
+}
+
+// state of the peephole optimizer over one method's linked code
+typedef struct {
+	uint8_t *code;
+	uint32_t codeLength;
+	pd4j_class_attribute *codeAttribute;
+	
+	// offsets of the instructions before any were rewritten
+	uint32_t numInstructions;
+	uint32_t *starts;
+	
+	// offsets that can be jumped to, which have to stay at the start of an instruction
+	bool *isTarget;
+	
+	uint32_t removed;
+	uint32_t threaded;
+} pd4j_link_peephole;
+
+static inline int16_t pd4j_link_read16(uint8_t *ptr) {
+	return (int16_t)((ptr[0] << 8) | ptr[1]);
+}
+
+static inline void pd4j_link_write16(uint8_t *ptr, int32_t value) {
+	ptr[0] = (uint8_t)((uint32_t)value >> 8);
+	ptr[1] = (uint8_t)value;
+}
+
+static inline uint32_t pd4j_link_peephole_end(pd4j_link_peephole *peephole, uint32_t i) {
+	return (i + 1 < peephole->numInstructions) ? peephole->starts[i + 1] : peephole->codeLength;
+}
+
+// whether the count instructions from i on exist and can only be entered at the first one
+static bool pd4j_link_peephole_adjacent(pd4j_link_peephole *peephole, uint32_t i, uint32_t count) {
+	if (i + count > peephole->numInstructions) {
+		return false;
+	}
+	
+	for (uint32_t k = 1; k < count; k++) {
+		if (peephole->isTarget[peephole->starts[i + k]]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// whether an offset is inside the code and at the start of an instruction
+static bool pd4j_link_peephole_is_start(pd4j_link_peephole *peephole, int64_t offset) {
+	if (offset < 0 || offset >= peephole->codeLength) {
+		return false;
+	}
+	
+	uint32_t low = 0;
+	uint32_t high = peephole->numInstructions;
+	
+	while (low < high) {
+		uint32_t mid = low + (high - low) / 2;
+		
+		if (peephole->starts[mid] < offset) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	
+	return low < peephole->numInstructions && peephole->starts[low] == offset;
+}
+
+static void pd4j_link_peephole_mark(pd4j_link_peephole *peephole, int64_t target) {
+	if (target >= 0 && target < peephole->codeLength) {
+		peephole->isTarget[target] = true;
+	}
+}
+
+// finds every instruction and jump target, returning false for code with subroutines, which is left alone
+static bool pd4j_link_peephole_scan(pd4j_link_peephole *peephole) {
+	uint8_t *code = peephole->code;
+	uint32_t count = 0;
+	
+	for (uint32_t offset = 0; offset < peephole->codeLength; offset += pd4j_link_instruction_length(code, offset)) {
+		uint8_t opcode = code[offset];
+		
+		if (opcode == 0xa8 || opcode == 0xa9 || opcode == 0xc9 || (opcode == 0xc4 && code[offset + 1] == 0xa9)) {
+			return false;
+		}
+		
+		if (peephole->starts != NULL) {
+			peephole->starts[count] = offset;
+		}
+		count++;
+		
+		if (peephole->isTarget == NULL) {
+			continue;
+		}
+		
+		if ((opcode >= 0x99 && opcode <= 0xa7) || opcode == 0xc6 || opcode == 0xc7) {
+			pd4j_link_peephole_mark(peephole, (int64_t)offset + pd4j_link_read16(&code[offset + 1]));
+		}
+		else if (opcode == 0xc8) {
+			pd4j_link_peephole_mark(peephole, (int64_t)offset + pd4j_link_read32(&code[offset + 1]));
+		}
+		else if (opcode == 0xaa || opcode == 0xab) {
+			uint32_t operands = (offset + 4) & ~(uint32_t)3;
+			uint32_t end = offset + pd4j_link_instruction_length(code, offset);
+			
+			pd4j_link_peephole_mark(peephole, (int64_t)offset + pd4j_link_read32(&code[operands]));
+			
+			// tableswitch offsets follow the bounds, lookupswitch offsets follow each key
+			for (uint32_t entry = operands + 12; entry < end; entry += (opcode == 0xaa) ? 4 : 8) {
+				pd4j_link_peephole_mark(peephole, (int64_t)offset + pd4j_link_read32(&code[entry]));
+			}
+		}
+	}
+	
+	peephole->numInstructions = count;
+	
+	if (peephole->isTarget != NULL) {
+		pd4j_class_attribute *codeAttribute = peephole->codeAttribute;
+		
+		for (uint16_t i = 0; i < codeAttribute->parsedData.code.exceptionTableLength; i++) {
+			pd4j_class_exception_table_entry *entry = &codeAttribute->parsedData.code.exceptionTable[i];
+			
+			pd4j_link_peephole_mark(peephole, entry->startPc - codeAttribute->parsedData.code.code);
+			pd4j_link_peephole_mark(peephole, entry->endPc - codeAttribute->parsedData.code.code);
+			pd4j_link_peephole_mark(peephole, entry->handlerPc - codeAttribute->parsedData.code.code);
+		}
+	}
+	
+	return true;
+}
+
+static bool pd4j_link_literal(uint8_t *code, uint32_t offset, int32_t *value) {
+	uint8_t opcode = code[offset];
+	
+	if (opcode >= 0x02 && opcode <= 0x08) {
+		*value = (int32_t)opcode - 0x03;
+		return true;
+	}
+	else if (opcode == 0x10) {
+		*value = (int8_t)code[offset + 1];
+		return true;
+	}
+	else if (opcode == 0x11) {
+		*value = pd4j_link_read16(&code[offset + 1]);
+		return true;
+	}
+	
+	return false;
+}
+
+// writes a bipush or sipush of an int constant if one fits in length bytes, returning the bytes it took or 0
+static uint32_t pd4j_link_write_literal(uint8_t *code, uint32_t offset, uint32_t length, int32_t value) {
+	if (value >= INT8_MIN && value <= INT8_MAX && length >= 2) {
+		code[offset] = 0x10;
+		code[offset + 1] = (uint8_t)value;
+		return 2;
+	}
+	else if (value >= INT16_MIN && value <= INT16_MAX && length >= 3) {
+		code[offset] = 0x11;
+		pd4j_link_write16(&code[offset + 1], value);
+		return 3;
+	}
+	
+	return 0;
+}
+
+// fills length bytes with instructions that do nothing, jumping over them when there is room for a goto
+static void pd4j_link_write_skip(uint8_t *code, uint32_t offset, uint32_t length) {
+	if (length >= 3) {
+		code[offset] = 0xa7;
+		pd4j_link_write16(&code[offset + 1], (int32_t)length);
+		offset += 3;
+		length -= 3;
+	}
+	
+	memset(&code[offset], 0x00, length);
+}
+
+// decodes the load and store instructions (other than wide ones) into their type, one of "IJFDA", and local variable index
+static char pd4j_link_local_access(uint8_t *code, uint32_t offset, bool *isStore, uint16_t *idx) {
+	uint8_t opcode = code[offset];
+	
+	if (opcode >= 0x15 && opcode <= 0x19) {
+		*isStore = false;
+		*idx = code[offset + 1];
+		return "IJFDA"[opcode - 0x15];
+	}
+	else if (opcode >= 0x1a && opcode <= 0x2d) {
+		*isStore = false;
+		*idx = (opcode - 0x1a) % 4;
+		return "IJFDA"[(opcode - 0x1a) / 4];
+	}
+	else if (opcode >= 0x36 && opcode <= 0x3a) {
+		*isStore = true;
+		*idx = code[offset + 1];
+		return "IJFDA"[opcode - 0x36];
+	}
+	else if (opcode >= 0x3b && opcode <= 0x4e) {
+		*isStore = true;
+		*idx = (opcode - 0x3b) % 4;
+		return "IJFDA"[(opcode - 0x3b) / 4];
+	}
+	
+	return 0;
+}
+
+// the condition of if<cond> and if_icmp<cond>, numbered in opcode order
+static bool pd4j_link_int_condition(uint8_t condition, int32_t value1, int32_t value2) {
+	switch (condition) {
+		case 0: return value1 == value2;
+		case 1: return value1 != value2;
+		case 2: return value1 < value2;
+		case 3: return value1 >= value2;
+		case 4: return value1 > value2;
+		default: return value1 <= value2;
+	}
+}
+
+// points jumps to a goto at the goto's own target, and replaces gotos to a return with the return
+static void pd4j_link_peephole_thread(pd4j_link_peephole *peephole) {
+	uint8_t *code = peephole->code;
+	
+	for (uint32_t i = 0; i < peephole->numInstructions; i++) {
+		uint32_t offset = peephole->starts[i];
+		uint8_t opcode = code[offset];
+		
+		if (!((opcode >= 0x99 && opcode <= 0xa7) || opcode == 0xc6 || opcode == 0xc7)) {
+			continue;
+		}
+		
+		int64_t target = (int64_t)offset + pd4j_link_read16(&code[offset + 1]);
+		int64_t final = target;
+		
+		// a jump that doesn't land on an instruction is left for the interpreter to take as it is
+		if (!pd4j_link_peephole_is_start(peephole, target)) {
+			continue;
+		}
+		
+		// a few hops are enough for real code, and stop loops made only of gotos
+		for (uint8_t hops = 0; hops < 8 && code[final] == 0xa7; hops++) {
+			int64_t next = final + pd4j_link_read16(&code[final + 1]);
+			
+			if (!pd4j_link_peephole_is_start(peephole, next)) {
+				break;
+			}
+			
+			final = next;
+		}
+		
+		if (final != target && final - offset >= INT16_MIN && final - offset <= INT16_MAX) {
+			pd4j_link_write16(&code[offset + 1], (int32_t)(final - offset));
+			peephole->threaded++;
+		}
+		
+		if (opcode == 0xa7 && code[final] >= 0xac && code[final] <= 0xb1) {
+			code[offset] = code[final];
+			code[offset + 1] = 0x00;
+			code[offset + 2] = 0x00;
+			peephole->threaded++;
+		}
+	}
+}
+
+// constant operands of int arithmetic, constant conditions, and iinc in place of load, add, store
+static uint32_t pd4j_link_peephole_constants(pd4j_link_peephole *peephole, uint32_t i) {
+	uint8_t *code = peephole->code;
+	uint32_t offset = peephole->starts[i];
+	int32_t value1;
+	int32_t value2;
+	bool isStore;
+	uint16_t idx;
+	uint16_t storeIdx;
+	
+	// iload n, <literal>, iadd/isub, istore n
+	if (pd4j_link_peephole_adjacent(peephole, i, 4) && pd4j_link_local_access(code, offset, &isStore, &idx) == 'I' && !isStore && pd4j_link_literal(code, peephole->starts[i + 1], &value2)) {
+		uint8_t opcode = code[peephole->starts[i + 2]];
+		int32_t increment = (opcode == 0x60) ? value2 : -value2;
+		
+		if ((opcode == 0x60 || opcode == 0x64) && pd4j_link_local_access(code, peephole->starts[i + 3], &isStore, &storeIdx) == 'I' && isStore && storeIdx == idx && idx <= UINT8_MAX && increment >= INT8_MIN && increment <= INT8_MAX) {
+			uint32_t length = pd4j_link_peephole_end(peephole, i + 3) - offset;
+			
+			code[offset] = 0x84;
+			code[offset + 1] = (uint8_t)idx;
+			code[offset + 2] = (uint8_t)increment;
+			pd4j_link_write_skip(code, offset + 3, length - 3);
+			
+			peephole->removed += 3;
+			return 4;
+		}
+	}
+	
+	if (!pd4j_link_peephole_adjacent(peephole, i, 2) || !pd4j_link_literal(code, offset, &value1)) {
+		return 0;
+	}
+	
+	uint8_t next = code[peephole->starts[i + 1]];
+	
+	// <literal>, if<cond>
+	if (next >= 0x99 && next <= 0x9e) {
+		uint32_t branch = peephole->starts[i + 1];
+		int64_t target = (int64_t)branch + pd4j_link_read16(&code[branch + 1]);
+		uint32_t length = pd4j_link_peephole_end(peephole, i + 1) - offset;
+		
+		if (!pd4j_link_int_condition(next - 0x99, value1, 0)) {
+			pd4j_link_write_skip(code, offset, length);
+			peephole->removed += 2;
+			return 2;
+		}
+		else if (target - offset >= INT16_MIN && target - offset <= INT16_MAX) {
+			code[offset] = 0xa7;
+			pd4j_link_write16(&code[offset + 1], (int32_t)(target - offset));
+			memset(&code[offset + 3], 0x00, length - 3);
+			peephole->removed += 1;
+			return 2;
+		}
+		return 0;
+	}
+	
+	if (!pd4j_link_peephole_adjacent(peephole, i, 3) || !pd4j_link_literal(code, peephole->starts[i + 1], &value2)) {
+		return 0;
+	}
+	
+	uint32_t last = peephole->starts[i + 2];
+	uint8_t opcode = code[last];
+	uint32_t length = pd4j_link_peephole_end(peephole, i + 2) - offset;
+	
+	// <literal>, <literal>, if_icmp<cond>
+	if (opcode >= 0x9f && opcode <= 0xa4) {
+		int64_t target = (int64_t)last + pd4j_link_read16(&code[last + 1]);
+		
+		if (!pd4j_link_int_condition(opcode - 0x9f, value1, value2)) {
+			pd4j_link_write_skip(code, offset, length);
+			peephole->removed += 3;
+			return 3;
+		}
+		else if (target - offset >= INT16_MIN && target - offset <= INT16_MAX) {
+			code[offset] = 0xa7;
+			pd4j_link_write16(&code[offset + 1], (int32_t)(target - offset));
+			memset(&code[offset + 3], 0x00, length - 3);
+			peephole->removed += 2;
+			return 3;
+		}
+		return 0;
+	}
+	
+	// <literal>, <literal>, <int arithmetic that can't throw>
+	int32_t result;
+	
+	switch (opcode) {
+		case 0x60: result = (int32_t)((uint32_t)value1 + (uint32_t)value2); break;
+		case 0x64: result = (int32_t)((uint32_t)value1 - (uint32_t)value2); break;
+		case 0x68: result = (int32_t)((uint32_t)value1 * (uint32_t)value2); break;
+		case 0x78: result = (int32_t)((uint32_t)value1 << (value2 & 0x1f)); break;
+		case 0x7a: result = value1 >> (value2 & 0x1f); break;
+		case 0x7c: result = (int32_t)((uint32_t)value1 >> (value2 & 0x1f)); break;
+		case 0x7e: result = value1 & value2; break;
+		case 0x80: result = value1 | value2; break;
+		case 0x82: result = value1 ^ value2; break;
+		default: return 0;
+	}
+	
+	uint32_t written = pd4j_link_write_literal(code, offset, length, result);
+	if (written == 0) {
+		return 0;
+	}
+	
+	pd4j_link_write_skip(code, offset + written, length - written);
+	peephole->removed += 2;
+	return 3;
+}
+
+// a local variable loaded and stored straight back, dup followed by pop, and constants or copies stored to a local that is overwritten before it's read
+static uint32_t pd4j_link_peephole_locals(pd4j_link_peephole *peephole, uint32_t i) {
+	uint8_t *code = peephole->code;
+	uint32_t offset = peephole->starts[i];
+	bool isStore1;
+	bool isStore2;
+	uint16_t idx1;
+	uint16_t idx2;
+	int32_t value;
+	
+	if (!pd4j_link_peephole_adjacent(peephole, i, 2)) {
+		return 0;
+	}
+	
+	uint32_t second = peephole->starts[i + 1];
+	uint32_t length = pd4j_link_peephole_end(peephole, i + 1) - offset;
+	
+	// dup, pop and dup2, pop2
+	if ((code[offset] == 0x59 && code[second] == 0x57) || (code[offset] == 0x5c && code[second] == 0x58)) {
+		pd4j_link_write_skip(code, offset, length);
+		peephole->removed += 2;
+		return 2;
+	}
+	
+	char type1 = pd4j_link_local_access(code, offset, &isStore1, &idx1);
+	char type2 = pd4j_link_local_access(code, second, &isStore2, &idx2);
+	
+	if (type2 == 0 || !isStore2) {
+		return 0;
+	}
+	
+	// <t>load n, <t>store n
+	if (type1 == type2 && !isStore1 && idx1 == idx2) {
+		pd4j_link_write_skip(code, offset, length);
+		peephole->removed += 2;
+		return 2;
+	}
+	
+	if (!((type1 != 0 && !isStore1 && type1 == type2) || (type2 == 'I' && pd4j_link_literal(code, offset, &value)))) {
+		return 0;
+	}
+	
+	// the value pushed by the first instruction is dead if the local is stored again before anything can read it
+	bool isWide = type2 == 'J' || type2 == 'D';
+	pd4j_class_attribute *codeAttribute = peephole->codeAttribute;
+	
+	for (uint32_t j = i + 2; j < peephole->numInstructions && !peephole->isTarget[peephole->starts[j]]; j++) {
+		uint32_t current = peephole->starts[j];
+		uint8_t opcode = code[current];
+		bool isStore;
+		uint16_t idx;
+		char type = pd4j_link_local_access(code, current, &isStore, &idx);
+		
+		if (type != 0) {
+			bool isTypeWide = type == 'J' || type == 'D';
+			bool overlaps = idx <= idx2 + (isWide ? 1 : 0) && idx2 <= idx + (isTypeWide ? 1 : 0);
+			
+			if (!overlaps) {
+				continue;
+			}
+			else if (!isStore || type != type2 || idx != idx2) {
+				return 0;
+			}
+			
+			// a handler could read the local if anything in between throws
+			for (uint16_t k = 0; k < codeAttribute->parsedData.code.exceptionTableLength; k++) {
+				pd4j_class_exception_table_entry *entry = &codeAttribute->parsedData.code.exceptionTable[k];
+				
+				if ((uint32_t)(entry->startPc - codeAttribute->parsedData.code.code) < current && (uint32_t)(entry->endPc - codeAttribute->parsedData.code.code) > offset) {
+					return 0;
+				}
+			}
+			
+			pd4j_link_write_skip(code, offset, length);
+			peephole->removed += 2;
+			return 2;
+		}
+		
+		// anything that leaves the block, reads locals in another way, or changes them
+		if ((opcode >= 0x99 && opcode <= 0xb1) || opcode == 0xbf || opcode == 0xc4 || (opcode >= 0xc6 && opcode <= 0xc9) || (opcode == 0x84 && code[current + 1] == idx2)) {
+			return 0;
+		}
+	}
+	
+	return 0;
+}
+
+// scans a method's linked code for the passes below, returning false if they should leave it alone
+static bool pd4j_link_peephole_begin(pd4j_link_peephole *peephole, pd4j_link_method *link) {
+	peephole->code = link->code;
+	peephole->codeLength = link->codeLength;
+	peephole->codeAttribute = link->codeAttribute;
+	peephole->numInstructions = 0;
+	peephole->starts = NULL;
+	peephole->isTarget = NULL;
+	peephole->removed = 0;
+	peephole->threaded = 0;
+	
+	if (!pd4j_link_peephole_scan(peephole)) {
+		return false;
+	}
+	
+	peephole->starts = pd4j_malloc(peephole->numInstructions * sizeof(uint32_t));
+	peephole->isTarget = pd4j_malloc(peephole->codeLength);
+	
+	// optimizing is only worth it when there's memory to spare
+	if (peephole->starts == NULL || peephole->isTarget == NULL) {
+		if (peephole->starts != NULL) {
+			pd4j_free(peephole->starts, peephole->numInstructions * sizeof(uint32_t));
+		}
+		if (peephole->isTarget != NULL) {
+			pd4j_free(peephole->isTarget, peephole->codeLength);
+		}
+		return false;
+	}
+	
+	memset(peephole->isTarget, 0, peephole->codeLength);
+	pd4j_link_peephole_scan(peephole);
+	return true;
+}
+
+static void pd4j_link_peephole_release(pd4j_link_peephole *peephole) {
+	pd4j_free(peephole->starts, peephole->numInstructions * sizeof(uint32_t));
+	pd4j_free(peephole->isTarget, peephole->codeLength);
+}
+
+// rewrites common naive sequences into shorter ones of the same length in bytes, so no offsets change
+// nothing is rewritten across a jump target or into something that throws differently
+static void pd4j_link_method_optimize(pd4j_link_method *link) {
+	pd4j_link_peephole peephole;
+	
+	if (!pd4j_link_peephole_begin(&peephole, link)) {
+		return;
+	}
+	
+	link->numInstructions = (uint16_t)peephole.numInstructions;
+	pd4j_link_peephole_thread(&peephole);
+	
+	for (uint32_t i = 0; i < peephole.numInstructions;) {
+		uint32_t consumed = pd4j_link_peephole_constants(&peephole, i);
+		
+		if (consumed == 0) {
+			consumed = pd4j_link_peephole_locals(&peephole, i);
+		}
+		
+		i += (consumed == 0) ? 1 : consumed;
+	}
+	
+	link->numInstructionsRemoved = (uint16_t)peephole.removed;
+	link->numJumpsThreaded = (uint16_t)peephole.threaded;
+	
+	pd4j_link_peephole_release(&peephole);
+}
+
+// operand stack slots popped and pushed by the instructions that array indexing expressions are made of, or 0xff for any other instruction
+static const uint8_t pd4j_link_stack_effects[0x94][2] = {
+	// 0x00 - 0x0f
+	{0, 0}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 2}, {0, 2}, {0, 1}, {0, 1}, {0, 1}, {0, 2}, {0, 2},
+	// 0x10 - 0x1f
+	{0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 2}, {0, 1}, {0, 2}, {0, 1}, {0, 2}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 2}, {0, 2},
+	// 0x20 - 0x2f
+	{0, 2}, {0, 2}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {0, 2}, {0, 2}, {0, 2}, {0, 2}, {0, 1}, {0, 1}, {0, 1}, {0, 1}, {2, 1}, {2, 2},
+	// 0x30 - 0x3f
+	{2, 1}, {2, 2}, {2, 1}, {2, 1}, {2, 1}, {2, 1}, {1, 0}, {2, 0}, {1, 0}, {2, 0}, {1, 0}, {1, 0}, {1, 0}, {1, 0}, {1, 0}, {2, 0},
+	// 0x40 - 0x4f
+	{2, 0}, {2, 0}, {2, 0}, {1, 0}, {1, 0}, {1, 0}, {1, 0}, {2, 0}, {2, 0}, {2, 0}, {2, 0}, {1, 0}, {1, 0}, {1, 0}, {1, 0}, {0xff, 0xff},
+	// 0x50 - 0x5f
+	{0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {1, 0}, {2, 0}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff}, {0xff, 0xff},
+	// 0x60 - 0x6f
+	{2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2}, {2, 1}, {4, 2},
+	// 0x70 - 0x7f
+	{2, 1}, {4, 2}, {2, 1}, {4, 2}, {1, 1}, {2, 2}, {1, 1}, {2, 2}, {2, 1}, {3, 2}, {2, 1}, {3, 2}, {2, 1}, {3, 2}, {2, 1}, {4, 2},
+	// 0x80 - 0x8f
+	{2, 1}, {4, 2}, {2, 1}, {4, 2}, {0, 0}, {1, 2}, {1, 1}, {1, 2}, {2, 1}, {2, 1}, {2, 2}, {1, 1}, {1, 2}, {1, 2}, {2, 1}, {2, 2},
+	// 0x90 - 0x93
+	{2, 1}, {1, 1}, {1, 1}, {1, 1}
+};
+
+// what an operand stack slot is known to hold while looking for array accesses in a loop
+typedef enum {
+	pd4j_LINK_SLOT_UNKNOWN = 0,
+	pd4j_LINK_SLOT_ARRAY,
+	pd4j_LINK_SLOT_INDEX
+} pd4j_link_slot_kind;
+
+// deepest operand stack the search for array accesses keeps track of, forgetting everything if it grows past this
+#define PD4J_LINK_TRACKED_SLOTS 16
+
+typedef struct {
+	pd4j_link_slot_kind slots[PD4J_LINK_TRACKED_SLOTS];
+	uint8_t depth;
+} pd4j_link_slot_stack;
+
+static inline pd4j_link_slot_kind pd4j_link_slot_peek(pd4j_link_slot_stack *stack, uint8_t depth) {
+	return (depth < stack->depth) ? stack->slots[stack->depth - 1 - depth] : pd4j_LINK_SLOT_UNKNOWN;
+}
+
+static inline void pd4j_link_slot_pop(pd4j_link_slot_stack *stack, uint8_t count) {
+	stack->depth = (count < stack->depth) ? stack->depth - count : 0;
+}
+
+static inline void pd4j_link_slot_push(pd4j_link_slot_stack *stack, pd4j_link_slot_kind kind) {
+	if (stack->depth == PD4J_LINK_TRACKED_SLOTS) {
+		stack->depth = 0;
+	}
+	stack->slots[stack->depth++] = kind;
+}
+
+// whether the instruction stores to the local variable or one that overlaps it
+static bool pd4j_link_writes_local(uint8_t *code, uint32_t offset, uint16_t idx) {
+	bool isStore;
+	uint16_t storeIdx;
+	char type = pd4j_link_local_access(code, offset, &isStore, &storeIdx);
+	
+	if (type != 0) {
+		return isStore && (storeIdx == idx || ((type == 'J' || type == 'D') && storeIdx + 1 == idx));
+	}
+	
+	return code[offset] == 0xc4 || (code[offset] == 0x84 && code[offset + 1] == idx);
+}
+
+// whether an instruction outside the instructions from first to last (exclusive) jumps into them, other than by falling through into the first
+static bool pd4j_link_entered_from_outside(pd4j_link_peephole *peephole, uint32_t first, uint32_t last) {
+	uint8_t *code = peephole->code;
+	uint32_t start = peephole->starts[first];
+	uint32_t end = pd4j_link_peephole_end(peephole, last - 1);
+	
+	for (uint32_t i = 0; i < peephole->numInstructions; i++) {
+		uint32_t offset = peephole->starts[i];
+		uint8_t opcode = code[offset];
+		
+		if (i >= first && i < last) {
+			continue;
+		}
+		
+		if ((opcode >= 0x99 && opcode <= 0xa7) || opcode == 0xc6 || opcode == 0xc7) {
+			int64_t target = (int64_t)offset + pd4j_link_read16(&code[offset + 1]);
+			
+			if (target >= start && target < end) {
+				return true;
+			}
+		}
+		else if (opcode == 0xc8) {
+			int64_t target = (int64_t)offset + pd4j_link_read32(&code[offset + 1]);
+			
+			if (target >= start && target < end) {
+				return true;
+			}
+		}
+		else if (opcode == 0xaa || opcode == 0xab) {
+			uint32_t operands = (offset + 4) & ~(uint32_t)3;
+			uint32_t length = pd4j_link_instruction_length(code, offset);
+			int64_t target = (int64_t)offset + pd4j_link_read32(&code[operands]);
+			
+			if (target >= start && target < end) {
+				return true;
+			}
+			
+			for (uint32_t entry = operands + 12; entry < offset + length; entry += (opcode == 0xaa) ? 4 : 8) {
+				target = (int64_t)offset + pd4j_link_read32(&code[entry]);
+				
+				if (target >= start && target < end) {
+					return true;
+				}
+			}
+		}
+	}
+	
+	pd4j_class_attribute *codeAttribute = peephole->codeAttribute;
+	
+	for (uint16_t i = 0; i < codeAttribute->parsedData.code.exceptionTableLength; i++) {
+		uint32_t handler = (uint32_t)(codeAttribute->parsedData.code.exceptionTable[i].handlerPc - codeAttribute->parsedData.code.code);
+		
+		if (handler >= start && handler < end) {
+			return true;
+		}
+	}
+	
+	return false;
+}
+
+// replaces the array accesses between first and last (exclusive) that index arrayIdx by indexIdx with unchecked ones, returning how many there were
+static uint16_t pd4j_link_uncheck_accesses(pd4j_link_peephole *peephole, uint32_t first, uint32_t last, uint16_t arrayIdx, uint16_t indexIdx) {
+	uint8_t *code = peephole->code;
+	pd4j_link_slot_stack stack;
+	uint16_t count = 0;
+	
+	stack.depth = 0;
+	
+	for (uint32_t i = first; i < last; i++) {
+		uint32_t offset = peephole->starts[i];
+		uint8_t opcode = code[offset];
+		bool isStore;
+		uint16_t idx;
+		
+		// values on the stack at a jump target could have come from anywhere
+		if (peephole->isTarget[offset]) {
+			stack.depth = 0;
+		}
+		
+		char type = pd4j_link_local_access(code, offset, &isStore, &idx);
+		
+		if (type == 'A' && !isStore && idx == arrayIdx) {
+			pd4j_link_slot_push(&stack, pd4j_LINK_SLOT_ARRAY);
+		}
+		else if (type == 'I' && !isStore && idx == indexIdx) {
+			pd4j_link_slot_push(&stack, pd4j_LINK_SLOT_INDEX);
+		}
+		else if (opcode >= 0x2e && opcode <= 0x35) {
+			// <t>aload
+			if (pd4j_link_slot_peek(&stack, 0) == pd4j_LINK_SLOT_INDEX && pd4j_link_slot_peek(&stack, 1) == pd4j_LINK_SLOT_ARRAY) {
+				code[offset] = pd4j_OPCODE_XALOAD_UNCHECKED;
+				count++;
+			}
+			
+			pd4j_link_slot_pop(&stack, 2);
+			for (uint8_t k = 0; k < pd4j_link_stack_effects[opcode][1]; k++) {
+				pd4j_link_slot_push(&stack, pd4j_LINK_SLOT_UNKNOWN);
+			}
+		}
+		else if (opcode >= 0x4f && opcode <= 0x56) {
+			// <t>astore, except for aastore, which has to check the type of the value
+			static const uint8_t uncheckedStores[] = {pd4j_OPCODE_IASTORE_UNCHECKED, pd4j_OPCODE_LASTORE_UNCHECKED, pd4j_OPCODE_FASTORE_UNCHECKED, pd4j_OPCODE_DASTORE_UNCHECKED, 0x53, pd4j_OPCODE_IASTORE_UNCHECKED, pd4j_OPCODE_IASTORE_UNCHECKED, pd4j_OPCODE_IASTORE_UNCHECKED};
+			uint8_t valueSlots = (opcode == 0x50 || opcode == 0x52) ? 2 : 1;
+			
+			if (opcode != 0x53 && pd4j_link_slot_peek(&stack, valueSlots) == pd4j_LINK_SLOT_INDEX && pd4j_link_slot_peek(&stack, valueSlots + 1) == pd4j_LINK_SLOT_ARRAY) {
+				code[offset] = uncheckedStores[opcode - 0x4f];
+				count++;
+			}
+			
+			pd4j_link_slot_pop(&stack, valueSlots + 2);
+		}
+		else if (opcode == 0x59) {
+			// dup
+			pd4j_link_slot_push(&stack, pd4j_link_slot_peek(&stack, 0));
+		}
+		else if (opcode == 0x5c) {
+			// dup2, as in a[i] += x
+			pd4j_link_slot_kind below = pd4j_link_slot_peek(&stack, 1);
+			pd4j_link_slot_kind top = pd4j_link_slot_peek(&stack, 0);
+			
+			pd4j_link_slot_push(&stack, below);
+			pd4j_link_slot_push(&stack, top);
+		}
+		else if (opcode < sizeof(pd4j_link_stack_effects) / sizeof(pd4j_link_stack_effects[0]) && pd4j_link_stack_effects[opcode][0] != 0xff) {
+			pd4j_link_slot_pop(&stack, pd4j_link_stack_effects[opcode][0]);
+			for (uint8_t k = 0; k < pd4j_link_stack_effects[opcode][1]; k++) {
+				pd4j_link_slot_push(&stack, pd4j_LINK_SLOT_UNKNOWN);
+			}
+		}
+		else {
+			// nothing is known about what the rest of the instructions leave on the stack
+			stack.depth = 0;
+		}
+	}
+	
+	return count;
+}
+
+// finds the loops javac writes for `for (int i = <constant of at least 0>; i < a.length; i++)`:
+//   <literal>; istore i; H: iload i; aload a; arraylength; if_icmpge END; <body>; iinc i 1; goto H; END:
+// if nothing else writes to i or a and the loop can only be entered through its start, a is non-null and i in range throughout the body,
+// so accesses to a[i] there need no checks
+static void pd4j_link_method_eliminate_checks(pd4j_link_method *link) {
+	pd4j_link_peephole peephole;
+	
+	if (!pd4j_link_peephole_begin(&peephole, link)) {
+		return;
+	}
+	
+	uint8_t *code = peephole.code;
+	
+	for (uint32_t g = 0; g < peephole.numInstructions; g++) {
+		uint32_t gotoOffset = peephole.starts[g];
+		
+		if (code[gotoOffset] != 0xa7 || pd4j_link_read16(&code[gotoOffset + 1]) >= 0) {
+			continue;
+		}
+		
+		uint32_t header = gotoOffset + pd4j_link_read16(&code[gotoOffset + 1]);
+		uint32_t h = 0;
+		
+		while (h < g && peephole.starts[h] < header) {
+			h++;
+		}
+		
+		if (h < 2 || h + 4 > g || peephole.starts[h] != header) {
+			continue;
+		}
+		
+		// the header
+		bool isStore;
+		uint16_t indexIdx;
+		uint16_t arrayIdx;
+		uint16_t idx;
+		int32_t initial;
+		uint32_t exitBranch = peephole.starts[h + 3];
+		
+		if (pd4j_link_local_access(code, header, &isStore, &indexIdx) != 'I' || isStore) {
+			continue;
+		}
+		if (pd4j_link_local_access(code, peephole.starts[h + 1], &isStore, &arrayIdx) != 'A' || isStore) {
+			continue;
+		}
+		if (code[peephole.starts[h + 2]] != 0xbe || code[exitBranch] != 0xa2 || exitBranch + pd4j_link_read16(&code[exitBranch + 1]) != gotoOffset + 3) {
+			continue;
+		}
+		if (peephole.isTarget[peephole.starts[h + 1]] || peephole.isTarget[peephole.starts[h + 2]] || peephole.isTarget[exitBranch]) {
+			continue;
+		}
+		
+		// the initialization, which has to be the only way into the loop from outside
+		if (pd4j_link_local_access(code, peephole.starts[h - 1], &isStore, &idx) != 'I' || !isStore || idx != indexIdx || peephole.isTarget[peephole.starts[h - 1]]) {
+			continue;
+		}
+		if (!pd4j_link_literal(code, peephole.starts[h - 2], &initial) || initial < 0 || pd4j_link_entered_from_outside(&peephole, h, g + 1)) {
+			continue;
+		}
+		
+		// the increment, skipping any nops the peephole optimizer left before the goto
+		uint32_t increment = g - 1;
+		
+		while (increment > h + 3 && code[peephole.starts[increment]] == 0x00) {
+			increment--;
+		}
+		
+		uint32_t incrementOffset = peephole.starts[increment];
+		
+		if (increment <= h + 3 || code[incrementOffset] != 0x84 || code[incrementOffset + 1] != indexIdx || code[incrementOffset + 2] != 1) {
+			continue;
+		}
+		
+		// the body
+		bool written = false;
+		
+		for (uint32_t i = h + 4; i < increment && !written; i++) {
+			written = pd4j_link_writes_local(code, peephole.starts[i], indexIdx) || pd4j_link_writes_local(code, peephole.starts[i], arrayIdx);
+		}
+		
+		if (!written) {
+			link->numChecksEliminated += pd4j_link_uncheck_accesses(&peephole, h + 4, increment, arrayIdx, indexIdx);
+		}
+	}
+	
+	pd4j_link_peephole_release(&peephole);
+}
+
+// writes superinstructions over the sequences they stand for
+// only the first opcode changes, so a branch into the middle of a sequence still runs the original instructions from there
+static void pd4j_link_method_fuse(pd4j_link_method *link) {
+#ifdef PD4J_PROFILE_OPCODES
+	(void)link;
+#else
+	uint8_t *code = link->code;
+	
+	for (uint32_t offset = 0; offset < link->codeLength; offset += pd4j_link_instruction_length(code, offset)) {
+		for (size_t i = 0; i < sizeof(pd4j_link_superinstructions) / sizeof(pd4j_link_superinstruction); i++) {
+			const pd4j_link_superinstruction *superinstruction = &pd4j_link_superinstructions[i];
+			uint32_t next = offset;
+			uint8_t matched = 0;
+			
+			while (matched < superinstruction->length && next < link->codeLength && code[next] == superinstruction->opcodes[matched]) {
+				next += pd4j_link_instruction_length(code, next);
+				matched++;
+			}
+			
+			if (matched == superinstruction->length && next <= link->codeLength) {
+				code[offset] = superinstruction->fusedOpcode;
+				break;
+			}
+		}
+	}
+#endif
+}
+
+// a lookupswitch is dispatched by index if a table covering its keys would have at most this many entries per key
+#define PD4J_LINK_DENSE_SWITCH_RATIO 2
+
+static void pd4j_link_switch_destroy(pd4j_link_switch *table) {
+	if (table->keys != NULL) {
+		pd4j_free(table->keys, table->numEntries * sizeof(int32_t));
+	}
+	if (table->offsets != NULL) {
+		pd4j_free(table->offsets, table->numEntries * sizeof(int32_t));
+	}
+}
+
+static bool pd4j_link_switch_decode(pd4j_thread *thread, pd4j_link_switch *table, uint8_t *code, uint32_t offset) {
+	uint32_t operands = (offset + 4) & ~(uint32_t)3;
+	
+	table->defaultOffset = pd4j_link_read32(&code[operands]);
+	table->keys = NULL;
+	table->offsets = NULL;
+	
+	if (code[offset] == 0xaa) {
+		table->lowValue = pd4j_link_read32(&code[operands + 4]);
+		table->numEntries = (uint32_t)(pd4j_link_read32(&code[operands + 8]) - table->lowValue) + 1;
+		
+		table->offsets = pd4j_malloc(table->numEntries * sizeof(int32_t));
+		if (table->offsets == NULL) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate switch table: Out of memory");
+			return false;
+		}
+		
+		for (uint32_t i = 0; i < table->numEntries; i++) {
+			table->offsets[i] = pd4j_link_read32(&code[operands + 12 + 4 * i]);
+		}
+		return true;
+	}
+	
+	uint32_t numPairs = (uint32_t)pd4j_link_read32(&code[operands + 4]);
+	uint8_t *pairs = &code[operands + 8];
+	
+	for (uint32_t i = 1; i < numPairs; i++) {
+		if (pd4j_link_read32(&pairs[8 * i]) <= pd4j_link_read32(&pairs[8 * (i - 1)])) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: lookupswitch keys aren't sorted");
+			return false;
+		}
+	}
+	
+	int64_t range = (numPairs == 0) ? 0 : (int64_t)pd4j_link_read32(&pairs[8 * (numPairs - 1)]) - pd4j_link_read32(&pairs[0]) + 1;
+	
+	if (numPairs > 0 && range <= (int64_t)numPairs * PD4J_LINK_DENSE_SWITCH_RATIO) {
+		// dense keys: a table with the default offset in the gaps
+		table->lowValue = pd4j_link_read32(&pairs[0]);
+		table->numEntries = (uint32_t)range;
+		
+		table->offsets = pd4j_malloc(table->numEntries * sizeof(int32_t));
+		if (table->offsets == NULL) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate switch table: Out of memory");
+			return false;
+		}
+		
+		for (uint32_t i = 0; i < table->numEntries; i++) {
+			table->offsets[i] = table->defaultOffset;
+		}
+		for (uint32_t i = 0; i < numPairs; i++) {
+			table->offsets[(uint32_t)(pd4j_link_read32(&pairs[8 * i]) - table->lowValue)] = pd4j_link_read32(&pairs[8 * i + 4]);
+		}
+		return true;
+	}
+	
+	table->lowValue = 0;
+	table->numEntries = numPairs;
+	
+	if (numPairs == 0) {
+		return true;
+	}
+	
+	table->keys = pd4j_malloc(numPairs * sizeof(int32_t));
+	table->offsets = pd4j_malloc(numPairs * sizeof(int32_t));
+	
+	if (table->keys == NULL || table->offsets == NULL) {
+		pd4j_link_switch_destroy(table);
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate switch table: Out of memory");
+		return false;
+	}
+	
+	for (uint32_t i = 0; i < numPairs; i++) {
+		table->keys[i] = pd4j_link_read32(&pairs[8 * i]);
+		table->offsets[i] = pd4j_link_read32(&pairs[8 * i + 4]);
+	}
+	return true;
+}
+
+// decodes every switch into a pd4j_link_switch and quickens it, so the interpreter doesn't read its operands again
+static bool pd4j_link_method_decode_switches(pd4j_thread *thread, pd4j_link_method *link) {
+	uint16_t numSwitches = 0;
+	
+	for (uint32_t offset = 0; offset < link->codeLength; offset += pd4j_link_instruction_length(link->code, offset)) {
+		if (link->code[offset] == 0xaa || link->code[offset] == 0xab) {
+			numSwitches++;
+		}
+	}
+	
+	if (numSwitches == 0) {
+		return true;
+	}
+	
+	link->switches = pd4j_malloc(numSwitches * sizeof(pd4j_link_switch));
+	if (link->switches == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate switch tables: Out of memory");
+		return false;
+	}
+	
+	for (uint32_t offset = 0; offset < link->codeLength; offset += pd4j_link_instruction_length(link->code, offset)) {
+		uint8_t opcode = link->code[offset];
+		
+		if (opcode != 0xaa && opcode != 0xab) {
+			continue;
+		}
+		
+		if (!pd4j_link_switch_decode(thread, &link->switches[link->numSwitches], link->code, offset)) {
+			for (uint16_t i = 0; i < link->numSwitches; i++) {
+				pd4j_link_switch_destroy(&link->switches[i]);
+			}
+			
+			pd4j_free(link->switches, numSwitches * sizeof(pd4j_link_switch));
+			link->switches = NULL;
+			link->numSwitches = 0;
+			return false;
+		}
+		
+		// the default offset is in the table now, so its place holds the table's index
+		uint32_t operands = (offset + 4) & ~(uint32_t)3;
+		
+		link->code[operands] = 0;
+		link->code[operands + 1] = 0;
+		link->code[operands + 2] = (uint8_t)(link->numSwitches >> 8);
+		link->code[operands + 3] = (uint8_t)(link->numSwitches & 0xff);
+		link->code[offset] = (opcode == 0xaa) ? pd4j_OPCODE_TABLESWITCH_QUICK : pd4j_OPCODE_LOOKUPSWITCH_QUICK;
+		
+		link->numSwitches++;
+	}
+	
+	return true;
+}
+
+static void pd4j_link_method_destroy_handlers(pd4j_link_method *link) {
+	if (link->handlers != NULL) {
+		pd4j_free(link->handlers, link->numHandlers * sizeof(pd4j_link_handler));
+		link->handlers = NULL;
+	}
+	if (link->handlerRanges != NULL) {
+		// allocated for as many bounds as there could be, which is two for each handler
+		pd4j_free(link->handlerRanges, 2 * link->numHandlers * sizeof(pd4j_link_handler_range));
+		link->handlerRanges = NULL;
+	}
+	if (link->handlerOrder != NULL) {
+		pd4j_free(link->handlerOrder, link->handlerOrderLength * sizeof(uint16_t));
+		link->handlerOrder = NULL;
+	}
+	
+	link->numHandlers = 0;
+	link->numHandlerRanges = 0;
+	link->handlerOrderLength = 0;
+}
+
+// splits the code at every offset where a handler starts or ends, so finding the handlers for an instruction is a binary search
+static bool pd4j_link_method_index_handlers(pd4j_thread *thread, pd4j_link_method *link) {
+	pd4j_class_attribute *codeAttribute = link->codeAttribute;
+	uint16_t numHandlers = codeAttribute->parsedData.code.exceptionTableLength;
+	
+	if (numHandlers == 0) {
+		return true;
+	}
+	
+	link->handlers = pd4j_malloc(numHandlers * sizeof(pd4j_link_handler));
+	link->handlerRanges = pd4j_malloc(2 * numHandlers * sizeof(pd4j_link_handler_range));
+	
+	if (link->handlers == NULL || link->handlerRanges == NULL) {
+		if (link->handlers != NULL) {
+			pd4j_free(link->handlers, numHandlers * sizeof(pd4j_link_handler));
+			link->handlers = NULL;
+		}
+		if (link->handlerRanges != NULL) {
+			pd4j_free(link->handlerRanges, 2 * numHandlers * sizeof(pd4j_link_handler_range));
+			link->handlerRanges = NULL;
+		}
+		
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate exception handler index: Out of memory");
+		return false;
+	}
+	
+	link->numHandlers = numHandlers;
+	
+	uint16_t numBounds = 0;
+	
+	for (uint16_t i = 0; i < numHandlers; i++) {
+		pd4j_class_exception_table_entry *entry = &codeAttribute->parsedData.code.exceptionTable[i];
+		pd4j_link_handler *handler = &link->handlers[i];
+		
+		handler->startPc = (uint16_t)(entry->startPc - codeAttribute->parsedData.code.code);
+		handler->endPc = (uint16_t)(entry->endPc - codeAttribute->parsedData.code.code);
+		handler->handlerPc = (uint16_t)(entry->handlerPc - codeAttribute->parsedData.code.code);
+		handler->catchTypeName = entry->catchType;
+		handler->catchType = NULL;
+		
+		// insertion sort of the distinct bounds, since exception tables are short
+		uint16_t bounds[2] = {handler->startPc, handler->endPc};
+		
+		for (uint8_t j = 0; j < 2; j++) {
+			uint16_t k = numBounds;
+			
+			while (k > 0 && link->handlerRanges[k - 1].startPc > bounds[j]) {
+				k--;
+			}
+			
+			if (k > 0 && link->handlerRanges[k - 1].startPc == bounds[j]) {
+				continue;
+			}
+			
+			memmove(&link->handlerRanges[k + 1], &link->handlerRanges[k], (numBounds - k) * sizeof(pd4j_link_handler_range));
+			link->handlerRanges[k].startPc = bounds[j];
+			numBounds++;
+		}
+	}
+	
+	uint32_t orderLength = 0;
+	
+	// the last bound only ends the range before it
+	for (uint16_t i = 0; i < numBounds; i++) {
+		link->handlerRanges[i].firstHandler = (uint16_t)orderLength;
+		link->handlerRanges[i].numHandlers = 0;
+		
+		for (uint16_t j = 0; j < numHandlers; j++) {
+			if (link->handlers[j].startPc <= link->handlerRanges[i].startPc && link->handlerRanges[i].startPc < link->handlers[j].endPc) {
+				link->handlerRanges[i].numHandlers++;
+			}
+		}
+		
+		orderLength += link->handlerRanges[i].numHandlers;
+	}
+	
+	link->handlerOrderLength = orderLength;
+	link->handlerOrder = pd4j_malloc(orderLength * sizeof(uint16_t));
+	
+	if (link->handlerOrder == NULL) {
+		pd4j_link_method_destroy_handlers(link);
+		
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate exception handler index: Out of memory");
+		return false;
+	}
+	
+	for (uint16_t i = 0; i < numBounds; i++) {
+		uint16_t *order = &link->handlerOrder[link->handlerRanges[i].firstHandler];
+		
+		for (uint16_t j = 0; j < numHandlers; j++) {
+			if (link->handlers[j].startPc <= link->handlerRanges[i].startPc && link->handlerRanges[i].startPc < link->handlers[j].endPc) {
+				*(order++) = j;
+			}
+		}
+	}
+	
+	link->numHandlerRanges = numBounds;
+	
+	return true;
+}
+
+bool pd4j_link_find_handler(pd4j_thread *thread, pd4j_link_method *link, uint32_t pcOffset, pd4j_class_reference *thrownClass, pd4j_link_handler **outHandler) {
+	*outHandler = NULL;
+	
+	if (link->numHandlerRanges == 0 || pcOffset < link->handlerRanges[0].startPc) {
+		return true;
+	}
+	
+	// the last range starting at or before the offset
+	uint16_t low = 0;
+	uint16_t high = link->numHandlerRanges - 1;
+	
+	while (low < high) {
+		uint16_t mid = (uint16_t)((low + high + 1) / 2);
+		
+		if (link->handlerRanges[mid].startPc <= pcOffset) {
+			low = mid;
+		}
+		else {
+			high = mid - 1;
+		}
+	}
+	
+	pd4j_link_handler_range *range = &link->handlerRanges[low];
+	
+	for (uint16_t i = 0; i < range->numHandlers; i++) {
+		pd4j_link_handler *handler = &link->handlers[link->handlerOrder[range->firstHandler + i]];
+		
+		if (handler->catchTypeName == NULL) {
+			*outHandler = handler;
+			return true;
+		}
+		
+		if (handler->catchType == NULL) {
+			handler->catchType = pd4j_class_get_resolved_class_reference(link->class, thread, handler->catchTypeName);
+			
+			if (handler->catchType == NULL) {
+				return false;
+			}
+		}
+		
+		if (pd4j_class_extends(thrownClass, handler->catchType->data.class.loaded)) {
+			*outHandler = handler;
+			return true;
+		}
+	}
+	
+	return true;
+}
+
+static bool pd4j_link_method_prepare_code(pd4j_thread *thread, pd4j_link_method *link) {
+	uint8_t *original = link->codeAttribute->parsedData.code.code;
+	uint32_t codeLength = link->codeAttribute->parsedData.code.codeLength;
+	
+	link->code = pd4j_malloc(codeLength);
+	if (link->code == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate linked method code: Out of memory");
+		return false;
+	}
+	
+	memcpy(link->code, original, codeLength);
+	link->codeLength = codeLength;
+	
+	uint16_t numCallSites = 0;
+	
+	for (uint32_t offset = 0; offset < codeLength;) {
+		uint32_t length = pd4j_link_instruction_length(link->code, offset);
+		
+		// the opcodes from the quick range up are only valid in linked code
+		if (length == 0 || offset + length > codeLength || link->code[offset] >= pd4j_OPCODE_INVOKEVIRTUAL_QUICK) {
+			pd4j_free(link->code, codeLength);
+			link->code = NULL;
+			
+			pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: Method code contains an invalid instruction");
+			return false;
+		}
+		
+		if (link->code[offset] >= 0xb6 && link->code[offset] <= 0xb9) {
+			numCallSites++;
+		}
+		
+		offset += length;
+	}
+	
+	link->numCallSites = numCallSites;
+	
+	// both passes rely on the branch targets, stack depths and types the verifier proved
+	if (link->verified) {
+		pd4j_link_method_optimize(link);
+		pd4j_link_method_eliminate_checks(link);
+	}
+	
+	if (!pd4j_link_method_decode_switches(thread, link)) {
+		pd4j_free(link->code, codeLength);
+		link->code = NULL;
+		return false;
+	}
+	
+	if (numCallSites == 0) {
+		pd4j_link_method_fuse(link);
+		return true;
+	}
+	
+	link->callSites = pd4j_malloc(numCallSites * sizeof(pd4j_link_call_site));
+	if (link->callSites == NULL) {
+		pd4j_free(link->code, codeLength);
+		link->code = NULL;
+		
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate method call sites: Out of memory");
+		return false;
+	}
+	
+	uint16_t siteIdx = 0;
+	
+	for (uint32_t offset = 0; offset < codeLength; offset += pd4j_link_instruction_length(link->code, offset)) {
+		uint8_t opcode = link->code[offset];
+		
+		if (opcode < 0xb6 || opcode > 0xb9) {
+			continue;
+		}
+		
+		pd4j_link_call_site *site = &link->callSites[siteIdx];
+		
+		site->pcOffset = (uint16_t)offset;
+		site->constantIndex = (uint16_t)((link->code[offset + 1] << 8) | link->code[offset + 2]);
+		site->opcode = opcode;
+		site->state = pd4j_CALL_SITE_UNRESOLVED;
+		site->resolvedMethod = NULL;
+		site->numArgSlots = 0;
+		site->numEntries = 0;
+		site->hits = 0;
+		site->misses = 0;
+		site->megamorphicCalls = 0;
+		
+		switch (opcode) {
+			case 0xb6:
+				link->code[offset] = pd4j_OPCODE_INVOKEVIRTUAL_QUICK;
+				break;
+			case 0xb7:
+				link->code[offset] = pd4j_OPCODE_INVOKESPECIAL_QUICK;
+				break;
+			case 0xb8:
+				link->code[offset] = pd4j_OPCODE_INVOKESTATIC_QUICK;
+				break;
+			case 0xb9:
+				link->code[offset] = pd4j_OPCODE_INVOKEINTERFACE_QUICK;
+				break;
+		}
+		
+		link->code[offset + 1] = (uint8_t)(siteIdx >> 8);
+		link->code[offset + 2] = (uint8_t)(siteIdx & 0xff);
+		
+		siteIdx++;
+	}
+	
+	pd4j_link_method_fuse(link);
+	return true;
+}
+
+// finds where a field of the class itself sits in its instances, so getters and setters can skip resolving the reference on every call
+static bool pd4j_link_instance_field_slot(pd4j_class_reference *classRef, uint16_t idx, uint16_t *slot) {
+	pd4j_class *class = classRef->data.class;
+	pd4j_class_constant *fieldRef = &class->constantPool[idx - 1];
+	pd4j_class_constant *nameAndType = &class->constantPool[fieldRef->data.indices.b - 1];
+	uint8_t *className;
+	uint8_t *fieldName;
+	
+	if (!pd4j_class_constant_utf8(class, class->constantPool[fieldRef->data.indices.a - 1].data.indices.a, &className) || !pd4j_class_constant_utf8(class, nameAndType->data.indices.a, &fieldName)) {
+		return false;
+	}
+	
+	// fields inherited from elsewhere are left to resolution
+	if (strcmp((const char *)className, (const char *)(class->thisClass)) != 0) {
+		return false;
+	}
+	
+	uint16_t index = 0;
+	for (uint16_t i = 0; i < class->numFields; i++) {
+		if ((class->fields[i].accessFlags.field & pd4j_FIELD_ACC_STATIC) != 0) {
+			continue;
+		}
+		
+		if (strcmp((const char *)fieldName, (const char *)(class->fields[i].name)) == 0) {
+			*slot = index;
+			return true;
+		}
+		index++;
+	}
+	
+	return false;
+}
+
+static void pd4j_link_method_classify(pd4j_link_method *link) {
+	pd4j_class_property *method = link->method;
+	
+	link->shape = pd4j_LINK_SHAPE_NONE;
+	
+	if (link->code == NULL || (method->accessFlags.method & pd4j_METHOD_ACC_SYNCHRONIZED) != 0) {
+		return;
+	}
+	
+	// match against the original code, before any instructions were quickened
+	uint8_t *code = link->codeAttribute->parsedData.code.code;
+	uint32_t codeLength = link->codeLength;
+	bool isStatic = (method->accessFlags.method & pd4j_METHOD_ACC_STATIC) != 0;
+	uint32_t numArgs = link->signature.numArgs;
+	
+	if (codeLength == 1 && code[0] == 0xb1) {
+		link->shape = pd4j_LINK_SHAPE_EMPTY;
+	}
+	else if (codeLength == 2 && code[0] >= 0x02 && code[0] <= 0x08 && code[1] == 0xac) {
+		link->shape = pd4j_LINK_SHAPE_CONSTANT;
+		link->shapeConstant = (int32_t)code[0] - 0x03;
+	}
+	else if (codeLength == 3 && code[0] == 0x10 && code[2] == 0xac) {
+		link->shape = pd4j_LINK_SHAPE_CONSTANT;
+		link->shapeConstant = (int32_t)((int8_t)code[1]);
+	}
+	else if (codeLength == 4 && code[0] == 0x11 && code[3] == 0xac) {
+		link->shape = pd4j_LINK_SHAPE_CONSTANT;
+		link->shapeConstant = (int32_t)((int16_t)((code[1] << 8) | code[2]));
+	}
+	else if (isStatic || code[0] != 0x2a) {
+		return;
+	}
+	else if (codeLength == 5 && numArgs == 0 && code[1] == 0xb4 && code[4] >= 0xac && code[4] <= 0xb0) {
+		link->shapeOperand = (uint16_t)((code[2] << 8) | code[3]);
+		if (pd4j_link_instance_field_slot(link->class, link->shapeOperand, &link->shapeSlot)) {
+			link->shape = pd4j_LINK_SHAPE_GETTER;
+		}
+	}
+	else if (codeLength == 6 && numArgs == 1 && (code[1] == 0x1b || code[1] == 0x1f || code[1] == 0x23 || code[1] == 0x27 || code[1] == 0x2b) && code[2] == 0xb5 && code[5] == 0xb1) {
+		link->shapeOperand = (uint16_t)((code[3] << 8) | code[4]);
+		if (pd4j_link_instance_field_slot(link->class, link->shapeOperand, &link->shapeSlot)) {
+			link->shape = pd4j_LINK_SHAPE_SETTER;
+		}
+	}
+	else if (codeLength == 5 && numArgs == 0 && code[1] == 0xb7 && code[4] == 0xb1 && strcmp((const char *)(method->name), "<init>") == 0) {
+		link->shape = pd4j_LINK_SHAPE_SUPER_INIT;
+	}
+}
+
+static bool pd4j_link_method_sign(pd4j_thread *thread, pd4j_link_method *link) {
+	pd4j_class_property *method = link->method;
+	pd4j_link_signature *signature = &link->signature;
+	pd4j_class_method_descriptor *descriptor = pd4j_class_property_method_descriptor(method, thread);
+	
+	if (descriptor == NULL) {
+		return false;
+	}
+	
+	signature->numArgs = descriptor->numArgs;
+	signature->numArgSlots = descriptor->numArgSlots;
+	if ((method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0) {
+		signature->numArgSlots++;
+	}
+	
+	signature->isSynchronized = (method->accessFlags.method & pd4j_METHOD_ACC_SYNCHRONIZED) != 0;
+	
+	switch (descriptor->returnType.kind) {
+		case 'V': signature->returnKind = pd4j_LINK_RETURN_VOID; break;
+		case 'I': signature->returnKind = pd4j_LINK_RETURN_INT; break;
+		case 'Z': signature->returnKind = pd4j_LINK_RETURN_BOOLEAN; break;
+		case 'B': signature->returnKind = pd4j_LINK_RETURN_BYTE; break;
+		case 'C': signature->returnKind = pd4j_LINK_RETURN_CHAR; break;
+		case 'S': signature->returnKind = pd4j_LINK_RETURN_SHORT; break;
+		case 'F': signature->returnKind = pd4j_LINK_RETURN_FLOAT; break;
+		case 'J': signature->returnKind = pd4j_LINK_RETURN_LONG; break;
+		case 'D': signature->returnKind = pd4j_LINK_RETURN_DOUBLE; break;
+		default: signature->returnKind = pd4j_LINK_RETURN_REFERENCE; break;
+	}
+	
+	return true;
+}
+
+pd4j_link_method *pd4j_link_method_get(pd4j_thread *thread, pd4j_class_reference *classRef, pd4j_class_property *method) {
+	if (method->link != NULL) {
+		return method->link;
+	}
+	
+	pd4j_thread_reference *mirror = pd4j_class_get_mirror(classRef, thread);
+	if (mirror == NULL) {
+		return NULL;
+	}
+	
+	// initializing the class may have linked this method already
+	if (method->link != NULL) {
+		return method->link;
+	}
+	
+	pd4j_link_method *link = pd4j_malloc(sizeof(pd4j_link_method));
+	if (link == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate linked method: Out of memory");
+		return NULL;
+	}
+	
+	link->class = classRef;
+	link->method = method;
+	link->codeAttribute = NULL;
+	link->nativeFunction = NULL;
+	link->codeLength = 0;
+	link->code = NULL;
+	link->numCallSites = 0;
+	link->callSites = NULL;
+	link->numSwitches = 0;
+	link->switches = NULL;
+	link->numHandlers = 0;
+	link->handlers = NULL;
+	link->numHandlerRanges = 0;
+	link->handlerRanges = NULL;
+	link->handlerOrderLength = 0;
+	link->handlerOrder = NULL;
+	link->verified = false;
+	link->numStackMaps = 0;
+	link->stackMaps = NULL;
+	link->numInstructions = 0;
+	link->numInstructionsRemoved = 0;
+	link->numJumpsThreaded = 0;
+	link->numChecksEliminated = 0;
+	link->shape = pd4j_LINK_SHAPE_NONE;
+	
+	pd4j_thread_reference *methodRef = pd4j_malloc(sizeof(pd4j_thread_reference));
+	if (methodRef == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate linked method reference: Out of memory");
+		pd4j_free(link, sizeof(pd4j_link_method));
+		return NULL;
+	}
+	
+	// the argument and return types are only resolved for references that come from the constant pool
+	methodRef->resolved = true;
+	methodRef->kind = ((classRef->data.class->accessFlags & pd4j_CLASS_ACC_INTERFACE) != 0) ? pd4j_REF_INTERFACE_METHOD : pd4j_REF_CLASS_METHOD;
+	methodRef->data.method.name = method->name;
+	methodRef->data.method.descriptor = method->descriptor;
+	methodRef->data.method.returnTypeDescriptor = NULL;
+	methodRef->data.method.argumentDescriptors = NULL;
+	methodRef->data.method.class = mirror;
+	methodRef->data.method.declaringClass = classRef;
+	methodRef->data.method.property = method;
+	methodRef->lockWord = 0;
+	
+	link->methodRef = methodRef;
+	
+	if (!pd4j_link_method_sign(thread, link)) {
+		pd4j_link_method_destroy(link);
+		return NULL;
+	}
+	
+	if ((method->accessFlags.method & (pd4j_METHOD_ACC_ABSTRACT | pd4j_METHOD_ACC_NATIVE)) == 0) {
+		link->codeAttribute = pd4j_class_property_attribute_name(method, (const uint8_t *)"Code");
+		
+		if (link->codeAttribute == NULL) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/ClassFormatError", "Malformed class file: Method has no Code attribute");
+			pd4j_link_method_destroy(link);
+			return NULL;
+		}
+		
+		if (!pd4j_verify_method(thread, link) || !pd4j_link_method_prepare_code(thread, link) || !pd4j_link_method_index_handlers(thread, link)) {
+			pd4j_link_method_destroy(link);
+			return NULL;
+		}
+		
+		pd4j_link_method_classify(link);
+	}
+	else if ((method->accessFlags.method & pd4j_METHOD_ACC_NATIVE) != 0) {
+		// looked up once here, so invoking the method never has to compare names
+		link->nativeFunction = pd4j_native_find(classRef->name, method->name, method->descriptor);
+	}
+	
+	method->link = link;
+	return link;
+}
+
+pd4j_link_method *pd4j_link_method_from_reference(pd4j_thread *thread, pd4j_thread_reference *methodRef) {
+	if (methodRef->data.method.property != NULL) {
+		return pd4j_link_method_get(thread, methodRef->data.method.declaringClass, methodRef->data.method.property);
+	}
+	
+	pd4j_class_reference *classRef = methodRef->data.method.class->data.class.loaded;
+	
+	while (classRef != NULL && classRef->type == pd4j_CLASS_CLASS) {
+		pd4j_class_property *method = pd4j_link_find_method(classRef->data.class, methodRef->data.method.name, methodRef->data.method.descriptor);
+		
+		if (method != NULL) {
+			return pd4j_link_method_get(thread, classRef, method);
+		}
+		
+		classRef = pd4j_link_superclass(classRef);
+	}
+	
+	pd4j_thread_throw_class_with_message(thread, "java/lang/NoSuchMethodError", "No such method with the given descriptor in class");
+	return NULL;
+}
+
+void pd4j_link_method_destroy(pd4j_link_method *link) {
+	if (link->method->link == link) {
+		link->method->link = NULL;
+	}
+	
+	// stale megamorphic entries may point to this method
+	memset(megamorphicCache, 0, sizeof(megamorphicCache));
+	
+	if (dependencies != NULL) {
+		for (uint32_t i = dependencies->size; i > 0; i--) {
+			pd4j_link_dependency *dependency = dependencies->array[i - 1];
+			
+			if (dependency->caller == link || dependency->target == link->method) {
+				pd4j_free(pd4j_list_remove(dependencies, i - 1), sizeof(pd4j_link_dependency));
+			}
+		}
+	}
+	
+	if (link->callSites != NULL) {
+		pd4j_free(link->callSites, link->numCallSites * sizeof(pd4j_link_call_site));
+	}
+	
+	if (link->switches != NULL) {
+		for (uint16_t i = 0; i < link->numSwitches; i++) {
+			pd4j_link_switch_destroy(&link->switches[i]);
+		}
+		
+		pd4j_free(link->switches, link->numSwitches * sizeof(pd4j_link_switch));
+	}
+	
+	pd4j_link_method_destroy_handlers(link);
+	
+	if (link->code != NULL) {
+		pd4j_free(link->code, link->codeLength);
+	}
+	
+	pd4j_verify_destroy_stack_maps(link);
+	
+	if (link->methodRef != NULL) {
+		pd4j_free(link->methodRef, sizeof(pd4j_thread_reference));
+	}
+	
+	pd4j_free(link, sizeof(pd4j_link_method));
+}
+
+static pd4j_link_method *pd4j_link_select_special(pd4j_thread *thread, pd4j_link_method *caller, pd4j_thread_reference *resolvedMethod) {
+	pd4j_class_reference *callerClass = caller->class;
+	pd4j_class_reference *symbolicClass = resolvedMethod->data.method.class->data.class.loaded;
+	pd4j_class_property *resolved = resolvedMethod->data.method.property;
+	
+	bool selectFromSuper = strcmp((const char *)(resolvedMethod->data.method.name), "<init>") != 0;
+	selectFromSuper = selectFromSuper && (resolved->accessFlags.method & pd4j_METHOD_ACC_PRIVATE) == 0;
+	selectFromSuper = selectFromSuper && (symbolicClass->data.class->accessFlags & pd4j_CLASS_ACC_INTERFACE) == 0;
+	selectFromSuper = selectFromSuper && (callerClass->data.class->accessFlags & pd4j_CLASS_ACC_SUPER) != 0;
+	selectFromSuper = selectFromSuper && symbolicClass != callerClass && pd4j_class_is_subclass(callerClass, symbolicClass);
+	
+	if (selectFromSuper) {
+		for (pd4j_class_reference *classRef = pd4j_link_superclass(callerClass); classRef != NULL; classRef = pd4j_link_superclass(classRef)) {
+			pd4j_class_property *method = pd4j_link_find_method(classRef->data.class, resolvedMethod->data.method.name, resolvedMethod->data.method.descriptor);
+			
+			if (method != NULL) {
+				return pd4j_link_method_get(thread, classRef, method);
+			}
+		}
+	}
+	
+	return pd4j_link_method_get(thread, resolvedMethod->data.method.declaringClass, resolved);
+}
+
+static pd4j_link_method *pd4j_link_select(pd4j_thread *thread, pd4j_thread_reference *resolvedMethod, pd4j_class_reference *receiverClass) {
+	pd4j_class_property *resolved = resolvedMethod->data.method.property;
+	
+	if ((resolved->accessFlags.method & pd4j_METHOD_ACC_PRIVATE) != 0) {
+		return pd4j_link_method_get(thread, resolvedMethod->data.method.declaringClass, resolved);
+	}
+	
+	if (receiverClass->type != pd4j_CLASS_CLASS) {
+		// arrays only inherit the methods of java/lang/Object
+		receiverClass = pd4j_class_loader_get_loaded(receiverClass->definingLoader, (uint8_t *)"java/lang/Object");
+	}
+	
+	uint8_t *name = resolvedMethod->data.method.name;
+	uint8_t *descriptor = resolvedMethod->data.method.descriptor;
+	
+	for (pd4j_class_reference *classRef = receiverClass; classRef != NULL; classRef = pd4j_link_superclass(classRef)) {
+		pd4j_class_property *method = pd4j_link_find_method(classRef->data.class, name, descriptor);
+		
+		if (method != NULL && (method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0) {
+			return pd4j_link_method_get(thread, classRef, method);
+		}
+	}
+	
+	// no class in the hierarchy declares the method, so look for a default method among the superinterfaces
+	pd4j_list *interfaceStack = pd4j_list_new(4);
+	
+	for (pd4j_class_reference *classRef = receiverClass; classRef != NULL; classRef = pd4j_link_superclass(classRef)) {
+		pd4j_list_push(interfaceStack, classRef);
+	}
+	
+	while (interfaceStack->size > 0) {
+		pd4j_class_reference *classRef = pd4j_list_pop(interfaceStack);
+		
+		for (uint16_t i = 0; i < classRef->data.class->numSuperInterfaces; i++) {
+			pd4j_class_reference *interfaceRef = pd4j_class_loader_get_loaded(classRef->definingLoader, classRef->data.class->superInterfaces[i]);
+			if (interfaceRef == NULL || interfaceRef->type != pd4j_CLASS_CLASS) {
+				continue;
+			}
+			
+			pd4j_class_property *method = pd4j_link_find_method(interfaceRef->data.class, name, descriptor);
+			
+			if (method != NULL && (method->accessFlags.method & (pd4j_METHOD_ACC_ABSTRACT | pd4j_METHOD_ACC_STATIC | pd4j_METHOD_ACC_PRIVATE)) == 0) {
+				pd4j_list_destroy(interfaceStack);
+				return pd4j_link_method_get(thread, interfaceRef, method);
+			}
+			
+			pd4j_list_push(interfaceStack, interfaceRef);
+		}
+	}
+	
+	pd4j_list_destroy(interfaceStack);
+	
+	// invoking this will raise AbstractMethodError
+	return pd4j_link_method_get(thread, resolvedMethod->data.method.declaringClass, resolved);
+}
+
+static void pd4j_link_call_site_bind(pd4j_link_call_site *site, pd4j_link_method *target) {
+	site->entries[0].receiverClass = NULL;
+	site->entries[0].target = target;
+	site->numEntries = 1;
+	site->state = pd4j_CALL_SITE_BOUND;
+}
+
+// binds an invokevirtual site directly to its target when class hierarchy analysis shows it is the only one
+static bool pd4j_link_call_site_devirtualize(pd4j_thread *thread, pd4j_link_method *caller, pd4j_link_call_site *site, bool *failed) {
+	pd4j_class_reference *declaringClass = site->resolvedMethod->data.method.declaringClass;
+	pd4j_class_property *resolved = site->resolvedMethod->data.method.property;
+	
+	*failed = false;
+	
+	if ((resolved->accessFlags.method & pd4j_METHOD_ACC_ABSTRACT) != 0 || (declaringClass->data.class->accessFlags & pd4j_CLASS_ACC_INTERFACE) != 0) {
+		return false;
+	}
+	
+	bool cannotOverride = (resolved->accessFlags.method & (pd4j_METHOD_ACC_PRIVATE | pd4j_METHOD_ACC_FINAL)) != 0 || (declaringClass->data.class->accessFlags & pd4j_CLASS_ACC_FINAL) != 0;
+	
+	if (!cannotOverride && resolved->overridden) {
+		return false;
+	}
+	
+	pd4j_link_method *target = pd4j_link_method_get(thread, declaringClass, resolved);
+	if (target == NULL) {
+		*failed = true;
+		return false;
+	}
+	
+	if (!cannotOverride) {
+		if (dependencies == NULL) {
+			dependencies = pd4j_list_new(4);
+		}
+		
+		pd4j_link_dependency *dependency = pd4j_malloc(sizeof(pd4j_link_dependency));
+		if (dependency == NULL) {
+			// the site still works through the inline caches
+			return false;
+		}
+		
+		dependency->target = resolved;
+		dependency->caller = caller;
+		dependency->site = site;
+		pd4j_list_add(dependencies, dependency);
+	}
+	
+	pd4j_link_call_site_bind(site, target);
+	site->state = cannotOverride ? pd4j_CALL_SITE_BOUND : pd4j_CALL_SITE_DEVIRTUALIZED;
+	caller->code[site->pcOffset] = pd4j_OPCODE_INVOKEDIRECT_QUICK;
+	
+	return true;
+}
+
+static void pd4j_link_invalidate_dependents(pd4j_class_property *method) {
+	if (dependencies == NULL) {
+		return;
+	}
+	
+	for (uint32_t i = dependencies->size; i > 0; i--) {
+		pd4j_link_dependency *dependency = dependencies->array[i - 1];
+		
+		if (dependency->target == method) {
+			pd4j_link_call_site *site = dependency->site;
+			
+			site->state = pd4j_CALL_SITE_UNINITIALIZED;
+			site->numEntries = 0;
+			dependency->caller->code[site->pcOffset] = pd4j_OPCODE_INVOKEVIRTUAL_QUICK;
+			
+			pd4j_free(pd4j_list_remove(dependencies, i - 1), sizeof(pd4j_link_dependency));
+		}
+	}
+}
+
+void pd4j_link_class_loaded(pd4j_class_reference *classRef) {
+	if (classRef->type != pd4j_CLASS_CLASS) {
+		return;
+	}
+	
+	pd4j_class *class = classRef->data.class;
+	
+	for (uint16_t i = 0; i < class->numMethods; i++) {
+		pd4j_class_property *method = &class->methods[i];
+		
+		if ((method->accessFlags.method & (pd4j_METHOD_ACC_STATIC | pd4j_METHOD_ACC_PRIVATE)) != 0 || method->name[0] == '<') {
+			continue;
+		}
+		
+		for (pd4j_class_reference *superRef = pd4j_link_superclass(classRef); superRef != NULL; superRef = pd4j_link_superclass(superRef)) {
+			pd4j_class_property *overridden = pd4j_link_find_method(superRef->data.class, method->name, method->descriptor);
+			
+			if (overridden == NULL) {
+				continue;
+			}
+			
+			if ((overridden->accessFlags.method & (pd4j_METHOD_ACC_STATIC | pd4j_METHOD_ACC_PRIVATE)) == 0 && !(overridden->overridden)) {
+				overridden->overridden = true;
+				pd4j_link_invalidate_dependents(overridden);
+			}
+			
+			break;
+		}
+	}
+}
+
+bool pd4j_link_call_site_resolve(pd4j_thread *thread, pd4j_link_method *caller, pd4j_link_call_site *site) {
+	pd4j_class_reference *callerClass = caller->class;
+	pd4j_class_constant *constant = &callerClass->data.class->constantPool[site->constantIndex - 1];
+	pd4j_thread_stack_entry *entry = NULL;
+	bool resolved;
+	
+	if (constant->tag == pd4j_CONSTANT_INTERFACEMETHODREF) {
+		resolved = pd4j_resolve_interface_method_reference(&entry, thread, constant, callerClass);
+	}
+	else {
+		resolved = pd4j_resolve_class_method_reference(&entry, thread, constant, callerClass);
+	}
+	
+	if (!resolved || entry == NULL) {
+		return false;
+	}
+	
+	pd4j_thread_reference *methodRef = entry->data.referenceValue;
+	bool isStatic = (methodRef->data.method.property->accessFlags.method & pd4j_METHOD_ACC_STATIC) != 0;
+	
+	if (isStatic != (site->opcode == 0xb8)) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", isStatic ? "Instance method invocation refers to a static method" : "Static method invocation refers to an instance method");
+		return false;
+	}
+	
+	pd4j_class_method_descriptor *descriptor = pd4j_class_property_method_descriptor(methodRef->data.method.property, thread);
+	if (descriptor == NULL) {
+		return false;
+	}
+	
+	site->resolvedMethod = methodRef;
+	site->numArgSlots = descriptor->numArgSlots;
+	
+	switch (site->opcode) {
+		case 0xb7: {
+			pd4j_link_method *target = pd4j_link_select_special(thread, caller, methodRef);
+			if (target == NULL) {
+				return false;
+			}
+			
+			pd4j_link_call_site_bind(site, target);
+			break;
+		}
+		case 0xb8: {
+			pd4j_link_method *target = pd4j_link_method_get(thread, methodRef->data.method.declaringClass, methodRef->data.method.property);
+			if (target == NULL) {
+				return false;
+			}
+			
+			pd4j_link_call_site_bind(site, target);
+			break;
+		}
+		default: {
+			site->state = pd4j_CALL_SITE_UNINITIALIZED;
+			
+			bool failed;
+			if (site->opcode == 0xb6 && !pd4j_link_call_site_devirtualize(thread, caller, site, &failed) && failed) {
+				return false;
+			}
+			break;
+		}
+	}
+	
+	return true;
+}
+
+pd4j_link_method *pd4j_link_call_site_dispatch(pd4j_thread *thread, pd4j_link_call_site *site, pd4j_class_reference *receiverClass) {
+	for (uint8_t i = 0; i < site->numEntries; i++) {
+		if (site->entries[i].receiverClass == receiverClass) {
+			site->hits++;
+			return site->entries[i].target;
+		}
+	}
+	
+	pd4j_class_property *resolved = site->resolvedMethod->data.method.property;
+	
+	if (site->state == pd4j_CALL_SITE_MEGAMORPHIC) {
+		site->megamorphicCalls++;
+		
+		uintptr_t hash = (((uintptr_t)receiverClass >> 4) ^ ((uintptr_t)resolved >> 4)) & (PD4J_LINK_MEGAMORPHIC_CACHE_SIZE - 1);
+		pd4j_link_megamorphic_entry *entry = &megamorphicCache[hash];
+		
+		if (entry->receiverClass == receiverClass && entry->resolvedMethod == resolved) {
+			return entry->target;
+		}
+		
+		pd4j_link_method *target = pd4j_link_select(thread, site->resolvedMethod, receiverClass);
+		
+		if (target != NULL) {
+			entry->receiverClass = receiverClass;
+			entry->resolvedMethod = resolved;
+			entry->target = target;
+		}
+		
+		return target;
+	}
+	
+	pd4j_link_method *target = pd4j_link_select(thread, site->resolvedMethod, receiverClass);
+	if (target == NULL) {
+		return NULL;
+	}
+	
+	site->misses++;
+	
+	if (site->numEntries < PD4J_LINK_POLYMORPHIC_ENTRIES) {
+		site->entries[site->numEntries].receiverClass = receiverClass;
+		site->entries[site->numEntries].target = target;
+		site->numEntries++;
+		
+		site->state = (site->numEntries == 1) ? pd4j_CALL_SITE_MONOMORPHIC : pd4j_CALL_SITE_POLYMORPHIC;
+	}
+	else {
+		// stop growing the cache; the entries stay valid and are still checked first
+		site->state = pd4j_CALL_SITE_MEGAMORPHIC;
+	}
+	
+	return target;
+}
+
+void pd4j_link_log_call_sites(pd4j_class_reference *classRef) {
+	if (classRef->type != pd4j_CLASS_CLASS) {
+		return;
+	}
+	
+	pd4j_class *class = classRef->data.class;
+	
+	for (uint16_t i = 0; i < class->numMethods; i++) {
+		pd4j_link_method *link = class->methods[i].link;
+		
+		if (link == NULL) {
+			continue;
+		}
+		
+		for (uint16_t j = 0; j < link->numCallSites; j++) {
+			pd4j_link_call_site *site = &link->callSites[j];
+			
+			pd->system->logToConsole("%s.%s%s @%d: %s, %d hits, %d misses, %d megamorphic calls", (char *)(class->thisClass), (char *)(class->methods[i].name), (char *)(class->methods[i].descriptor), site->pcOffset, pd4j_link_call_site_state_names[site->state], site->hits, site->misses, site->megamorphicCalls);
+		}
+	}
+}
+
+void pd4j_link_log_optimizations(pd4j_class_reference *classRef) {
+	if (classRef->type != pd4j_CLASS_CLASS) {
+		return;
+	}
+	
+	pd4j_class *class = classRef->data.class;
+	
+	for (uint16_t i = 0; i < class->numMethods; i++) {
+		pd4j_link_method *link = class->methods[i].link;
+		
+		if (link == NULL || link->code == NULL) {
+			continue;
+		}
+		
+		pd->system->logToConsole("%s.%s%s: %d of %d instructions removed, %d jumps threaded, %d array checks eliminated", (char *)(class->thisClass), (char *)(class->methods[i].name), (char *)(class->methods[i].descriptor), link->numInstructionsRemoved, link->numInstructions, link->numJumpsThreaded, link->numChecksEliminated);
+	}
+}
+
+#ifdef PD4J_PROFILE_OPCODES
+// number of distinct sequences the profile can hold (must be a power of two)
+#define PD4J_LINK_PROFILE_SIZE 4096
+
+typedef struct {
+	// opcodes packed with the most recent one in the low byte
+	uint32_t sequence;
+	uint8_t length;
+	uint32_t count;
+} pd4j_link_profile_entry;
+
+static pd4j_link_profile_entry *opcodeProfile = NULL;
+static uint32_t droppedSequences = 0;
+
+// the instructions that ran one after another without a jump, up to the last one
+static uint32_t recentOpcodes = 0;
+static uint8_t numRecentOpcodes = 0;
+static uint8_t *expectedPc = NULL;
+
+static void pd4j_link_profile_count(uint32_t sequence, uint8_t length) {
+	uint32_t idx = (sequence * 2654435761u + length) & (PD4J_LINK_PROFILE_SIZE - 1);
+	
+	for (uint32_t i = 0; i < PD4J_LINK_PROFILE_SIZE; i++) {
+		pd4j_link_profile_entry *entry = &opcodeProfile[(idx + i) & (PD4J_LINK_PROFILE_SIZE - 1)];
+		
+		if (entry->count == 0) {
+			entry->sequence = sequence;
+			entry->length = length;
+		}
+		
+		if (entry->sequence == sequence && entry->length == length) {
+			entry->count++;
+			return;
+		}
+	}
+	
+	droppedSequences++;
+}
+
+void pd4j_link_profile_instruction(uint8_t *pc) {
+	if (opcodeProfile == NULL) {
+		opcodeProfile = pd4j_malloc(PD4J_LINK_PROFILE_SIZE * sizeof(pd4j_link_profile_entry));
+		
+		if (opcodeProfile == NULL) {
+			return;
+		}
+		memset(opcodeProfile, 0, PD4J_LINK_PROFILE_SIZE * sizeof(pd4j_link_profile_entry));
+	}
+	
+	uint8_t opcode = *pc;
+	
+	// a superinstruction can only stand for instructions that sit next to each other in the code
+	if (pc != expectedPc) {
+		numRecentOpcodes = 0;
+	}
+	
+	recentOpcodes = (recentOpcodes << 8) | opcode;
+	if (numRecentOpcodes < PD4J_LINK_MAX_FUSED) {
+		numRecentOpcodes++;
+	}
+	
+	for (uint8_t length = 2; length <= numRecentOpcodes; length++) {
+		pd4j_link_profile_count((length == 4) ? recentOpcodes : recentOpcodes & ((1u << (8 * length)) - 1), length);
+	}
+	
+	// the switches are aligned relative to the start of the code, which isn't known here, but they always jump anyway
+	expectedPc = (opcode == 0xaa || opcode == 0xab) ? NULL : pc + pd4j_link_instruction_length(pc, 0);
+}
+
+void pd4j_link_log_opcode_profile(void) {
+	if (opcodeProfile == NULL) {
+		return;
+	}
+	
+	for (uint32_t i = 0; i < PD4J_LINK_PROFILE_SIZE; i++) {
+		pd4j_link_profile_entry *entry = &opcodeProfile[i];
+		char sequence[3 * PD4J_LINK_MAX_FUSED];
+		
+		if (entry->count == 0) {
+			continue;
+		}
+		
+		for (uint8_t j = 0; j < entry->length; j++) {
+			uint8_t opcode = (uint8_t)(entry->sequence >> (8 * (entry->length - 1 - j)));
+			
+			sequence[3 * j] = "0123456789abcdef"[opcode >> 4];
+			sequence[3 * j + 1] = "0123456789abcdef"[opcode & 0xf];
+			sequence[3 * j + 2] = ' ';
+		}
+		sequence[3 * entry->length - 1] = '\0';
+		
+		pd->system->logToConsole("opcode sequence %s: %u", sequence, entry->count);
+	}
+	
+	if (droppedSequences != 0) {
+		pd->system->logToConsole("opcode profile full, %u sequences not counted", droppedSequences);
+	}
+}
+#else
+void pd4j_link_profile_instruction(uint8_t *pc) {
+	(void)pc;
+}
+
+void pd4j_link_log_opcode_profile(void) {
+	pd->system->logToConsole("opcode profiling is disabled; rebuild with PD4J_PROFILE_OPCODES to enable it");
+}
+#endif
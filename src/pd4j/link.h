@@ -0,0 +1,237 @@
+#ifndef PD4J_LINK_H
+#define PD4J_LINK_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "class.h"
+#include "native.h"
+#include "thread.h"
+#include "verify.h"
+
+// number of receiver classes a call site remembers before it goes megamorphic
+#define PD4J_LINK_POLYMORPHIC_ENTRIES 4
+
+// internal opcodes written over the linked copy of a method's code, taken from the range the JVM specification leaves unused
+typedef enum {
+	pd4j_OPCODE_INVOKEVIRTUAL_QUICK = 0xcb,
+	pd4j_OPCODE_INVOKESPECIAL_QUICK = 0xcc,
+	pd4j_OPCODE_INVOKESTATIC_QUICK = 0xcd,
+	pd4j_OPCODE_INVOKEINTERFACE_QUICK = 0xce,
+	// invokevirtual bound to a single target
+	pd4j_OPCODE_INVOKEDIRECT_QUICK = 0xcf,
+	
+	// superinstructions, written over the first opcode of a sequence whose other instructions are left in place
+	pd4j_OPCODE_ALOAD_0_GETFIELD = 0xd0,
+	pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE = 0xd1,
+	pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT = 0xd2,
+	pd4j_OPCODE_ALOAD_ILOAD_IALOAD = 0xd3,
+	
+	// array accesses proven to be in bounds of a non-null array; the load works for every element type
+	pd4j_OPCODE_XALOAD_UNCHECKED = 0xd4,
+	// iastore, bastore, castore and sastore
+	pd4j_OPCODE_IASTORE_UNCHECKED = 0xd5,
+	pd4j_OPCODE_LASTORE_UNCHECKED = 0xd6,
+	pd4j_OPCODE_FASTORE_UNCHECKED = 0xd7,
+	pd4j_OPCODE_DASTORE_UNCHECKED = 0xd8,
+	
+	// switches dispatched through a pd4j_link_switch, whose index replaces the default offset in the code
+	pd4j_OPCODE_TABLESWITCH_QUICK = 0xd9,
+	pd4j_OPCODE_LOOKUPSWITCH_QUICK = 0xda
+} pd4j_link_opcode;
+
+// longest instruction sequence a superinstruction can stand for
+#define PD4J_LINK_MAX_FUSED 4
+
+typedef struct {
+	uint8_t fusedOpcode;
+	uint8_t length;
+	uint8_t opcodes[PD4J_LINK_MAX_FUSED];
+} pd4j_link_superinstruction;
+
+// a tableswitch or lookupswitch decoded when its method was linked, with offsets from the switch instruction
+// a lookupswitch whose keys are dense enough is decoded into a table like a tableswitch, without keys
+typedef struct {
+	int32_t defaultOffset;
+	int32_t lowValue;
+	uint32_t numEntries;
+	// sorted keys of a lookupswitch searched by binary search, or NULL if offsets is indexed by value - lowValue
+	int32_t *keys;
+	int32_t *offsets;
+} pd4j_link_switch;
+
+// an entry of a method's exception table, with offsets into its code
+typedef struct {
+	uint16_t startPc;
+	uint16_t endPc;
+	uint16_t handlerPc;
+	
+	// NULL for handlers that catch everything
+	uint8_t *catchTypeName;
+	// resolved the first time an exception reaches the handler
+	pd4j_thread_reference *catchType;
+} pd4j_link_handler;
+
+// a stretch of code that every handler covering any of it covers all of, up to where the next range starts
+typedef struct {
+	uint16_t startPc;
+	// the handlers covering the range are handlerOrder[firstHandler] onwards, in the order they're tried
+	uint16_t firstHandler;
+	uint16_t numHandlers;
+} pd4j_link_handler_range;
+
+// what a method returns, with the int types that ireturn narrows kept apart
+typedef enum {
+	pd4j_LINK_RETURN_VOID = 0,
+	pd4j_LINK_RETURN_INT,
+	pd4j_LINK_RETURN_BOOLEAN,
+	pd4j_LINK_RETURN_BYTE,
+	pd4j_LINK_RETURN_CHAR,
+	pd4j_LINK_RETURN_SHORT,
+	pd4j_LINK_RETURN_FLOAT,
+	pd4j_LINK_RETURN_LONG,
+	pd4j_LINK_RETURN_DOUBLE,
+	pd4j_LINK_RETURN_REFERENCE
+} pd4j_link_return_kind;
+
+// what calling and returning from a method needs to know about it, worked out once when it's linked
+typedef struct {
+	// arguments declared by the descriptor, not counting the receiver
+	uint16_t numArgs;
+	// slots taken by the arguments, including the receiver, which become the first local variables of the frame
+	uint16_t numArgSlots;
+	uint8_t returnKind;
+	bool isSynchronized;
+} pd4j_link_signature;
+
+typedef enum {
+	pd4j_CALL_SITE_UNRESOLVED = 0,
+	pd4j_CALL_SITE_UNINITIALIZED,
+	pd4j_CALL_SITE_MONOMORPHIC,
+	pd4j_CALL_SITE_POLYMORPHIC,
+	pd4j_CALL_SITE_MEGAMORPHIC,
+	pd4j_CALL_SITE_BOUND,
+	// bound because no loaded class overrides the target, reverts to UNINITIALIZED when one does
+	pd4j_CALL_SITE_DEVIRTUALIZED
+} pd4j_link_call_site_state;
+
+// method bodies simple enough to run at the call site without a frame
+typedef enum {
+	pd4j_LINK_SHAPE_NONE = 0,
+	// return
+	pd4j_LINK_SHAPE_EMPTY,
+	// aload_0, getfield, <t>return
+	pd4j_LINK_SHAPE_GETTER,
+	// aload_0, <t>load_1, putfield, return
+	pd4j_LINK_SHAPE_SETTER,
+	// iconst_<i>/bipush/sipush, ireturn
+	pd4j_LINK_SHAPE_CONSTANT,
+	// aload_0, invokespecial, return (in a constructor, empty once the called constructor is)
+	pd4j_LINK_SHAPE_SUPER_INIT
+} pd4j_link_method_shape;
+
+typedef struct {
+	pd4j_class_reference *receiverClass;
+	pd4j_link_method *target;
+} pd4j_link_cache_entry;
+
+typedef struct {
+	// offset of the invoke instruction and the constant pool index it originally referred to
+	uint16_t pcOffset;
+	uint16_t constantIndex;
+	uint8_t opcode;
+	
+	pd4j_link_call_site_state state;
+	
+	pd4j_thread_reference *resolvedMethod;
+	// operand stack slots taken by the arguments, not counting the receiver
+	uint16_t numArgSlots;
+	
+	uint8_t numEntries;
+	pd4j_link_cache_entry entries[PD4J_LINK_POLYMORPHIC_ENTRIES];
+	
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t megamorphicCalls;
+} pd4j_link_call_site;
+
+struct pd4j_link_method {
+	pd4j_class_reference *class;
+	pd4j_class_property *method;
+	
+	// canonical reference used as the currentMethod of frames running this method
+	pd4j_thread_reference *methodRef;
+	
+	// NULL for abstract and native methods
+	pd4j_class_attribute *codeAttribute;
+	// the function bound to a native method when it's linked, or NULL if none was registered for it
+	pd4j_native_function nativeFunction;
+	
+	// copy of the code that the interpreter runs, with quickened instructions
+	uint32_t codeLength;
+	uint8_t *code;
+	
+	pd4j_link_signature signature;
+	
+	pd4j_link_method_shape shape;
+	// field reference index for getters and setters, and the index of that field in instances of the class
+	uint16_t shapeOperand;
+	uint16_t shapeSlot;
+	int32_t shapeConstant;
+	
+	uint16_t numCallSites;
+	pd4j_link_call_site *callSites;
+	
+	uint16_t numSwitches;
+	pd4j_link_switch *switches;
+	
+	// the exception table, with ranges sorted by offset and split wherever a handler starts or ends
+	uint16_t numHandlers;
+	pd4j_link_handler *handlers;
+	uint16_t numHandlerRanges;
+	pd4j_link_handler_range *handlerRanges;
+	uint32_t handlerOrderLength;
+	uint16_t *handlerOrder;
+	
+	// false for code that's only run because of PD4J_TRUST_UNVERIFIED, which is left unoptimized since nothing proved what the optimizations assume
+	bool verified;
+	// decoded StackMapTable frames, sorted by offset (empty if the method wasn't verified)
+	uint16_t numStackMaps;
+	pd4j_verify_stack_map *stackMaps;
+	
+	// counts from the peephole optimizer, which rewrites the code in place when the method is linked
+	uint16_t numInstructions;
+	uint16_t numInstructionsRemoved;
+	uint16_t numJumpsThreaded;
+	// array accesses in counted loops that run without null and bounds checks
+	uint16_t numChecksEliminated;
+};
+
+uint32_t pd4j_link_instruction_length(uint8_t *code, uint32_t offset);
+
+pd4j_link_method *pd4j_link_method_get(pd4j_thread *thread, pd4j_class_reference *classRef, pd4j_class_property *method);
+pd4j_link_method *pd4j_link_method_from_reference(pd4j_thread *thread, pd4j_thread_reference *methodRef);
+void pd4j_link_method_destroy(pd4j_link_method *link);
+
+bool pd4j_link_call_site_resolve(pd4j_thread *thread, pd4j_link_method *caller, pd4j_link_call_site *site);
+pd4j_link_method *pd4j_link_call_site_dispatch(pd4j_thread *thread, pd4j_link_call_site *site, pd4j_class_reference *receiverClass);
+
+// finds the first handler in the method that covers the instruction at pcOffset and catches the class, or sets *outHandler to NULL
+// only returns false if resolving a catch type threw
+bool pd4j_link_find_handler(pd4j_thread *thread, pd4j_link_method *link, uint32_t pcOffset, pd4j_class_reference *thrownClass, pd4j_link_handler **outHandler);
+
+// records the methods the newly loaded class overrides and unbinds the call sites that depended on them
+void pd4j_link_class_loaded(pd4j_class_reference *classRef);
+
+// writes the state and counters of every call site in the linked methods of a class to the console
+void pd4j_link_log_call_sites(pd4j_class_reference *classRef);
+// writes how many instructions the peephole optimizer removed and array checks were eliminated in each linked method of a class to the console
+void pd4j_link_log_optimizations(pd4j_class_reference *classRef);
+
+// counts the sequences of up to PD4J_LINK_MAX_FUSED instructions that run one after another, in builds with PD4J_PROFILE_OPCODES
+// superinstructions aren't applied in these builds, so the counts are for the original instructions
+void pd4j_link_profile_instruction(uint8_t *pc);
+// writes the counts to the console in the format tools/superinstructions.py reads
+void pd4j_link_log_opcode_profile(void);
+
+#endif
\ No newline at end of file
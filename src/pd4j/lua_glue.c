@@ -4,8 +4,11 @@
 #include "api_ptr.h"
 #include "class.h"
 #include "class_loader.h"
+#include "link.h"
 #include "lua_glue.h"
 #include "memory.h"
+#include "native.h"
+#include "scheduler.h"
 #include "thread.h"
 #include "utf8.h"
 
@@ -371,9 +374,14 @@ static int pd4j_lua_glue_thread_pop(lua_State *L) {
 		return 0;
 	}
 	
-	pd4j_thread_stack_entry *value = pd4j_thread_arg_pop(thread);
+	// the pd4j.value gets its own copy, which outlives the argStack slot
+	pd4j_thread_stack_entry *value = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
 	
-	if (value == NULL) {
+	if (value == NULL || !pd4j_thread_arg_pop(thread, value)) {
+		if (value != NULL) {
+			pd4j_free(value, sizeof(pd4j_thread_stack_entry));
+		}
+		
 		pd->lua->pushNil();
 		return 1;
 	}
@@ -393,6 +401,88 @@ static int pd4j_lua_glue_thread_invokeInstanceMethod(lua_State *L) {
 	return 0;
 }
 
+// calls a registered native without going through the interpreter, writing the pd4j.values after the descriptor straight into its argument slots
+static int pd4j_lua_glue_thread_callNative(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0) {
+		pd->system->error("argument #1 to pd4j.thread:callNative() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread *thread = pd->lua->getArgObject(1, "pd4j.thread", NULL);
+	
+	if (thread == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:callNative() should be a pd4j.thread");
+		return 0;
+	}
+	
+	if (argc < 4 || pd->lua->getArgType(2, NULL) != kTypeString || pd->lua->getArgType(3, NULL) != kTypeString || pd->lua->getArgType(4, NULL) != kTypeString) {
+		pd->system->error("arguments #2 to #4 to pd4j.thread:callNative() should be strings representing an internal class name, a method name and a method descriptor");
+		return 0;
+	}
+	
+	uint8_t *names[3];
+	size_t nameLengths[3];
+	
+	for (int i = 0; i < 3; i++) {
+		size_t len;
+		const char *str = pd->lua->getArgBytes(i + 2, &len);
+		
+		nameLengths[i] = pd4j_utf8_to_java(&names[i], str, len);
+	}
+	
+	pd4j_native_function function = pd4j_native_find(names[0], names[1], names[2]);
+	
+	for (int i = 0; i < 3; i++) {
+		pd4j_free(names[i], nameLengths[i]);
+	}
+	
+	if (function == NULL) {
+		pd->system->error("pd4j.thread:callNative() was given a method with no registered native");
+		return 0;
+	}
+	
+	pd4j_thread_variable args[PD4J_THREAD_MAX_ARGS];
+	uint16_t numSlots = 0;
+	
+	for (int i = 5; i <= argc; i++) {
+		const char *luaObjName;
+		
+		if (pd->lua->getArgType(i, &luaObjName) != kTypeObject || strcmp(luaObjName, "pd4j.value") != 0) {
+			pd->system->error("argument #%d to pd4j.thread:callNative() should be a pd4j.value", i);
+			return 0;
+		}
+		
+		if (numSlots + 2 > PD4J_THREAD_MAX_ARGS) {
+			pd->system->error("too many arguments to pd4j.thread:callNative()");
+			return 0;
+		}
+		
+		numSlots += pd4j_native_set_arg(&args[numSlots], pd->lua->getArgObject(i, "pd4j.value", NULL));
+	}
+	
+	pd4j_thread_stack_entry result;
+	result.tag = pd4j_VARIABLE_NONE;
+	result.name = (uint8_t *)"(value returned to Lua code)";
+	
+	// an exception the native throws is left on the thread for pd4j.thread:printStackTrace()
+	if (!function(thread, args, &result) || result.tag == pd4j_VARIABLE_NONE) {
+		return 0;
+	}
+	
+	pd4j_thread_stack_entry *value = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
+	if (value == NULL) {
+		pd->lua->pushNil();
+		return 1;
+	}
+	
+	memcpy(value, &result, sizeof(pd4j_thread_stack_entry));
+	
+	pd->lua->pushObject(value, "pd4j.value", 0);
+	return 1;
+}
+
 static int pd4j_lua_glue_thread_execute(lua_State *L) {
 	int argc = pd->lua->getArgCount();
 	
@@ -413,6 +503,197 @@ static int pd4j_lua_glue_thread_execute(lua_State *L) {
 	}
 }
 
+static int pd4j_lua_glue_thread_run(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0) {
+		pd->system->error("argument #1 to pd4j.thread:run() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread *thread = pd->lua->getArgObject(1, "pd4j.thread", NULL);
+	
+	if (thread == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:run() should be a pd4j.thread");
+		return 0;
+	}
+	
+	uint32_t maxInstructions = 0;
+	uint32_t maxMicros = 0;
+	
+	if (argc >= 2 && pd->lua->getArgType(2, NULL) != kTypeNil) {
+		if (pd->lua->getArgType(2, NULL) != kTypeInt || pd->lua->getArgInt(2) < 0) {
+			pd->system->error("argument #2 to pd4j.thread:run() should be a non-negative integer instruction budget");
+			return 0;
+		}
+		
+		maxInstructions = (uint32_t)pd->lua->getArgInt(2);
+	}
+	
+	if (argc >= 3 && pd->lua->getArgType(3, NULL) != kTypeNil) {
+		if (pd->lua->getArgType(3, NULL) != kTypeInt || pd->lua->getArgInt(3) < 0) {
+			pd->system->error("argument #3 to pd4j.thread:run() should be a non-negative integer time budget in microseconds");
+			return 0;
+		}
+		
+		maxMicros = (uint32_t)pd->lua->getArgInt(3);
+	}
+	
+	pd->lua->pushInt(pd4j_thread_run(thread, maxInstructions, maxMicros));
+	return 1;
+}
+
+static int pd4j_lua_glue_thread_schedule(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0) {
+		pd->system->error("argument #1 to pd4j.thread:schedule() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread *thread = pd->lua->getArgObject(1, "pd4j.thread", NULL);
+	
+	if (thread == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:schedule() should be a pd4j.thread");
+		return 0;
+	}
+	
+	uint8_t priority = PD4J_SCHEDULER_NORM_PRIORITY;
+	
+	if (argc >= 2 && pd->lua->getArgType(2, NULL) != kTypeNil) {
+		if (pd->lua->getArgType(2, NULL) != kTypeInt || pd->lua->getArgInt(2) < PD4J_SCHEDULER_MIN_PRIORITY || pd->lua->getArgInt(2) > PD4J_SCHEDULER_MAX_PRIORITY) {
+			pd->system->error("argument #2 to pd4j.thread:schedule() should be an integer priority from 1 to 10");
+			return 0;
+		}
+		
+		priority = (uint8_t)pd->lua->getArgInt(2);
+	}
+	
+	pd4j_scheduler *scheduler = pd4j_scheduler_get_default();
+	
+	pd->lua->pushBool(scheduler != NULL && pd4j_scheduler_add(scheduler, thread, priority));
+	return 1;
+}
+
+static int pd4j_lua_glue_thread_runScheduled(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0 || pd->lua->getArgType(1, NULL) != kTypeInt || pd->lua->getArgInt(1) <= 0) {
+		pd->system->error("argument #1 to pd4j.thread.runScheduled() should be a positive integer time budget in microseconds");
+		return 0;
+	}
+	
+	pd4j_scheduler *scheduler = pd4j_scheduler_get_default();
+	
+	pd->lua->pushInt((scheduler == NULL) ? 0 : (int)pd4j_scheduler_run(scheduler, (uint32_t)pd->lua->getArgInt(1)));
+	return 1;
+}
+
+static int pd4j_lua_glue_thread_printStackTrace(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0) {
+		pd->system->error("argument #1 to pd4j.thread:printStackTrace() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread *thread = pd->lua->getArgObject(1, "pd4j.thread", NULL);
+	
+	if (thread == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:printStackTrace() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread_reference *throwable = pd4j_thread_get_exception(thread);
+	
+	if (throwable != NULL) {
+		pd4j_thread_print_stack_trace(throwable);
+	}
+	
+	return 0;
+}
+
+static int pd4j_lua_glue_thread_setMaxStackDepth(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0) {
+		pd->system->error("argument #1 to pd4j.thread:setMaxStackDepth() should be a pd4j.thread");
+		return 0;
+	}
+	
+	pd4j_thread *thread = pd->lua->getArgObject(1, "pd4j.thread", NULL);
+	
+	if (thread == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:setMaxStackDepth() should be a pd4j.thread");
+		return 0;
+	}
+	
+	if (argc < 2 || pd->lua->getArgType(2, NULL) != kTypeInt || pd->lua->getArgInt(2) <= 0) {
+		pd->system->error("argument #2 to pd4j.thread:setMaxStackDepth() should be a positive integer");
+		return 0;
+	}
+	
+	pd4j_thread_set_max_depth(thread, (uint32_t)(pd->lua->getArgInt(2)));
+	return 0;
+}
+
+static int pd4j_lua_glue_thread_logCallSites(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0 || pd->lua->getArgObject(1, "pd4j.thread", NULL) == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:logCallSites() should be a pd4j.thread");
+		return 0;
+	}
+	
+	const char *luaObjName;
+	
+	if (argc < 2 || pd->lua->getArgType(2, &luaObjName) != kTypeObject || strcmp(luaObjName, "pd4j.value") != 0) {
+		pd->system->error("argument #2 to pd4j.thread:logCallSites() should be a pd4j.value representing a Class object");
+		return 0;
+	}
+	
+	pd4j_thread_stack_entry *class = pd->lua->getArgObject(2, "pd4j.value", NULL);
+	
+	if (class->tag != pd4j_VARIABLE_REFERENCE || class->data.referenceValue->kind != pd4j_REF_CLASS) {
+		pd->system->error("argument #2 to pd4j.thread:logCallSites() should be a pd4j.value representing a Class object");
+		return 0;
+	}
+	
+	pd4j_link_log_call_sites(class->data.referenceValue->data.class.loaded);
+	return 0;
+}
+
+static int pd4j_lua_glue_thread_logOptimizations(lua_State *L) {
+	int argc = pd->lua->getArgCount();
+	
+	if (argc == 0 || pd->lua->getArgObject(1, "pd4j.thread", NULL) == NULL) {
+		pd->system->error("argument #1 to pd4j.thread:logOptimizations() should be a pd4j.thread");
+		return 0;
+	}
+	
+	const char *luaObjName;
+	
+	if (argc < 2 || pd->lua->getArgType(2, &luaObjName) != kTypeObject || strcmp(luaObjName, "pd4j.value") != 0) {
+		pd->system->error("argument #2 to pd4j.thread:logOptimizations() should be a pd4j.value representing a Class object");
+		return 0;
+	}
+	
+	pd4j_thread_stack_entry *class = pd->lua->getArgObject(2, "pd4j.value", NULL);
+	
+	if (class->tag != pd4j_VARIABLE_REFERENCE || class->data.referenceValue->kind != pd4j_REF_CLASS) {
+		pd->system->error("argument #2 to pd4j.thread:logOptimizations() should be a pd4j.value representing a Class object");
+		return 0;
+	}
+	
+	pd4j_link_log_optimizations(class->data.referenceValue->data.class.loaded);
+	return 0;
+}
+
+static int pd4j_lua_glue_thread_logOpcodeProfile(lua_State *L) {
+	pd4j_link_log_opcode_profile();
+	return 0;
+}
+
 static int pd4j_lua_glue_thread_gc(lua_State *L) {
 	int argc = pd->lua->getArgCount();
 	
@@ -676,12 +957,25 @@ static const lua_reg threadFunctions[] = {
 	{"pop", &pd4j_lua_glue_thread_pop},
 	{"invokeStaticMethod", &pd4j_lua_glue_thread_invokeStaticMethod},
 	{"invokeInstanceMethod", &pd4j_lua_glue_thread_invokeInstanceMethod},
+	{"callNative", &pd4j_lua_glue_thread_callNative},
 	{"execute", &pd4j_lua_glue_thread_execute},
+	{"run", &pd4j_lua_glue_thread_run},
+	{"schedule", &pd4j_lua_glue_thread_schedule},
+	{"runScheduled", &pd4j_lua_glue_thread_runScheduled},
+	{"printStackTrace", &pd4j_lua_glue_thread_printStackTrace},
+	{"setMaxStackDepth", &pd4j_lua_glue_thread_setMaxStackDepth},
+	{"logCallSites", &pd4j_lua_glue_thread_logCallSites},
+	{"logOptimizations", &pd4j_lua_glue_thread_logOptimizations},
+	{"logOpcodeProfile", &pd4j_lua_glue_thread_logOpcodeProfile},
 	{"__gc", &pd4j_lua_glue_thread_gc},
 	{NULL, NULL}
 };
 
 static const lua_val threadValues[] = {
+	{"kRunFinished", kInt, {pd4j_THREAD_RUN_FINISHED}},
+	{"kRunBudgetExhausted", kInt, {pd4j_THREAD_RUN_BUDGET_EXHAUSTED}},
+	{"kRunBlocked", kInt, {pd4j_THREAD_RUN_BLOCKED}},
+	{"kRunThrew", kInt, {pd4j_THREAD_RUN_THREW}},
 	{NULL, kInt, {0}}
 };
 
@@ -0,0 +1,81 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "api_ptr.h"
+#include "memory.h"
+#include "native.h"
+#include "scheduler.h"
+#include "thread.h"
+
+typedef struct pd4j_native_entry {
+	const pd4j_native_method *method;
+	uint32_t hash;
+	struct pd4j_native_entry *next;
+} pd4j_native_entry;
+
+static pd4j_native_entry *nativeTable[PD4J_NATIVE_TABLE_SIZE];
+
+// FNV-1a over the class name, method name and descriptor, with a zero byte between each
+static uint32_t pd4j_native_hash(const uint8_t *className, const uint8_t *name, const uint8_t *descriptor) {
+	const uint8_t *parts[3] = {className, name, descriptor};
+	uint32_t hash = 2166136261u;
+	
+	for (uint32_t i = 0; i < 3; i++) {
+		for (const uint8_t *c = parts[i]; *c != '\0'; c++) {
+			hash = (hash ^ *c) * 16777619u;
+		}
+		
+		hash *= 16777619u;
+	}
+	
+	return hash;
+}
+
+bool pd4j_native_register(const pd4j_native_method *methods, uint32_t numMethods) {
+	for (uint32_t i = 0; i < numMethods; i++) {
+		const pd4j_native_method *method = &methods[i];
+		uint32_t hash = pd4j_native_hash((const uint8_t *)(method->className), (const uint8_t *)(method->name), (const uint8_t *)(method->descriptor));
+		pd4j_native_entry **bucket = &nativeTable[hash & (PD4J_NATIVE_TABLE_SIZE - 1)];
+		pd4j_native_entry *entry = *bucket;
+		
+		while (entry != NULL && (entry->hash != hash || strcmp(entry->method->className, method->className) != 0 || strcmp(entry->method->name, method->name) != 0 || strcmp(entry->method->descriptor, method->descriptor) != 0)) {
+			entry = entry->next;
+		}
+		
+		if (entry != NULL) {
+			entry->method = method;
+			continue;
+		}
+		
+		entry = pd4j_malloc(sizeof(pd4j_native_entry));
+		if (entry == NULL) {
+			return false;
+		}
+		
+		entry->method = method;
+		entry->hash = hash;
+		entry->next = *bucket;
+		*bucket = entry;
+	}
+	
+	return true;
+}
+
+pd4j_native_function pd4j_native_find(uint8_t *className, uint8_t *name, uint8_t *descriptor) {
+	uint32_t hash = pd4j_native_hash(className, name, descriptor);
+	
+	for (pd4j_native_entry *entry = nativeTable[hash & (PD4J_NATIVE_TABLE_SIZE - 1)]; entry != NULL; entry = entry->next) {
+		if (entry->hash == hash && strcmp(entry->method->className, (const char *)className) == 0 && strcmp(entry->method->name, (const char *)name) == 0 && strcmp(entry->method->descriptor, (const char *)descriptor) == 0) {
+			return entry->method->function;
+		}
+	}
+	
+	return NULL;
+}
+
+void pd4j_native_register_all(void) {
+	if (!pd4j_thread_register_natives() || !pd4j_scheduler_register_natives()) {
+		pd->system->error("Unable to register native methods: Out of memory");
+	}
+}
\ No newline at end of file
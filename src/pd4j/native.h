@@ -0,0 +1,82 @@
+#ifndef PD4J_NATIVE_H
+#define PD4J_NATIVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "thread.h"
+
+// buckets in the registry's hash table, a power of two
+#define PD4J_NATIVE_TABLE_SIZE 256
+
+// the C implementation of a method flagged native
+// args points at the argument slots right where the caller left them, starting with the receiver of an instance method, and is only valid until the native returns
+// a native with a return value sets result with one of the PD4J_NATIVE_RETURN macros; returns false if it threw
+typedef bool (*pd4j_native_function)(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result);
+
+typedef struct {
+	// the internal name of the class declaring the method, like java/lang/Object
+	const char *className;
+	const char *name;
+	const char *descriptor;
+	pd4j_native_function function;
+} pd4j_native_method;
+
+static inline int64_t pd4j_native_slots_long(pd4j_thread_variable *slots) {
+	int64_t value;
+	memcpy(&value, pd4j_thread_slots_wide(slots), sizeof(int64_t));
+	return value;
+}
+
+static inline double pd4j_native_slots_double(pd4j_thread_variable *slots) {
+	double value;
+	memcpy(&value, pd4j_thread_slots_wide(slots), sizeof(double));
+	return value;
+}
+
+// slot is the index of the argument's first slot, with the receiver of an instance method in slot 0 and longs and doubles taking two
+#define PD4J_NATIVE_ARG_INT(args, slot) ((args)[slot].data.intValue)
+#define PD4J_NATIVE_ARG_BOOLEAN(args, slot) ((args)[slot].data.intValue != 0)
+#define PD4J_NATIVE_ARG_FLOAT(args, slot) ((args)[slot].data.floatValue)
+#define PD4J_NATIVE_ARG_LONG(args, slot) pd4j_native_slots_long(&(args)[slot])
+#define PD4J_NATIVE_ARG_DOUBLE(args, slot) pd4j_native_slots_double(&(args)[slot])
+#define PD4J_NATIVE_ARG_REFERENCE(args, slot) ((args)[slot].data.referenceValue)
+
+// boolean, byte, char and short values are returned as ints
+#define PD4J_NATIVE_RETURN_INT(result, value) ((result)->tag = pd4j_VARIABLE_INT, (result)->data.intValue = (int32_t)(value))
+#define PD4J_NATIVE_RETURN_FLOAT(result, value) ((result)->tag = pd4j_VARIABLE_FLOAT, (result)->data.floatValue = (float)(value))
+#define PD4J_NATIVE_RETURN_LONG(result, value) ((result)->tag = pd4j_VARIABLE_LONG, (result)->data.longValue = (int64_t)(value))
+#define PD4J_NATIVE_RETURN_DOUBLE(result, value) ((result)->tag = pd4j_VARIABLE_DOUBLE, (result)->data.doubleValue = (double)(value))
+#define PD4J_NATIVE_RETURN_REFERENCE(result, value) ((result)->tag = pd4j_VARIABLE_REFERENCE, (result)->data.referenceValue = (value))
+
+// writes a value into the next one or two argument slots and returns how many it took, for calling a native from outside the interpreter
+static inline uint16_t pd4j_native_set_arg(pd4j_thread_variable *slots, pd4j_thread_stack_entry *value) {
+	uint16_t numSlots = (value->tag == pd4j_VARIABLE_LONG || value->tag == pd4j_VARIABLE_DOUBLE) ? 2 : 1;
+
+#ifdef PD4J_TAGGED_SLOTS
+	for (uint16_t i = 0; i < numSlots; i++) {
+		slots[i].tag = value->tag;
+		slots[i].name = value->name;
+	}
+#endif
+	
+	if (numSlots == 2) {
+		memcpy(pd4j_thread_slots_wide(slots), &value->data.longValue, sizeof(int64_t));
+	}
+	else {
+		memcpy(&slots[0].data, &value->data, sizeof(slots[0].data));
+	}
+	
+	return numSlots;
+}
+
+// adds a table of natives, which has to stay around as long as the registry; a method registered again is bound to the newer function
+bool pd4j_native_register(const pd4j_native_method *methods, uint32_t numMethods);
+// the function registered for the method, or NULL if there isn't one
+pd4j_native_function pd4j_native_find(uint8_t *className, uint8_t *name, uint8_t *descriptor);
+
+// has every subsystem register its natives, which has to happen before any class is linked
+void pd4j_native_register_all(void);
+
+#endif
\ No newline at end of file
@@ -13,6 +13,17 @@
 #include "thread.h"
 #include "utf8.h"
 
+// pops the result of a call into an entry of its own, which the resolved constant keeps
+static pd4j_thread_stack_entry *pd4j_resolve_pop_constant(pd4j_thread *thread) {
+	pd4j_thread_stack_entry *value = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
+	
+	if (value != NULL) {
+		pd4j_thread_arg_pop(thread, value);
+	}
+	
+	return value;
+}
+
 static void pd4j_resolve_add_constant(pd4j_class_constant *constant, pd4j_thread_stack_entry *thRef, pd4j_class_reference *resolvingClass) {
 	pd4j_class_resolved_reference *resolved = pd4j_malloc(sizeof(pd4j_class_resolved_reference));
 	
@@ -78,8 +89,7 @@ bool pd4j_resolve_class_reference(pd4j_thread_stack_entry **outRef, pd4j_thread
 	thRef->data.class.name = className;
 	thRef->data.class.loaded = classRef;
 	thRef->data.class.staticFields = NULL;
-	thRef->monitor.owner = NULL;
-	thRef->monitor.entryCount = 0;
+	thRef->lockWord = 0;
 	thRef->resolved = true;
 	
 	stackEntry = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
@@ -251,8 +261,7 @@ bool pd4j_resolve_field_reference(pd4j_thread_stack_entry **outRef, pd4j_thread
 	thRef->data.field.name = fieldName;
 	thRef->data.field.descriptor = pd4j_class_get_resolved_class_reference(resolvingClass, thread, fieldType);
 	thRef->data.field.class = classRuntimeRef;
-	thRef->monitor.owner = NULL;
-	thRef->monitor.entryCount = 0;
+	thRef->lockWord = 0;
 	thRef->resolved = true;
 	
 	stackEntry = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
@@ -408,10 +417,12 @@ bool pd4j_resolve_class_method_reference(pd4j_thread_stack_entry **outRef, pd4j_
 			}
 			
 			if (foundMethod != NULL) {
+				targetClass = targetSuperInterface;
 				break;
 			}
 			else if (foundMethod2 != NULL) {
 				foundMethod = foundMethod2;
+				targetClass = targetSuperInterface;
 				break;
 			}
 		}
@@ -468,8 +479,9 @@ bool pd4j_resolve_class_method_reference(pd4j_thread_stack_entry **outRef, pd4j_
 	thRef->data.method.name = methodName;
 	thRef->data.method.descriptor = methodDescriptor;
 	thRef->data.method.class = classRuntimeRef;
-	thRef->monitor.owner = NULL;
-	thRef->monitor.entryCount = 0;
+	thRef->data.method.declaringClass = targetClass;
+	thRef->data.method.property = foundMethod;
+	thRef->lockWord = 0;
 	
 	stackEntry = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
 	if (stackEntry == NULL) {
@@ -599,10 +611,12 @@ bool pd4j_resolve_interface_method_reference(pd4j_thread_stack_entry **outRef, p
 			}
 			
 			if (foundMethod != NULL) {
+				targetClass = targetSuperInterface;
 				break;
 			}
 			else if (foundMethod2 != NULL) {
 				foundMethod = foundMethod2;
+				targetClass = targetSuperInterface;
 				break;
 			}
 		}
@@ -659,8 +673,9 @@ bool pd4j_resolve_interface_method_reference(pd4j_thread_stack_entry **outRef, p
 	thRef->data.method.name = methodName;
 	thRef->data.method.descriptor = methodDescriptor;
 	thRef->data.method.class = classRuntimeRef;
-	thRef->monitor.owner = NULL;
-	thRef->monitor.entryCount = 0;
+	thRef->data.method.declaringClass = targetClass;
+	thRef->data.method.property = foundMethod;
+	thRef->lockWord = 0;
 	
 	stackEntry = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
 	if (stackEntry == NULL) {
@@ -704,8 +719,9 @@ bool pd4j_resolve_method_type_reference(pd4j_thread_stack_entry **outRef, pd4j_t
 	findMethodHandleTypeMethod.data.method.name = (uint8_t *)"findMethodHandleType";
 	findMethodHandleTypeMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;[Ljava/lang/Class;)Ljava/lang/invoke/MethodType;";
 	findMethodHandleTypeMethod.data.method.class = methodHandleNativesClass;
-	findMethodHandleTypeMethod.monitor.owner = NULL;
-	findMethodHandleTypeMethod.monitor.entryCount = 0;
+	findMethodHandleTypeMethod.data.method.declaringClass = NULL;
+	findMethodHandleTypeMethod.data.method.property = NULL;
+	findMethodHandleTypeMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(findMethodHandleTypeMethod.data.method.descriptor, resolvingClass, thread, &findMethodHandleTypeMethod)) {
 		return false;
@@ -755,8 +771,8 @@ bool pd4j_resolve_method_type_reference(pd4j_thread_stack_entry **outRef, pd4j_t
 	paramTypesRef.data.instance.numInstanceFields = dummyMethodThreadRef.data.method.argumentDescriptors->size;
 	paramTypesRef.data.instance.instanceFields = paramTypes;
 	paramTypesRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Class;");
-	paramTypesRef.monitor.owner = NULL;
-	paramTypesRef.monitor.entryCount = 0;
+	paramTypesRef.data.instance.backtrace = NULL;
+	paramTypesRef.lockWord = 0;
 	
 	paramTypesField.tag = pd4j_VARIABLE_REFERENCE;
 	paramTypesField.name = (uint8_t *)"ptypes";
@@ -769,7 +785,7 @@ bool pd4j_resolve_method_type_reference(pd4j_thread_stack_entry **outRef, pd4j_t
 		return false;
 	}
 	
-	pd4j_thread_stack_entry *returnValue = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry *returnValue = pd4j_resolve_pop_constant(thread);
 	
 	pd4j_free(paramTypes, dummyMethodThreadRef.data.method.argumentDescriptors->size * sizeof(pd4j_thread_stack_entry));
 	
@@ -1075,8 +1091,9 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 	resolvedMethodType.resolved = true;
 	resolvedMethodType.data.method.name = (uint8_t *)"(method handle)";
 	resolvedMethodType.data.method.class = classRef;
-	resolvedMethodType.monitor.owner = NULL;
-	resolvedMethodType.monitor.entryCount = 0;
+	resolvedMethodType.data.method.declaringClass = NULL;
+	resolvedMethodType.data.method.property = NULL;
+	resolvedMethodType.lockWord = 0;
 	
 	switch (methodHandleConstant->data.methodHandle.refKind) {
 		case pd4j_REF_HANDLE_GETFIELD: {
@@ -1168,8 +1185,9 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 	findMethodHandleTypeMethod.data.method.name = (uint8_t *)"findMethodHandleType";
 	findMethodHandleTypeMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;[Ljava/lang/Class;)Ljava/lang/invoke/MethodType;";
 	findMethodHandleTypeMethod.data.method.class = methodHandleNativesClass;
-	findMethodHandleTypeMethod.monitor.owner = NULL;
-	findMethodHandleTypeMethod.monitor.entryCount = 0;
+	findMethodHandleTypeMethod.data.method.declaringClass = NULL;
+	findMethodHandleTypeMethod.data.method.property = NULL;
+	findMethodHandleTypeMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(findMethodHandleTypeMethod.data.method.descriptor, resolvingClass, thread, &findMethodHandleTypeMethod)) {
 		pd4j_list_destroy(paramRefs);
@@ -1189,7 +1207,7 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 	if (paramTypes == NULL) {
 		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate parameter array for method type reference: Out of memory");
 		pd4j_list_destroy(paramRefs);
-		pd4j_free(pd4j_thread_arg_pop(thread), sizeof(pd4j_thread_stack_entry));
+		pd4j_thread_arg_pop(thread, &stackEntry);
 		return false;
 	}
 	
@@ -1210,8 +1228,8 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 	paramTypesRef.data.instance.numInstanceFields = resolvedMethodType.data.method.argumentDescriptors->size;
 	paramTypesRef.data.instance.instanceFields = paramTypes;
 	paramTypesRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Class;");
-	paramTypesRef.monitor.owner = NULL;
-	paramTypesRef.monitor.entryCount = 0;
+	paramTypesRef.data.instance.backtrace = NULL;
+	paramTypesRef.lockWord = 0;
 	
 	stackEntry.tag = pd4j_VARIABLE_REFERENCE;
 	stackEntry.name = (uint8_t *)"ptypes";
@@ -1224,17 +1242,18 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 		return false;
 	}
 	
-	pd4j_thread_stack_entry *returnValue = pd4j_thread_arg_pop(thread);
-	pd4j_thread_reference *thRef = returnValue->data.referenceValue;
-	pd4j_free(returnValue, sizeof(pd4j_thread_stack_entry));
+	pd4j_thread_stack_entry methodTypeResult;
+	pd4j_thread_arg_pop(thread, &methodTypeResult);
+	pd4j_thread_reference *thRef = methodTypeResult.data.referenceValue;
 	
 	pd4j_thread_reference linkMethodHandleConstantMethod;
 	linkMethodHandleConstantMethod.kind = pd4j_REF_CLASS_METHOD;
 	linkMethodHandleConstantMethod.data.method.name = (uint8_t *)"linkMethodHandleConstant";
 	linkMethodHandleConstantMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;ILjava/lang/Class;Ljava/lang/String;Ljava/lang/Object;)Ljava/lang/invoke/MethodHandle;";
 	linkMethodHandleConstantMethod.data.method.class = methodHandleNativesClass;
-	linkMethodHandleConstantMethod.monitor.owner = NULL;
-	linkMethodHandleConstantMethod.monitor.entryCount = 0;
+	linkMethodHandleConstantMethod.data.method.declaringClass = NULL;
+	linkMethodHandleConstantMethod.data.method.property = NULL;
+	linkMethodHandleConstantMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(linkMethodHandleConstantMethod.data.method.descriptor, resolvingClass, thread, &linkMethodHandleConstantMethod)) {
 		pd4j_list_destroy(paramRefs);
@@ -1271,7 +1290,7 @@ bool pd4j_resolve_method_handle_reference(pd4j_thread_stack_entry **outRef, pd4j
 		return false;
 	}
 	
-	returnValue = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry *returnValue = pd4j_resolve_pop_constant(thread);
 	if (outRef != NULL) {
 		*outRef = returnValue;
 	}
@@ -1397,8 +1416,9 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 	linkDynamicConstantMethod.data.method.name = (uint8_t *)"linkDynamicConstant";
 	linkDynamicConstantMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;";
 	linkDynamicConstantMethod.data.method.class = methodHandleNativesClass;
-	linkDynamicConstantMethod.monitor.owner = NULL;
-	linkDynamicConstantMethod.monitor.entryCount = 0;
+	linkDynamicConstantMethod.data.method.declaringClass = NULL;
+	linkDynamicConstantMethod.data.method.property = NULL;
+	linkDynamicConstantMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(linkDynamicConstantMethod.data.method.descriptor, resolvingClass, thread, &linkDynamicConstantMethod)) {
 		if (dynamicConstantStack->size == 1) {
@@ -1412,8 +1432,9 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 	identityMethod.data.method.name = (uint8_t *)"identity";
 	identityMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;)Ljava/lang/invoke/MethodHandle;";
 	identityMethod.data.method.class = methodHandlesClass;
-	identityMethod.monitor.owner = NULL;
-	identityMethod.monitor.entryCount = 0;
+	identityMethod.data.method.declaringClass = NULL;
+	identityMethod.data.method.property = NULL;
+	identityMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(identityMethod.data.method.descriptor, resolvingClass, thread, &identityMethod)) {
 		if (dynamicConstantStack->size == 1) {
@@ -1427,8 +1448,9 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 	lookupMethod.data.method.name = (uint8_t *)"lookup";
 	lookupMethod.data.method.descriptor = (uint8_t *)"()Ljava/lang/invoke/MethodHandles$Lookup;";
 	lookupMethod.data.method.class = methodHandlesClass;
-	lookupMethod.monitor.owner = NULL;
-	lookupMethod.monitor.entryCount = 0;
+	lookupMethod.data.method.declaringClass = NULL;
+	lookupMethod.data.method.property = NULL;
+	lookupMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(lookupMethod.data.method.descriptor, resolvingClass, thread, &lookupMethod)) {
 		if (dynamicConstantStack->size == 1) {
@@ -1462,8 +1484,8 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 	paramsRef.data.instance.numInstanceFields = bootstrapMethod->numArguments;
 	paramsRef.data.instance.instanceFields = params;
 	paramsRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Object;");
-	paramsRef.monitor.owner = NULL;
-	paramsRef.monitor.entryCount = 0;
+	paramsRef.data.instance.backtrace = NULL;
+	paramsRef.lockWord = 0;
 	
 	pd4j_thread_stack_entry stackEntry;
 	
@@ -1506,17 +1528,18 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 					return false;
 				}
 				
-				pd4j_thread_stack_entry *numericInvokeMethodHandle = pd4j_thread_arg_pop(thread);
-				pd4j_thread_reference *invokeMethodRef = numericInvokeMethodHandle->data.referenceValue;
-				pd4j_free(numericInvokeMethodHandle, sizeof(pd4j_thread_stack_entry));
+				pd4j_thread_stack_entry numericInvokeMethodHandle;
+				pd4j_thread_arg_pop(thread, &numericInvokeMethodHandle);
+				pd4j_thread_reference *invokeMethodRef = numericInvokeMethodHandle.data.referenceValue;
 				
 				pd4j_thread_reference invokeMethod;
 				invokeMethod.kind = pd4j_REF_CLASS_METHOD;
 				invokeMethod.data.method.name = (uint8_t *)"invoke";
 				invokeMethod.data.method.descriptor = numericInvokeDescriptor;
 				invokeMethod.data.method.class = methodHandleClass;
-				invokeMethod.monitor.owner = NULL;
-				invokeMethod.monitor.entryCount = 0;
+				invokeMethod.data.method.declaringClass = NULL;
+				invokeMethod.data.method.property = NULL;
+				invokeMethod.lockWord = 0;
 				
 				if (!pd4j_descriptor_parse_method(invokeMethod.data.method.descriptor, resolvingClass, thread, &invokeMethod)) {
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
@@ -1536,13 +1559,12 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 					return false;
 				}
 				
-				pd4j_thread_stack_entry *finalParam = pd4j_thread_arg_pop(thread);
+				pd4j_thread_stack_entry finalParam;
+				pd4j_thread_arg_pop(thread, &finalParam);
 				
 				params[i].tag = pd4j_VARIABLE_REFERENCE;
 				params[i].name = (uint8_t *)"(dynamic field bootstrap method parameter)";
-				params[i].data.referenceValue = finalParam->data.referenceValue;
-				
-				pd4j_free(finalParam, sizeof(pd4j_thread_stack_entry));
+				params[i].data.referenceValue = finalParam.data.referenceValue;
 				
 				break;
 			}
@@ -1729,7 +1751,7 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 	}
 	
 	pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
-	pd4j_thread_stack_entry *finalReference = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry *finalReference = pd4j_resolve_pop_constant(thread);
 	
 	if (strpbrk((char *)fieldDescriptor, "BCDFIJSZ") != (char *)fieldDescriptor || dynamicConstantStack->size == 1) {
 		uint8_t *conversionMethodDescriptor;
@@ -1747,17 +1769,18 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 			return false;
 		}
 		
-		pd4j_thread_stack_entry *conversionMethodHandle = pd4j_thread_arg_pop(thread);
-		pd4j_thread_reference *conversionMethodRef = conversionMethodHandle->data.referenceValue;
-		pd4j_free(conversionMethodHandle, sizeof(pd4j_thread_stack_entry));
+		pd4j_thread_stack_entry conversionMethodHandle;
+		pd4j_thread_arg_pop(thread, &conversionMethodHandle);
+		pd4j_thread_reference *conversionMethodRef = conversionMethodHandle.data.referenceValue;
 		
 		pd4j_thread_reference conversionMethod;
 		conversionMethod.kind = pd4j_REF_CLASS_METHOD;
 		conversionMethod.data.method.name = (uint8_t *)"invoke";
 		conversionMethod.data.method.descriptor = conversionMethodDescriptor;
 		conversionMethod.data.method.class = methodHandleClass;
-		conversionMethod.monitor.owner = NULL;
-		conversionMethod.monitor.entryCount = 0;
+		conversionMethod.data.method.declaringClass = NULL;
+		conversionMethod.data.method.property = NULL;
+		conversionMethod.lockWord = 0;
 		
 		if (!pd4j_descriptor_parse_method(conversionMethod.data.method.descriptor, resolvingClass, thread, &conversionMethod)) {
 			if (dynamicConstantStack->size == 1) {
@@ -1780,7 +1803,7 @@ static bool pd4j_resolve_dynamic_reference_impl(pd4j_thread_stack_entry **outRef
 		pd->system->realloc(conversionMethodDescriptor, 0);
 		pd4j_free(finalReference, sizeof(pd4j_thread_stack_entry));
 		
-		finalReference = pd4j_thread_arg_pop(thread);
+		finalReference = pd4j_resolve_pop_constant(thread);
 	}
 	
 	if (outRef != NULL) {
@@ -1865,8 +1888,9 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	findMethodHandleTypeMethod.data.method.name = (uint8_t *)"findMethodHandleType";
 	findMethodHandleTypeMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;[Ljava/lang/Class;)Ljava/lang/invoke/MethodType;";
 	findMethodHandleTypeMethod.data.method.class = methodHandleNativesClass;
-	findMethodHandleTypeMethod.monitor.owner = NULL;
-	findMethodHandleTypeMethod.monitor.entryCount = 0;
+	findMethodHandleTypeMethod.data.method.declaringClass = NULL;
+	findMethodHandleTypeMethod.data.method.property = NULL;
+	findMethodHandleTypeMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(findMethodHandleTypeMethod.data.method.descriptor, resolvingClass, thread, &findMethodHandleTypeMethod)) {
 		return false;
@@ -1877,8 +1901,9 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	linkMethodHandleConstantMethod.data.method.name = (uint8_t *)"linkMethodHandleConstant";
 	linkMethodHandleConstantMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;ILjava/lang/Class;Ljava/lang/String;Ljava/lang/Object;)Ljava/lang/invoke/MethodHandle;";
 	linkMethodHandleConstantMethod.data.method.class = methodHandleNativesClass;
-	linkMethodHandleConstantMethod.monitor.owner = NULL;
-	linkMethodHandleConstantMethod.monitor.entryCount = 0;
+	linkMethodHandleConstantMethod.data.method.declaringClass = NULL;
+	linkMethodHandleConstantMethod.data.method.property = NULL;
+	linkMethodHandleConstantMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(linkMethodHandleConstantMethod.data.method.descriptor, resolvingClass, thread, &linkMethodHandleConstantMethod)) {
 		return false;
@@ -1889,8 +1914,9 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	linkCallSiteMethod.data.method.name = (uint8_t *)"linkCallSite";
 	linkCallSiteMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/invoke/MemberName;";
 	linkCallSiteMethod.data.method.class = methodHandleNativesClass;
-	linkCallSiteMethod.monitor.owner = NULL;
-	linkCallSiteMethod.monitor.entryCount = 0;
+	linkCallSiteMethod.data.method.declaringClass = NULL;
+	linkCallSiteMethod.data.method.property = NULL;
+	linkCallSiteMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(linkCallSiteMethod.data.method.descriptor, resolvingClass, thread, &linkCallSiteMethod)) {
 		return false;
@@ -1937,8 +1963,8 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	paramTypesRef.data.instance.numInstanceFields = dynamicMethodReference.data.method.argumentDescriptors->size;
 	paramTypesRef.data.instance.instanceFields = paramTypes;
 	paramTypesRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Class;");
-	paramTypesRef.monitor.owner = NULL;
-	paramTypesRef.monitor.entryCount = 0;
+	paramTypesRef.data.instance.backtrace = NULL;
+	paramTypesRef.lockWord = 0;
 	
 	paramTypesField.tag = pd4j_VARIABLE_REFERENCE;
 	paramTypesField.name = (uint8_t *)"ptypes";
@@ -1951,7 +1977,8 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 		return false;
 	}
 	
-	pd4j_thread_stack_entry *methodTypeInstance = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry methodTypeInstance;
+	pd4j_thread_arg_pop(thread, &methodTypeInstance);
 	pd4j_free(paramTypes, dynamicMethodReference.data.method.argumentDescriptors->size * sizeof(pd4j_thread_stack_entry));
 	
 	pd4j_thread_reference identityMethod;
@@ -1959,11 +1986,11 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	identityMethod.data.method.name = (uint8_t *)"identity";
 	identityMethod.data.method.descriptor = (uint8_t *)"(Ljava/lang/Class;)Ljava/lang/invoke/MethodHandle;";
 	identityMethod.data.method.class = methodHandlesClass;
-	identityMethod.monitor.owner = NULL;
-	identityMethod.monitor.entryCount = 0;
+	identityMethod.data.method.declaringClass = NULL;
+	identityMethod.data.method.property = NULL;
+	identityMethod.lockWord = 0;
 	
 	if (!pd4j_descriptor_parse_method(identityMethod.data.method.descriptor, resolvingClass, thread, &identityMethod)) {
-		pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 		return false;
 	}
 	
@@ -1971,7 +1998,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	
 	pd4j_thread_stack_entry *params = pd4j_malloc(bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 	if (params == NULL) {
-		pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate parameter array for dynamically-computed constant bootstrap method: Out of memory");
 		return false;
 	}
@@ -1982,8 +2008,8 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	paramsRef.data.instance.numInstanceFields = bootstrapMethod->numArguments;
 	paramsRef.data.instance.instanceFields = params;
 	paramsRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Object;");
-	paramsRef.monitor.owner = NULL;
-	paramsRef.monitor.entryCount = 0;
+	paramsRef.data.instance.backtrace = NULL;
+	paramsRef.lockWord = 0;
 	
 	pd4j_thread_stack_entry stackEntry;
 	
@@ -2018,42 +2044,39 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_arg_push(thread, &stackEntry);
 				
 				if (!pd4j_thread_invoke_static_method(thread, &identityMethod)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
 				
-				pd4j_thread_stack_entry *numericInvokeMethodHandle = pd4j_thread_arg_pop(thread);
-				pd4j_thread_reference *invokeMethodRef = numericInvokeMethodHandle->data.referenceValue;
-				pd4j_free(numericInvokeMethodHandle, sizeof(pd4j_thread_stack_entry));
+				pd4j_thread_stack_entry numericInvokeMethodHandle;
+				pd4j_thread_arg_pop(thread, &numericInvokeMethodHandle);
+				pd4j_thread_reference *invokeMethodRef = numericInvokeMethodHandle.data.referenceValue;
 				
 				pd4j_thread_reference invokeMethod;
 				invokeMethod.kind = pd4j_REF_CLASS_METHOD;
 				invokeMethod.data.method.name = (uint8_t *)"invoke";
 				invokeMethod.data.method.descriptor = numericInvokeDescriptor;
 				invokeMethod.data.method.class = methodHandleClass;
-				invokeMethod.monitor.owner = NULL;
-				invokeMethod.monitor.entryCount = 0;
+				invokeMethod.data.method.declaringClass = NULL;
+				invokeMethod.data.method.property = NULL;
+				invokeMethod.lockWord = 0;
 				
 				if (!pd4j_descriptor_parse_method(invokeMethod.data.method.descriptor, resolvingClass, thread, &invokeMethod)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
 				
 				if (!pd4j_thread_invoke_instance_method(thread, invokeMethodRef, &invokeMethod)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
 				
-				pd4j_thread_stack_entry *finalParam = pd4j_thread_arg_pop(thread);
+				pd4j_thread_stack_entry finalParam;
+				pd4j_thread_arg_pop(thread, &finalParam);
 				
 				params[i].tag = pd4j_VARIABLE_REFERENCE;
 				params[i].name = (uint8_t *)"(dynamic call site bootstrap method parameter)";
-				params[i].data.referenceValue = finalParam->data.referenceValue;
-				
-				pd4j_free(finalParam, sizeof(pd4j_thread_stack_entry));
+				params[i].data.referenceValue = finalParam.data.referenceValue;
 				pd->system->realloc(numericInvokeDescriptor, 0);
 				
 				break;
@@ -2062,7 +2085,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_class_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, (3 + bootstrapMethod->numArguments) * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2077,7 +2099,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_field_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2092,7 +2113,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_class_method_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2107,7 +2127,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_interface_method_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2122,7 +2141,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_method_type_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2137,7 +2155,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_method_handle_reference(&resolvedConstant, thread, argumentConstant, resolvingClass)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2152,7 +2169,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (!pd4j_resolve_dynamic_reference(&resolvedConstant, thread, argumentConstant, resolvingClassRef)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2169,13 +2185,11 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 				pd4j_thread_stack_entry *resolvedConstant;
 				
 				if (argumentConstant == invokeDynamicConstant) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
 				
 				if (!pd4j_resolve_invoke_dynamic_reference(&resolvedConstant, thread, argumentConstant, resolvingClassRef)) {
-					pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 					pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 					return false;
 				}
@@ -2193,7 +2207,6 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	
 	pd4j_thread_stack_entry *appendixResult = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
 	if (appendixResult == NULL) {
-		pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 		pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate appendix result for dynamically-computed constant bootstrap method: Out of memory");
 		return false;
@@ -2209,8 +2222,8 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	appendixResultRef.data.instance.numInstanceFields = 1;
 	appendixResultRef.data.instance.instanceFields = appendixResult;
 	appendixResultRef.data.instance.class = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)"[Ljava/lang/Object;");
-	appendixResultRef.monitor.owner = NULL;
-	appendixResultRef.monitor.entryCount = 0;
+	appendixResultRef.data.instance.backtrace = NULL;
+	appendixResultRef.lockWord = 0;
 	
 	stackEntry.tag = pd4j_VARIABLE_REFERENCE;
 	stackEntry.name = (uint8_t *)"callerObj";
@@ -2225,8 +2238,8 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	stackEntry.data.referenceValue = bootstrapMethodNameRef;
 	pd4j_thread_arg_push(thread, &stackEntry);
 	
-	methodTypeInstance->name = (uint8_t *)"typeObj";
-	pd4j_thread_arg_push(thread, methodTypeInstance);
+	methodTypeInstance.name = (uint8_t *)"typeObj";
+	pd4j_thread_arg_push(thread, &methodTypeInstance);
 	
 	stackEntry.tag = pd4j_VARIABLE_REFERENCE;
 	stackEntry.name = (uint8_t *)"staticArguments";
@@ -2239,14 +2252,13 @@ bool pd4j_resolve_invoke_dynamic_reference(pd4j_thread_stack_entry **outRef, pd4
 	pd4j_thread_arg_push(thread, &stackEntry);
 	
 	if (!pd4j_thread_invoke_static_method(thread, &linkCallSiteMethod)) {
-		pd4j_free(methodTypeInstance, sizeof(pd4j_thread_stack_entry));
 		pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
 		pd4j_free(appendixResult, sizeof(pd4j_thread_stack_entry));
 		pd4j_thread_throw_class_with_message(thread, "java/lang/BootstrapMethodError", "Unable to resolve dynamically-computed call site: Bootstrap method threw an exception");
 		return false;
 	}
 	
-	pd4j_thread_stack_entry *finalReference = pd4j_thread_arg_pop(thread);
+	pd4j_thread_stack_entry *finalReference = pd4j_resolve_pop_constant(thread);
 	memcpy(finalReference, &appendixResult[0], sizeof(pd4j_thread_stack_entry));
 	
 	pd4j_free(params, bootstrapMethod->numArguments * sizeof(pd4j_thread_stack_entry));
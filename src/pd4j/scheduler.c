@@ -0,0 +1,739 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api_ptr.h"
+#include "list.h"
+#include "memory.h"
+#include "native.h"
+#include "scheduler.h"
+#include "thread.h"
+
+// timerIndex of a task that isn't waiting on a timeout
+#define PD4J_SCHEDULER_NO_TIMER UINT32_MAX
+
+struct pd4j_scheduler_task {
+	pd4j_thread *thread;
+	pd4j_scheduler *scheduler;
+	
+	pd4j_scheduler_task_state state;
+	uint8_t priority;
+	// set by an unpark that came before the park it's meant for, like the permit of LockSupport
+	bool permit;
+	
+	// the next task in the run queue
+	pd4j_scheduler_task *next;
+	
+	// when a sleep or timed wait ends, in the milliseconds of the system clock
+	uint32_t wakeTime;
+	uint32_t timerIndex;
+	
+	// the java.lang.Thread whose start0 made the thread, or NULL for threads added from outside the VM
+	pd4j_thread_reference *javaThread;
+};
+
+struct pd4j_scheduler {
+	// one FIFO queue for each priority
+	struct {
+		pd4j_scheduler_task *head;
+		pd4j_scheduler_task *tail;
+	} runQueues[PD4J_SCHEDULER_MAX_PRIORITY];
+	
+	// components should be pd4j_scheduler_task *
+	pd4j_list *tasks;
+	// binary min-heap of waiting tasks ordered by wakeTime; components should be pd4j_scheduler_task *
+	pd4j_list *timers;
+	
+	// the task being run, which isn't in any run queue
+	pd4j_scheduler_task *current;
+	uint32_t numAlive;
+};
+
+static pd4j_scheduler *defaultScheduler = NULL;
+
+// compares times from the millisecond clock the way that still works after it wraps around
+static inline bool pd4j_scheduler_time_before(uint32_t time1, uint32_t time2) {
+	return (int32_t)(time1 - time2) < 0;
+}
+
+static inline uint8_t pd4j_scheduler_clamp_priority(uint8_t priority) {
+	if (priority < PD4J_SCHEDULER_MIN_PRIORITY) {
+		return PD4J_SCHEDULER_MIN_PRIORITY;
+	}
+	else if (priority > PD4J_SCHEDULER_MAX_PRIORITY) {
+		return PD4J_SCHEDULER_MAX_PRIORITY;
+	}
+	
+	return priority;
+}
+
+static void pd4j_scheduler_enqueue(pd4j_scheduler *scheduler, pd4j_scheduler_task *task) {
+	uint8_t queue = task->priority - 1;
+	
+	task->next = NULL;
+	
+	if (scheduler->runQueues[queue].tail == NULL) {
+		scheduler->runQueues[queue].head = task;
+	}
+	else {
+		scheduler->runQueues[queue].tail->next = task;
+	}
+	
+	scheduler->runQueues[queue].tail = task;
+}
+
+static void pd4j_scheduler_dequeue(pd4j_scheduler *scheduler, pd4j_scheduler_task *task) {
+	uint8_t queue = task->priority - 1;
+	pd4j_scheduler_task *prev = NULL;
+	
+	for (pd4j_scheduler_task *current = scheduler->runQueues[queue].head; current != NULL; prev = current, current = current->next) {
+		if (current != task) {
+			continue;
+		}
+		
+		if (prev == NULL) {
+			scheduler->runQueues[queue].head = task->next;
+		}
+		else {
+			prev->next = task->next;
+		}
+		
+		if (scheduler->runQueues[queue].tail == task) {
+			scheduler->runQueues[queue].tail = prev;
+		}
+		
+		task->next = NULL;
+		return;
+	}
+}
+
+// the runnable task of the highest priority that has waited longest
+static pd4j_scheduler_task *pd4j_scheduler_next(pd4j_scheduler *scheduler) {
+	for (uint8_t queue = PD4J_SCHEDULER_MAX_PRIORITY; queue > 0; queue--) {
+		pd4j_scheduler_task *task = scheduler->runQueues[queue - 1].head;
+		
+		if (task != NULL) {
+			scheduler->runQueues[queue - 1].head = task->next;
+			
+			if (task->next == NULL) {
+				scheduler->runQueues[queue - 1].tail = NULL;
+			}
+			
+			task->next = NULL;
+			return task;
+		}
+	}
+	
+	return NULL;
+}
+
+static inline void pd4j_scheduler_timer_set(pd4j_list *timers, uint32_t idx, pd4j_scheduler_task *task) {
+	timers->array[idx] = task;
+	task->timerIndex = idx;
+}
+
+static void pd4j_scheduler_timer_sift(pd4j_list *timers, uint32_t idx) {
+	pd4j_scheduler_task *task = timers->array[idx];
+	
+	while (idx > 0) {
+		uint32_t parent = (idx - 1) / 2;
+		pd4j_scheduler_task *parentTask = timers->array[parent];
+		
+		if (!pd4j_scheduler_time_before(task->wakeTime, parentTask->wakeTime)) {
+			break;
+		}
+		
+		pd4j_scheduler_timer_set(timers, idx, parentTask);
+		idx = parent;
+	}
+	
+	while (true) {
+		uint32_t child = 2 * idx + 1;
+		
+		if (child >= timers->size) {
+			break;
+		}
+		
+		pd4j_scheduler_task *childTask = timers->array[child];
+		
+		if (child + 1 < timers->size && pd4j_scheduler_time_before(((pd4j_scheduler_task *)timers->array[child + 1])->wakeTime, childTask->wakeTime)) {
+			child++;
+			childTask = timers->array[child];
+		}
+		
+		if (!pd4j_scheduler_time_before(childTask->wakeTime, task->wakeTime)) {
+			break;
+		}
+		
+		pd4j_scheduler_timer_set(timers, idx, childTask);
+		idx = child;
+	}
+	
+	pd4j_scheduler_timer_set(timers, idx, task);
+}
+
+static void pd4j_scheduler_timer_add(pd4j_scheduler *scheduler, pd4j_scheduler_task *task, uint32_t millis) {
+	if (millis > PD4J_SCHEDULER_MAX_TIMEOUT) {
+		millis = PD4J_SCHEDULER_MAX_TIMEOUT;
+	}
+	
+	task->wakeTime = pd->system->getCurrentTimeMilliseconds() + millis;
+	
+	pd4j_list_add(scheduler->timers, task);
+	pd4j_scheduler_timer_sift(scheduler->timers, scheduler->timers->size - 1);
+}
+
+static void pd4j_scheduler_timer_remove(pd4j_scheduler *scheduler, pd4j_scheduler_task *task) {
+	pd4j_list *timers = scheduler->timers;
+	uint32_t idx = task->timerIndex;
+	
+	if (idx == PD4J_SCHEDULER_NO_TIMER) {
+		return;
+	}
+	
+	task->timerIndex = PD4J_SCHEDULER_NO_TIMER;
+	pd4j_scheduler_task *last = pd4j_list_pop(timers);
+	
+	if (last != task) {
+		pd4j_scheduler_timer_set(timers, idx, last);
+		pd4j_scheduler_timer_sift(timers, idx);
+	}
+}
+
+// makes a waiting task runnable again, whether its wait ended or timed out
+static void pd4j_scheduler_wake(pd4j_scheduler_task *task) {
+	pd4j_scheduler *scheduler = task->scheduler;
+	
+	pd4j_scheduler_timer_remove(scheduler, task);
+	task->state = pd4j_TASK_RUNNABLE;
+	
+	// the running task goes back in a queue when it stops
+	if (task != scheduler->current) {
+		pd4j_scheduler_enqueue(scheduler, task);
+	}
+}
+
+static void pd4j_scheduler_wake_timers(pd4j_scheduler *scheduler) {
+	uint32_t now = pd->system->getCurrentTimeMilliseconds();
+	
+	while (scheduler->timers->size > 0) {
+		pd4j_scheduler_task *task = scheduler->timers->array[0];
+		
+		if (pd4j_scheduler_time_before(now, task->wakeTime)) {
+			break;
+		}
+		
+		pd4j_scheduler_wake(task);
+	}
+}
+
+// puts the running thread to wait, stopping it at its next safepoint
+static pd4j_scheduler_task *pd4j_scheduler_block(pd4j_thread *thread, pd4j_scheduler_task_state state, uint32_t millis) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task == NULL) {
+		return NULL;
+	}
+	
+	task->state = state;
+	
+	if (millis != 0) {
+		pd4j_scheduler_timer_add(task->scheduler, task, millis);
+	}
+	
+	pd4j_thread_block(thread);
+	return task;
+}
+
+pd4j_scheduler *pd4j_scheduler_get_default(void) {
+	if (defaultScheduler == NULL) {
+		defaultScheduler = pd4j_scheduler_new();
+	}
+	
+	return defaultScheduler;
+}
+
+pd4j_scheduler *pd4j_scheduler_new(void) {
+	pd4j_scheduler *scheduler = pd4j_malloc(sizeof(pd4j_scheduler));
+	if (scheduler == NULL) {
+		return NULL;
+	}
+	
+	scheduler->tasks = pd4j_list_new(4);
+	if (scheduler->tasks == NULL) {
+		pd4j_free(scheduler, sizeof(pd4j_scheduler));
+		return NULL;
+	}
+	
+	scheduler->timers = pd4j_list_new(4);
+	if (scheduler->timers == NULL) {
+		pd4j_list_destroy(scheduler->tasks);
+		pd4j_free(scheduler, sizeof(pd4j_scheduler));
+		return NULL;
+	}
+	
+	for (uint8_t i = 0; i < PD4J_SCHEDULER_MAX_PRIORITY; i++) {
+		scheduler->runQueues[i].head = NULL;
+		scheduler->runQueues[i].tail = NULL;
+	}
+	
+	scheduler->current = NULL;
+	scheduler->numAlive = 0;
+	
+	return scheduler;
+}
+
+void pd4j_scheduler_destroy(pd4j_scheduler *scheduler) {
+	// the threads themselves belong to whoever added them, which is the scheduler for those started from Java
+	while (scheduler->tasks->size > 0) {
+		pd4j_scheduler_task *task = scheduler->tasks->array[scheduler->tasks->size - 1];
+		
+		if (task->javaThread != NULL) {
+			pd4j_thread_destroy(task->thread);
+		}
+		else {
+			pd4j_scheduler_remove(task->thread);
+		}
+	}
+	
+	pd4j_list_destroy(scheduler->tasks);
+	pd4j_list_destroy(scheduler->timers);
+	
+	if (scheduler == defaultScheduler) {
+		defaultScheduler = NULL;
+	}
+	
+	pd4j_free(scheduler, sizeof(pd4j_scheduler));
+}
+
+bool pd4j_scheduler_add(pd4j_scheduler *scheduler, pd4j_thread *thread, uint8_t priority) {
+	if (pd4j_thread_get_task(thread) != NULL) {
+		return false;
+	}
+	
+	pd4j_scheduler_task *task = pd4j_malloc(sizeof(pd4j_scheduler_task));
+	if (task == NULL) {
+		return false;
+	}
+	
+	task->thread = thread;
+	task->scheduler = scheduler;
+	task->state = pd4j_TASK_RUNNABLE;
+	task->priority = pd4j_scheduler_clamp_priority(priority);
+	task->permit = false;
+	task->next = NULL;
+	task->wakeTime = 0;
+	task->timerIndex = PD4J_SCHEDULER_NO_TIMER;
+	task->javaThread = NULL;
+	
+	pd4j_list_add(scheduler->tasks, task);
+	pd4j_thread_set_task(thread, task);
+	scheduler->numAlive++;
+	pd4j_scheduler_enqueue(scheduler, task);
+	
+	return true;
+}
+
+void pd4j_scheduler_remove(pd4j_thread *thread) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task == NULL) {
+		return;
+	}
+	
+	pd4j_scheduler *scheduler = task->scheduler;
+	
+	if (task->state == pd4j_TASK_RUNNABLE && task != scheduler->current) {
+		pd4j_scheduler_dequeue(scheduler, task);
+	}
+	
+	pd4j_scheduler_timer_remove(scheduler, task);
+	
+	if (task->state != pd4j_TASK_TERMINATED) {
+		scheduler->numAlive--;
+	}
+	
+	if (scheduler->current == task) {
+		scheduler->current = NULL;
+	}
+	
+	for (uint32_t i = 0; i < scheduler->tasks->size; i++) {
+		if (scheduler->tasks->array[i] == task) {
+			pd4j_list_remove(scheduler->tasks, i);
+			break;
+		}
+	}
+	
+	pd4j_thread_set_task(thread, NULL);
+	pd4j_free(task, sizeof(pd4j_scheduler_task));
+}
+
+void pd4j_scheduler_set_priority(pd4j_thread *thread, uint8_t priority) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task == NULL) {
+		return;
+	}
+	
+	bool queued = task->state == pd4j_TASK_RUNNABLE && task != task->scheduler->current;
+	
+	if (queued) {
+		pd4j_scheduler_dequeue(task->scheduler, task);
+	}
+	
+	task->priority = pd4j_scheduler_clamp_priority(priority);
+	
+	if (queued) {
+		pd4j_scheduler_enqueue(task->scheduler, task);
+	}
+}
+
+pd4j_scheduler_task_state pd4j_scheduler_get_state(pd4j_thread *thread) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	return (task == NULL) ? pd4j_TASK_RUNNABLE : task->state;
+}
+
+void pd4j_scheduler_yield(pd4j_thread *thread) {
+	pd4j_scheduler_block(thread, pd4j_TASK_RUNNABLE, 0);
+}
+
+void pd4j_scheduler_sleep(pd4j_thread *thread, uint32_t millis) {
+	pd4j_scheduler_block(thread, (millis == 0) ? pd4j_TASK_RUNNABLE : pd4j_TASK_SLEEPING, millis);
+}
+
+void pd4j_scheduler_park(pd4j_thread *thread, uint32_t millis) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task != NULL && task->permit) {
+		task->permit = false;
+		return;
+	}
+	
+	pd4j_scheduler_block(thread, pd4j_TASK_PARKED, millis);
+}
+
+void pd4j_scheduler_suspend(pd4j_thread *thread) {
+	if (pd4j_scheduler_block(thread, pd4j_TASK_BLOCKED, 0) == NULL) {
+		pd4j_thread_block(thread);
+	}
+}
+
+void pd4j_scheduler_wait(pd4j_thread *thread, uint32_t millis) {
+	if (pd4j_scheduler_block(thread, pd4j_TASK_WAITING, millis) == NULL) {
+		pd4j_thread_block(thread);
+	}
+}
+
+void pd4j_scheduler_unpark(pd4j_thread *thread) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task == NULL) {
+		return;
+	}
+	
+	if (task->state == pd4j_TASK_PARKED) {
+		pd4j_scheduler_wake(task);
+	}
+	else {
+		task->permit = true;
+	}
+}
+
+void pd4j_scheduler_resume(pd4j_thread *thread) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task != NULL && task->state == pd4j_TASK_BLOCKED) {
+		pd4j_scheduler_wake(task);
+	}
+}
+
+void pd4j_scheduler_notify(pd4j_thread *thread) {
+	pd4j_scheduler_task *task = pd4j_thread_get_task(thread);
+	
+	if (task != NULL && task->state == pd4j_TASK_WAITING) {
+		pd4j_scheduler_timer_remove(task->scheduler, task);
+		task->state = pd4j_TASK_BLOCKED;
+	}
+}
+
+// JVMTI thread states kept in the threadStatus of Thread.FieldHolder, which Thread.getState and Thread.start check
+#define PD4J_SCHEDULER_THREAD_STATUS_RUNNABLE 0x0005
+#define PD4J_SCHEDULER_THREAD_STATUS_TERMINATED 0x0002
+
+static pd4j_thread_stack_entry *pd4j_scheduler_instance_field(pd4j_thread_reference *instance, const char *name) {
+	if (instance == NULL || instance->kind != pd4j_REF_INSTANCE) {
+		return NULL;
+	}
+	
+	for (uint32_t i = 0; i < instance->data.instance.numInstanceFields; i++) {
+		pd4j_thread_stack_entry *field = &instance->data.instance.instanceFields[i];
+		
+		if (strcmp((const char *)(field->name), name) == 0) {
+			return field;
+		}
+	}
+	
+	return NULL;
+}
+
+// a field of the Thread.FieldHolder that newer class libraries keep the state of a thread in, or NULL
+static pd4j_thread_stack_entry *pd4j_scheduler_holder_field(pd4j_thread_reference *javaThread, const char *name) {
+	pd4j_thread_stack_entry *holder = pd4j_scheduler_instance_field(javaThread, "holder");
+	
+	return (holder == NULL) ? NULL : pd4j_scheduler_instance_field(holder->data.referenceValue, name);
+}
+
+// what the VM does when a thread started from Java terminates: Thread.isAlive sees eetop cleared, and Thread.join is woken from waiting on the Thread
+static void pd4j_scheduler_java_thread_exited(pd4j_scheduler_task *task) {
+	pd4j_thread *thread = task->thread;
+	pd4j_thread_reference *javaThread = task->javaThread;
+	pd4j_thread_reference *throwable = pd4j_thread_get_exception(thread);
+	
+	if (throwable != NULL) {
+		pd4j_thread_print_stack_trace(throwable);
+	}
+	
+	pd4j_thread_stack_entry *eetop = pd4j_scheduler_instance_field(javaThread, "eetop");
+	pd4j_thread_stack_entry *status = pd4j_scheduler_holder_field(javaThread, "threadStatus");
+	
+	if (eetop != NULL) {
+		eetop->data.longValue = 0;
+	}
+	
+	if (status != NULL) {
+		status->data.intValue = PD4J_SCHEDULER_THREAD_STATUS_TERMINATED;
+	}
+	
+	pd4j_thread_monitor_notify_exited(javaThread);
+	
+	// takes the task with it
+	pd4j_thread_destroy(thread);
+}
+
+uint32_t pd4j_scheduler_run(pd4j_scheduler *scheduler, uint32_t maxMicros) {
+	float deadline = pd->system->getElapsedTime() + (float)maxMicros / 1000000.0f;
+	
+	while (true) {
+		uint32_t slice = PD4J_SCHEDULER_TIME_SLICE;
+		
+		if (maxMicros != 0) {
+			float remaining = (deadline - pd->system->getElapsedTime()) * 1000000.0f;
+			
+			if (remaining < 1.0f) {
+				break;
+			}
+			else if (remaining < (float)slice) {
+				slice = (uint32_t)remaining;
+			}
+		}
+		
+		pd4j_scheduler_wake_timers(scheduler);
+		
+		pd4j_scheduler_task *task = pd4j_scheduler_next(scheduler);
+		if (task == NULL) {
+			break;
+		}
+		
+		scheduler->current = task;
+		pd4j_thread_run_status status = pd4j_thread_run(task->thread, 0, slice);
+		
+		// the thread may have been removed from the scheduler while it ran
+		if (scheduler->current != task) {
+			continue;
+		}
+		
+		scheduler->current = NULL;
+		
+		switch (status) {
+			case pd4j_THREAD_RUN_BUDGET_EXHAUSTED:
+			case pd4j_THREAD_RUN_BLOCKED: {
+				// tasks that are still runnable were preempted or yielded, and go behind the others of their priority
+				if (task->state == pd4j_TASK_RUNNABLE) {
+					pd4j_scheduler_enqueue(scheduler, task);
+				}
+				break;
+			}
+			case pd4j_THREAD_RUN_FINISHED:
+			case pd4j_THREAD_RUN_THREW: {
+				pd4j_scheduler_timer_remove(scheduler, task);
+				task->state = pd4j_TASK_TERMINATED;
+				scheduler->numAlive--;
+				
+				if (task->javaThread != NULL) {
+					pd4j_scheduler_java_thread_exited(task);
+				}
+				break;
+			}
+		}
+	}
+	
+	return scheduler->numAlive;
+}
+
+static bool pd4j_scheduler_native_thread_sleep(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	int64_t timeout = PD4J_NATIVE_ARG_LONG(args, 0);
+	
+	if (timeout < 0) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalArgumentException", "timeout value is negative");
+		return false;
+	}
+	
+	pd4j_scheduler_sleep(thread, (timeout > PD4J_SCHEDULER_MAX_TIMEOUT) ? PD4J_SCHEDULER_MAX_TIMEOUT : (uint32_t)timeout);
+	return true;
+}
+
+static bool pd4j_scheduler_native_thread_start0(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	pd4j_thread_reference *javaThread = PD4J_NATIVE_ARG_REFERENCE(args, 0);
+	pd4j_thread_stack_entry *eetop = pd4j_scheduler_instance_field(javaThread, "eetop");
+	pd4j_thread_stack_entry *status = pd4j_scheduler_holder_field(javaThread, "threadStatus");
+	pd4j_thread_stack_entry *priority = pd4j_scheduler_holder_field(javaThread, "priority");
+	
+	if ((eetop != NULL && eetop->data.longValue != 0) || (status != NULL && status->data.intValue != 0)) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalThreadStateException", "Thread has already been started");
+		return false;
+	}
+	
+	pd4j_thread *started = pd4j_thread_new(NULL);
+	if (started == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate thread: Out of memory");
+		return false;
+	}
+	
+	// Thread.run, or whatever the class of the Thread overrides it with
+	pd4j_thread_reference runRef;
+	runRef.resolved = true;
+	runRef.kind = pd4j_REF_CLASS_METHOD;
+	runRef.data.method.name = (uint8_t *)"run";
+	runRef.data.method.descriptor = (uint8_t *)"()V";
+	runRef.data.method.class = javaThread->data.instance.class;
+	runRef.data.method.declaringClass = NULL;
+	runRef.data.method.property = NULL;
+	runRef.lockWord = 0;
+	
+	pd4j_scheduler *scheduler = pd4j_scheduler_get_default();
+	
+	if (!pd4j_thread_start_method(started, javaThread, &runRef) || scheduler == NULL || !pd4j_scheduler_add(scheduler, started, (priority != NULL) ? (uint8_t)(priority->data.intValue) : PD4J_SCHEDULER_NORM_PRIORITY)) {
+		pd4j_thread_destroy(started);
+		
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to start thread: Out of memory");
+		return false;
+	}
+	
+	pd4j_thread_get_task(started)->javaThread = javaThread;
+	
+	// HotSpot keeps its own thread here, and Thread.isAlive only checks that it isn't 0
+	if (eetop != NULL) {
+		eetop->data.longValue = (int64_t)(intptr_t)started;
+	}
+	
+	if (status != NULL) {
+		status->data.intValue = PD4J_SCHEDULER_THREAD_STATUS_RUNNABLE;
+	}
+	
+	return true;
+}
+
+static bool pd4j_scheduler_native_thread_yield(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)args;
+	(void)result;
+	
+	pd4j_scheduler_yield(thread);
+	return true;
+}
+
+// the pd4j_thread that start0 made for a Thread, or NULL if it hasn't been started or has terminated
+static pd4j_thread *pd4j_scheduler_java_thread(pd4j_thread_reference *javaThread) {
+	pd4j_thread_stack_entry *eetop = pd4j_scheduler_instance_field(javaThread, "eetop");
+	
+	return (eetop == NULL) ? NULL : (pd4j_thread *)(intptr_t)(eetop->data.longValue);
+}
+
+// seconds from the Unix epoch to the Playdate's, which is the start of 2000
+#define PD4J_SCHEDULER_EPOCH_OFFSET 946684800LL
+
+static int64_t pd4j_scheduler_epoch_millis(void) {
+	unsigned int millis;
+	unsigned int seconds = pd->system->getSecondsSinceEpoch(&millis);
+	
+	return ((int64_t)seconds + PD4J_SCHEDULER_EPOCH_OFFSET) * 1000 + millis;
+}
+
+static bool pd4j_scheduler_native_unsafe_park(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	bool isAbsolute = PD4J_NATIVE_ARG_INT(args, 1) != 0;
+	int64_t time = PD4J_NATIVE_ARG_LONG(args, 2);
+	int64_t millis;
+	
+	if (isAbsolute) {
+		// a deadline in milliseconds since the epoch, which may already have passed
+		millis = time - pd4j_scheduler_epoch_millis();
+		if (millis <= 0) {
+			return true;
+		}
+	}
+	else if (time < 0) {
+		return true;
+	}
+	else {
+		// nanoseconds, rounded up so a short park still waits instead of lasting forever
+		millis = (time + 999999) / 1000000;
+	}
+	
+	pd4j_scheduler_park(thread, (millis > PD4J_SCHEDULER_MAX_TIMEOUT) ? PD4J_SCHEDULER_MAX_TIMEOUT : (uint32_t)millis);
+	return true;
+}
+
+static bool pd4j_scheduler_native_unsafe_unpark(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)thread;
+	(void)result;
+	
+	pd4j_thread *target = pd4j_scheduler_java_thread(PD4J_NATIVE_ARG_REFERENCE(args, 1));
+	
+	if (target != NULL) {
+		pd4j_scheduler_unpark(target);
+	}
+	return true;
+}
+
+static bool pd4j_scheduler_native_system_current_time_millis(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)thread;
+	(void)args;
+	
+	PD4J_NATIVE_RETURN_LONG(result, pd4j_scheduler_epoch_millis());
+	return true;
+}
+
+static bool pd4j_scheduler_native_system_nano_time(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)thread;
+	(void)args;
+	
+	// the same clock the scheduler times sleeps with, which games can't reset
+	PD4J_NATIVE_RETURN_LONG(result, (int64_t)(pd->system->getCurrentTimeMilliseconds()) * 1000000);
+	return true;
+}
+
+static const pd4j_native_method pd4j_scheduler_natives[] = {
+	// Thread.join is Java code that waits on the Thread until isAlive sees eetop cleared, so it needs no native of its own
+	{"java/lang/Thread", "start0", "()V", pd4j_scheduler_native_thread_start0},
+	// sleep0 and yield0 are what Thread.sleep and Thread.yield call since JDK 19
+	{"java/lang/Thread", "sleep", "(J)V", pd4j_scheduler_native_thread_sleep},
+	{"java/lang/Thread", "sleep0", "(J)V", pd4j_scheduler_native_thread_sleep},
+	{"java/lang/Thread", "yield", "()V", pd4j_scheduler_native_thread_yield},
+	{"java/lang/Thread", "yield0", "()V", pd4j_scheduler_native_thread_yield},
+	// what LockSupport parks and unparks threads with
+	{"jdk/internal/misc/Unsafe", "park", "(ZJ)V", pd4j_scheduler_native_unsafe_park},
+	{"jdk/internal/misc/Unsafe", "unpark", "(Ljava/lang/Object;)V", pd4j_scheduler_native_unsafe_unpark},
+	{"java/lang/System", "currentTimeMillis", "()J", pd4j_scheduler_native_system_current_time_millis},
+	{"java/lang/System", "nanoTime", "()J", pd4j_scheduler_native_system_nano_time}
+};
+
+bool pd4j_scheduler_register_natives(void) {
+	return pd4j_native_register(pd4j_scheduler_natives, sizeof(pd4j_scheduler_natives) / sizeof(pd4j_native_method));
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#ifndef PD4J_SCHEDULER_H
+#define PD4J_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "thread.h"
+
+// same range as the priorities of java.lang.Thread
+#define PD4J_SCHEDULER_MIN_PRIORITY 1
+#define PD4J_SCHEDULER_NORM_PRIORITY 5
+#define PD4J_SCHEDULER_MAX_PRIORITY 10
+// microseconds a thread runs before others of the same priority get a turn
+#define PD4J_SCHEDULER_TIME_SLICE 2000
+// the longest timeout the millisecond clock can time, since wake times are compared as if it wraps around; longer ones are cut down to it
+#define PD4J_SCHEDULER_MAX_TIMEOUT INT32_MAX
+
+typedef enum {
+	pd4j_TASK_RUNNABLE = 0,
+	pd4j_TASK_SLEEPING,
+	pd4j_TASK_PARKED,
+	// waiting for pd4j_scheduler_resume, like a thread waiting to enter a monitor
+	pd4j_TASK_BLOCKED,
+	// in Object.wait, until notified or timed out
+	pd4j_TASK_WAITING,
+	pd4j_TASK_TERMINATED
+} pd4j_scheduler_task_state;
+
+typedef struct pd4j_scheduler pd4j_scheduler;
+typedef struct pd4j_scheduler_task pd4j_scheduler_task;
+
+pd4j_scheduler *pd4j_scheduler_get_default(void);
+
+pd4j_scheduler *pd4j_scheduler_new(void);
+void pd4j_scheduler_destroy(pd4j_scheduler *scheduler);
+
+// hands a thread that has been started with pd4j_thread_start_method to the scheduler, which doesn't take ownership of it
+bool pd4j_scheduler_add(pd4j_scheduler *scheduler, pd4j_thread *thread, uint8_t priority);
+// takes a thread back from its scheduler
+void pd4j_scheduler_remove(pd4j_thread *thread);
+
+void pd4j_scheduler_set_priority(pd4j_thread *thread, uint8_t priority);
+pd4j_scheduler_task_state pd4j_scheduler_get_state(pd4j_thread *thread);
+
+// these are called from native methods on the running thread, which stops at the next safepoint so another thread can run
+// a thread that doesn't belong to a scheduler carries on as if it had been woken straight away
+void pd4j_scheduler_yield(pd4j_thread *thread);
+void pd4j_scheduler_sleep(pd4j_thread *thread, uint32_t millis);
+// a timeout of 0 waits forever
+void pd4j_scheduler_park(pd4j_thread *thread, uint32_t millis);
+
+// unlike park, suspending also stops a thread that doesn't belong to a scheduler, which is then left to whoever runs it to hold back
+void pd4j_scheduler_suspend(pd4j_thread *thread);
+// like suspending, but the thread is woken when the timeout runs out (if it isn't 0) so it can give up waiting
+void pd4j_scheduler_wait(pd4j_thread *thread, uint32_t millis);
+
+void pd4j_scheduler_unpark(pd4j_thread *thread);
+void pd4j_scheduler_resume(pd4j_thread *thread);
+// turns a waiting thread into a suspended one, cancelling its timeout
+void pd4j_scheduler_notify(pd4j_thread *thread);
+
+// registers the natives of java.lang.Thread, the clocks of java.lang.System, and Unsafe.park and unpark
+// a thread started with Thread.start belongs to the scheduler, which destroys it once it terminates
+bool pd4j_scheduler_register_natives(void);
+
+// runs the highest priority runnable threads round-robin for up to maxMicros (or until none are runnable, if 0)
+// returns the number of threads that haven't terminated
+uint32_t pd4j_scheduler_run(pd4j_scheduler *scheduler, uint32_t maxMicros);
+
+#endif
\ No newline at end of file
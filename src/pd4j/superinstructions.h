@@ -0,0 +1,18 @@
+#ifndef PD4J_SUPERINSTRUCTIONS_H
+#define PD4J_SUPERINSTRUCTIONS_H
+
+#include "link.h"
+
+// generated by tools/superinstructions.py from opcode profiles of the workloads; earlier entries are tried first
+static const pd4j_link_superinstruction pd4j_link_superinstructions[] = {
+	// iload, iload, iadd, istore
+	{pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE, 4, {0x15, 0x15, 0x60, 0x36}},
+	// aload, iload, iaload
+	{pd4j_OPCODE_ALOAD_ILOAD_IALOAD, 3, {0x19, 0x15, 0x2e}},
+	// iload, bipush, if_icmplt
+	{pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT, 3, {0x15, 0x10, 0xa1}},
+	// aload_0, getfield
+	{pd4j_OPCODE_ALOAD_0_GETFIELD, 2, {0x2a, 0xb4}}
+};
+
+#endif
\ No newline at end of file
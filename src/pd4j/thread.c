@@ -6,32 +6,154 @@
 
 #include "api_ptr.h"
 #include "class.h"
-#include "descriptor.h"
+#include "class_loader.h"
+#include "link.h"
 #include "list.h"
 #include "memory.h"
+#include "native.h"
 #include "resolve.h"
+#include "scheduler.h"
 #include "thread.h"
 #include "utf8.h"
 
 static uint32_t newThreadId = 0;
 
-typedef struct {
+// frames are carved out of these in order; a thread keeps every segment it has used until it is destroyed
+typedef struct pd4j_thread_stack_segment {
+	struct pd4j_thread_stack_segment *prev;
+	struct pd4j_thread_stack_segment *next;
+	
+	// next free byte and end of the usable space, which directly follows this header
+	uint8_t *top;
+	uint8_t *end;
+} pd4j_thread_stack_segment;
+
+typedef struct pd4j_thread_frame {
+	struct pd4j_thread_frame *prev;
+	pd4j_thread_stack_segment *segment;
+	
+	// top of the frame's segment and the thread's current segment from before the frame was carved out, restored when it is popped
+	uint8_t *savedTop;
+	pd4j_thread_stack_segment *savedSegment;
+	
+	// the locals come directly before this header, and begin with the argument slots of the calling frame's operand stack when possible
 	uint16_t numLocals;
 	pd4j_thread_variable *locals;
 	
 	// starting PC address for this frame (needed for alignment)
 	uint8_t *startPc;
 	
+	// long and double values take two slots and are kept whole in native byte order where pd4j_thread_slots_wide points, like in the local variables
 	uint16_t sp;
 	uint16_t operandStackSize;
-	pd4j_thread_stack_entry *operandStack;
+	pd4j_thread_variable *operandStack;
 	
 	pd4j_thread_reference *currentMethod;
+	pd4j_link_method *link;
+	
+	// PC address of the calling frame to resume at once this frame is popped
+	uint8_t *returnPc;
 	
 	// when true and the frame is popped, this will push the return value to the argStack instead of the operandStack of the previous frame
 	bool wasInternalCall;
+	
+	// set on the entry frame of a continuation, which finishes when the frame is popped
+	struct pd4j_thread_continuation *continuation;
+	
+	// the object (or class) a synchronized method locked, unlocked again when the frame returns
+	pd4j_thread_reference *lockedObject;
 } pd4j_thread_frame;
 
+// lock word layout: while thinly locked, the owner's ID plus 1 sits above the count of times it re-entered the lock
+#define PD4J_THREAD_LOCK_INFLATED 0x1
+#define PD4J_THREAD_LOCK_RECURSION_UNIT 0x2
+#define PD4J_THREAD_LOCK_RECURSION_MASK 0xfe
+#define PD4J_THREAD_LOCK_OWNER_SHIFT 8
+
+// the full monitor a lock word is inflated to once a second thread contends for it or it re-enters too many times to count
+typedef struct {
+	// ID of the owning thread plus 1, or 0 when unowned
+	uint32_t owner;
+	uint32_t entryCount;
+	
+	// threads waiting to enter, oldest first, linked through nextWaiter
+	pd4j_thread *entryHead;
+	pd4j_thread *entryTail;
+	// threads in Object.wait, oldest first, which move to the entry queue when they're notified
+	pd4j_thread *waitHead;
+	pd4j_thread *waitTail;
+} pd4j_thread_monitor;
+
+// one frame an exception was thrown through
+typedef struct {
+	pd4j_link_method *method;
+	// offset of the instruction that was running, or of some byte in it
+	uint16_t pcOffset;
+} pd4j_thread_backtrace_frame;
+
+typedef struct pd4j_thread_backtrace {
+	// frames there's room for, which an implicit exception's backtrace is refilled up to each time it's thrown
+	uint32_t capacity;
+	uint32_t numFrames;
+	// an implicit exception's message, which is only formatted if it's asked for (NULL if there's none left to format)
+	const char *messageFormat;
+	int32_t messageArgs[2];
+	// innermost first
+	pd4j_thread_backtrace_frame frames[];
+} pd4j_thread_backtrace;
+
+struct pd4j_thread_implicit_pool {
+	// NULL past the instances that could be made
+	pd4j_thread_reference *instances[pd4j_IMPLICIT_COUNT][PD4J_THREAD_IMPLICIT_POOL_SIZE];
+	uint8_t next[pd4j_IMPLICIT_COUNT];
+	// what detailMessage goes back to when an instance is reused
+	pd4j_thread_reference nullMessage;
+};
+
+static const char *pd4j_thread_implicit_class_names[pd4j_IMPLICIT_COUNT] = {
+	"java/lang/NullPointerException",
+	"java/lang/ArrayIndexOutOfBoundsException",
+	"java/lang/ArithmeticException",
+	"java/lang/IllegalMonitorStateException",
+	"java/lang/OutOfMemoryError"
+};
+
+typedef enum {
+	pd4j_CONTINUATION_NEW = 0,
+	pd4j_CONTINUATION_MOUNTED,
+	pd4j_CONTINUATION_YIELDED,
+	pd4j_CONTINUATION_DONE
+} pd4j_thread_continuation_state;
+
+struct pd4j_thread_continuation {
+	pd4j_thread_continuation_state state;
+	
+	// the method and receiver the entry frame is pushed for when the continuation is first mounted
+	pd4j_link_method *entry;
+	pd4j_thread_reference *instance;
+	
+	// the continuation's frames live in its own segments, so they never have to be copied when it's mounted or yields
+	pd4j_thread_stack_segment *firstSegment;
+	pd4j_thread_stack_segment *stackSegment;
+	
+	// the entry frame and the top frame, with the PC and the number of frames to resume with
+	pd4j_thread_frame *bottom;
+	pd4j_thread_frame *frame;
+	uint8_t *pc;
+	uint32_t depth;
+	
+	// what the thread was running when the continuation was mounted, restored when it yields or finishes
+	pd4j_thread_stack_segment *callerSegment;
+	uint32_t callerDepth;
+	struct pd4j_thread_continuation *parent;
+	
+	// the jdk.internal.vm.Continuation that Continuation.enterSpecial made this for, or NULL if it was made outside the VM
+	pd4j_thread_reference *object;
+};
+
+// components should be pd4j_thread_continuation *, for every Continuation that has been entered but hasn't finished
+static pd4j_list *javaContinuations = NULL;
+
 struct pd4j_thread {
 	char *threadName;
 	size_t threadNameLength;
@@ -39,24 +161,164 @@ struct pd4j_thread {
 	uint32_t threadId;
 	
 	uint8_t *pc;
-	uint32_t lineNum;
 	
-	// components should be pd4j_thread_frame *
-	pd4j_list *jvmStack;
+	// instructions executed so far, for the budget of pd4j_thread_run
+	uint32_t instructionCount;
+	// set at backward branches and method entries, the only places pd4j_thread_run checks its budget
+	bool safepoint;
+	bool blocked;
+	
+	pd4j_scheduler_task *task;
+	// the monitor this thread is queued to enter or waiting on, and the next thread in its queue
+	pd4j_thread_monitor *blockedOn;
+	pd4j_thread_monitor *waitingOn;
+	pd4j_thread *nextWaiter;
+	// how many times the thread will hold the monitor it's queued to enter once it's handed it
+	uint32_t lockCount;
+	// innermost mounted continuation, linked to any it was mounted inside
+	pd4j_thread_continuation *continuation;
+	
+	// topmost frame, linked to the ones below it
+	pd4j_thread_frame *frame;
+	uint32_t depth;
+	uint32_t maxDepth;
+	
+	pd4j_thread_stack_segment *stackSegment;
 	
-	// used only for internal JVM calls; components should be pd4j_thread_stack_entry *
-	pd4j_list *argStack;
+	// used only for internal JVM calls, holds PD4J_THREAD_MAX_ARGS values
+	pd4j_thread_stack_entry *argStack;
+	uint16_t numArgs;
 	
 	pd4j_thread_reference *throwable;
-	pd4j_thread_reference *monitor;
+	// set while the Throwable for an exception thrown from native code is made, when any other exception would be fatal
+	bool throwing;
 };
 
+static pd4j_thread_stack_segment *pd4j_thread_stack_segment_new(pd4j_thread_stack_segment *prev, size_t size) {
+	pd4j_thread_stack_segment *segment = pd4j_malloc(sizeof(pd4j_thread_stack_segment) + size);
+	
+	if (segment != NULL) {
+		segment->prev = prev;
+		segment->next = NULL;
+		segment->top = (uint8_t *)(segment + 1);
+		segment->end = segment->top + size;
+	}
+	
+	return segment;
+}
+
+// frame headers and 64-bit values are kept 8-byte aligned
+static inline uint8_t *pd4j_thread_align(uint8_t *ptr) {
+	return (uint8_t *)(((uintptr_t)ptr + 7) & ~(uintptr_t)7);
+}
+
+// carves a frame with room for its locals and operand stack out of the thread's stack
+// if args is not NULL, the frame is laid over those slots at the top of the calling frame's operand stack so they become its first locals, and they are only copied when the frame doesn't fit there
+static pd4j_thread_frame *pd4j_thread_frame_alloc(pd4j_thread *thread, pd4j_thread_variable *args, uint16_t numArgSlots, uint16_t numLocals, uint16_t operandStackSize) {
+	if (thread->depth >= thread->maxDepth) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/StackOverflowError", "Maximum stack depth exceeded");
+		return NULL;
+	}
+	
+	size_t headerSize = (sizeof(pd4j_thread_frame) + 7) & ~(size_t)7;
+	size_t size = numLocals * sizeof(pd4j_thread_variable) + 7 + headerSize + operandStackSize * sizeof(pd4j_thread_variable);
+	
+	pd4j_thread_stack_segment *segment = thread->stackSegment;
+	uint8_t *start = (args != NULL) ? (uint8_t *)args : segment->top;
+	
+	if (start + size > segment->end) {
+		pd4j_thread_stack_segment *next = segment->next;
+		
+		if (next != NULL && (size_t)(next->end - next->top) < size) {
+			// too small for this frame, so replace it (and anything after it)
+			while (next != NULL) {
+				pd4j_thread_stack_segment *after = next->next;
+				pd4j_free(next, sizeof(pd4j_thread_stack_segment) + (size_t)(next->end - (uint8_t *)(next + 1)));
+				next = after;
+			}
+		}
+		
+		if (next == NULL) {
+			next = pd4j_thread_stack_segment_new(segment, (size > PD4J_THREAD_STACK_SEGMENT_SIZE) ? size : PD4J_THREAD_STACK_SEGMENT_SIZE);
+			
+			if (next == NULL) {
+				pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate stack segment: Out of memory");
+				return NULL;
+			}
+			
+			segment->next = next;
+		}
+		
+		segment = next;
+		start = segment->top;
+		
+		if (args != NULL) {
+			memcpy(start, args, numArgSlots * sizeof(pd4j_thread_variable));
+		}
+	}
+	
+	pd4j_thread_frame *frame = (pd4j_thread_frame *)pd4j_thread_align(start + numLocals * sizeof(pd4j_thread_variable));
+	
+	frame->savedTop = segment->top;
+	frame->savedSegment = thread->stackSegment;
+	
+	segment->top = (uint8_t *)frame + headerSize + operandStackSize * sizeof(pd4j_thread_variable);
+	thread->stackSegment = segment;
+	
+	frame->prev = thread->frame;
+	frame->segment = segment;
+	frame->continuation = NULL;
+	frame->lockedObject = NULL;
+	
+	frame->numLocals = numLocals;
+	frame->locals = (pd4j_thread_variable *)start;
+	
+	frame->sp = 0;
+	frame->operandStackSize = operandStackSize;
+	frame->operandStack = (pd4j_thread_variable *)((uint8_t *)frame + headerSize);
+	
+	return frame;
+}
+
+// gives the space of a frame back to the thread's stack
+static void pd4j_thread_frame_release(pd4j_thread *thread, pd4j_thread_frame *frame) {
+	frame->segment->top = frame->savedTop;
+	thread->stackSegment = frame->savedSegment;
+}
+
 static void pd4j_thread_frame_pop(pd4j_thread *thread) {
-	pd4j_thread_frame *frame = pd4j_list_pop(thread->jvmStack);
+	pd4j_thread_frame *frame = thread->frame;
+	
+	thread->pc = frame->returnPc;
+	thread->frame = frame->prev;
+	thread->depth--;
 	
-	pd4j_free(frame->locals, frame->numLocals * sizeof(pd4j_thread_variable));
-	pd4j_free(frame->operandStack, frame->operandStackSize * sizeof(pd4j_thread_stack_entry));
-	pd4j_free(frame, sizeof(pd4j_thread_frame));
+	pd4j_thread_frame_release(thread, frame);
+	
+	if (frame->continuation != NULL) {
+		// the continuation returned, so the thread goes back to the stack it was mounted on
+		pd4j_thread_continuation *continuation = frame->continuation;
+		
+		thread->stackSegment = continuation->callerSegment;
+		thread->continuation = continuation->parent;
+		
+		continuation->state = pd4j_CONTINUATION_DONE;
+		continuation->bottom = NULL;
+		continuation->frame = NULL;
+		continuation->parent = NULL;
+		
+		// nothing can mount a finished Continuation again, so the VM lets go of its frames straight away
+		if (continuation->object != NULL) {
+			for (uint32_t i = 0; i < javaContinuations->size; i++) {
+				if (javaContinuations->array[i] == continuation) {
+					pd4j_list_remove(javaContinuations, i);
+					break;
+				}
+			}
+			
+			pd4j_thread_continuation_destroy(continuation);
+		}
+	}
 }
 
 pd4j_thread *pd4j_thread_new(uint8_t *name) {
@@ -75,43 +337,100 @@ pd4j_thread *pd4j_thread_new(uint8_t *name) {
 		thread->threadId = newThreadId++;
 		
 		thread->pc = NULL;
-		thread->lineNum = 0;
 		
-		thread->jvmStack = pd4j_list_new(4);
-		thread->argStack = pd4j_list_new(4);
+		thread->instructionCount = 0;
+		thread->safepoint = false;
+		thread->blocked = false;
+		
+		thread->task = NULL;
+		thread->blockedOn = NULL;
+		thread->waitingOn = NULL;
+		thread->nextWaiter = NULL;
+		thread->lockCount = 0;
+		thread->continuation = NULL;
+		
+		thread->frame = NULL;
+		thread->depth = 0;
+		thread->maxDepth = PD4J_THREAD_DEFAULT_MAX_DEPTH;
+		thread->stackSegment = pd4j_thread_stack_segment_new(NULL, PD4J_THREAD_STACK_SEGMENT_SIZE);
 		
-		thread->monitor = NULL;
+		thread->argStack = pd4j_malloc(PD4J_THREAD_MAX_ARGS * sizeof(pd4j_thread_stack_entry));
+		thread->numArgs = 0;
+		
+		thread->throwable = NULL;
+		thread->throwing = false;
 	}
 	
 	return thread;
 }
 
 pd4j_thread_reference *pd4j_thread_current_class(pd4j_thread *thread) {
-	pd4j_thread_frame *frame = thread->jvmStack->array[thread->jvmStack->size - 1];
-	return frame->currentMethod->data.method.class;
+	return thread->frame->currentMethod->data.method.class;
+}
+
+void pd4j_thread_set_max_depth(pd4j_thread *thread, uint32_t maxDepth) {
+	thread->maxDepth = maxDepth;
+}
+
+pd4j_scheduler_task *pd4j_thread_get_task(pd4j_thread *thread) {
+	return thread->task;
+}
+
+void pd4j_thread_set_task(pd4j_thread *thread, pd4j_scheduler_task *task) {
+	thread->task = task;
+}
+
+// whether an instance is one of its class loader's implicit exceptions, which only the pool frees
+static bool pd4j_thread_implicit_pool_owns(pd4j_thread_reference *instance) {
+	pd4j_thread_implicit_pool *pool = pd4j_class_loader_get_implicit_pool(instance->data.instance.class->data.class.loaded->definingLoader);
+	
+	if (pool == NULL) {
+		return false;
+	}
+	
+	for (uint32_t kind = 0; kind < pd4j_IMPLICIT_COUNT; kind++) {
+		for (uint32_t i = 0; i < PD4J_THREAD_IMPLICIT_POOL_SIZE && pool->instances[kind][i] != NULL; i++) {
+			if (pool->instances[kind][i] == instance) {
+				return true;
+			}
+		}
+	}
+	
+	return false;
 }
 
 void pd4j_thread_destroy(pd4j_thread *thread) {
-	if (thread->throwable != NULL) {
-		pd4j_free(thread->throwable, sizeof(pd4j_thread_reference));
+	pd4j_scheduler_remove(thread);
+	
+	if (thread->throwable != NULL && !pd4j_thread_implicit_pool_owns(thread->throwable)) {
+		pd4j_thread_reference_destroy(thread->throwable);
 	}
 	
-	for (uint32_t i = 0; i < thread->argStack->size; i++) {
-		pd4j_thread_stack_entry *value = pd4j_thread_arg_pop(thread);
+	for (uint16_t i = 0; i < thread->numArgs; i++) {
+		pd4j_thread_stack_entry *value = &thread->argStack[i];
 		
 		if (value->tag == pd4j_VARIABLE_REFERENCE && value->data.referenceValue != NULL) {
 			pd4j_thread_reference_destroy(value->data.referenceValue);
 		}
-	
-		pd4j_free(value, sizeof(pd4j_thread_stack_entry));
 	}
 	
-	for (uint32_t i = 0; i < thread->jvmStack->size; i++) {
+	while (thread->frame != NULL) {
 		pd4j_thread_frame_pop(thread);
 	}
 	
-	pd4j_list_destroy(thread->argStack);
-	pd4j_list_destroy(thread->jvmStack);
+	pd4j_thread_stack_segment *segment = thread->stackSegment;
+	
+	while (segment != NULL && segment->prev != NULL) {
+		segment = segment->prev;
+	}
+	
+	while (segment != NULL) {
+		pd4j_thread_stack_segment *next = segment->next;
+		pd4j_free(segment, sizeof(pd4j_thread_stack_segment) + (size_t)(segment->end - (uint8_t *)(segment + 1)));
+		segment = next;
+	}
+	
+	pd4j_free(thread->argStack, PD4J_THREAD_MAX_ARGS * sizeof(pd4j_thread_stack_entry));
 	
 	pd4j_free(thread->threadName, thread->threadNameLength);
 	pd4j_free(thread, sizeof(pd4j_thread));
@@ -137,12 +456,20 @@ void pd4j_thread_reference_destroy(pd4j_thread_reference *thRef) {
 			}
 			case pd4j_REF_INSTANCE:
 				pd4j_free(thRef->data.instance.instanceFields, thRef->data.instance.numInstanceFields * sizeof(pd4j_thread_stack_entry));
+				
+				if (thRef->data.instance.backtrace != NULL) {
+					pd4j_free(thRef->data.instance.backtrace, sizeof(pd4j_thread_backtrace) + thRef->data.instance.backtrace->capacity * sizeof(pd4j_thread_backtrace_frame));
+				}
 				break;
 			default:
 				break;
 		}
 	}
 	
+	if ((thRef->lockWord & PD4J_THREAD_LOCK_INFLATED) != 0) {
+		pd4j_free((void *)(thRef->lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_INFLATED), sizeof(pd4j_thread_monitor));
+	}
+	
 	pd4j_free(thRef, sizeof(pd4j_thread_reference));
 }
 
@@ -196,8 +523,7 @@ bool pd4j_thread_initialize_class(pd4j_thread *thread, pd4j_thread_reference *th
 			staticFieldRef->tag = pd4j_VARIABLE_REFERENCE;
 			staticFieldRef->data.referenceValue->resolved = true;
 			staticFieldRef->data.referenceValue->kind = pd4j_REF_NULL;
-			staticFieldRef->data.referenceValue->monitor.owner = NULL;
-			staticFieldRef->data.referenceValue->monitor.entryCount = 0;
+			staticFieldRef->data.referenceValue->lockWord = 0;
 			
 			for (uint16_t j = 0; j < field.numAttributes; j++) {
 				if (strcmp((const char *)(field.attributes[j].name), "ConstantValue") == 0) {
@@ -259,17 +585,19 @@ bool pd4j_thread_initialize_class(pd4j_thread *thread, pd4j_thread_reference *th
 	clinitRef.kind = pd4j_REF_CLASS_METHOD;
 	clinitRef.data.method.name = (uint8_t *)"<clinit>";
 	clinitRef.data.method.descriptor = (uint8_t *)"()V";
+	clinitRef.data.method.returnTypeDescriptor = NULL;
+	clinitRef.data.method.argumentDescriptors = NULL;
 	clinitRef.data.method.class = thRef;
-	clinitRef.monitor.owner = NULL;
-	clinitRef.monitor.entryCount = 0;
+	clinitRef.data.method.declaringClass = NULL;
+	clinitRef.data.method.property = NULL;
+	clinitRef.lockWord = 0;
 	
-	if (!pd4j_descriptor_parse_method(clinitRef.data.method.descriptor, thRef->data.class.loaded, thread, &clinitRef)) {
-		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate method handle for class initialization method: Out of memory");
-		return false;
+	for (uint16_t i = 0; i < class->numMethods; i++) {
+		if (strcmp((const char *)(class->methods[i].name), "<clinit>") == 0) {
+			return pd4j_thread_invoke_static_method(thread, &clinitRef);
+		}
 	}
 	
-	pd4j_thread_invoke_static_method(thread, &clinitRef);
-	
 	return true;
 }
 
@@ -325,8 +653,7 @@ bool pd4j_thread_construct_instance(pd4j_thread *thread, pd4j_thread_reference *
 			instanceFieldRef->tag = pd4j_VARIABLE_REFERENCE;
 			instanceFieldRef->data.referenceValue->resolved = true;
 			instanceFieldRef->data.referenceValue->kind = pd4j_REF_NULL;
-			instanceFieldRef->data.referenceValue->monitor.owner = NULL;
-			instanceFieldRef->data.referenceValue->monitor.entryCount = 0;
+			instanceFieldRef->data.referenceValue->lockWord = 0;
 			
 			if (strpbrk((char *)(field.descriptor), "BCDFIJSZ") == (char *)(field.descriptor)) {
 				switch (field.descriptor[0]) {
@@ -370,9 +697,10 @@ bool pd4j_thread_construct_instance(pd4j_thread *thread, pd4j_thread_reference *
 	instanceRef->resolved = true;
 	instanceRef->kind = pd4j_REF_INSTANCE;
 	instanceRef->data.instance.numInstanceFields = (uint16_t)(instanceFields->size);
-	instanceRef->data.instance.instanceFields = pd4j_malloc(thRef->data.instance.numInstanceFields * sizeof(pd4j_thread_stack_entry));
-	instanceRef->monitor.owner = NULL;
-	instanceRef->monitor.entryCount = 0;
+	instanceRef->data.instance.instanceFields = pd4j_malloc(instanceRef->data.instance.numInstanceFields * sizeof(pd4j_thread_stack_entry));
+	instanceRef->data.instance.class = thRef;
+	instanceRef->data.instance.backtrace = NULL;
+	instanceRef->lockWord = 0;
 	
 	for (uint32_t i = 0; i < instanceFields->size; i++) {
 		memcpy(&instanceRef->data.instance.instanceFields[i], instanceFields->array[i], sizeof(pd4j_thread_stack_entry));
@@ -388,318 +716,1781 @@ bool pd4j_thread_construct_instance(pd4j_thread *thread, pd4j_thread_reference *
 }
 
 void pd4j_thread_arg_push(pd4j_thread *thread, pd4j_thread_stack_entry *value) {
-	pd4j_thread_stack_entry *valueCopy = pd4j_malloc(sizeof(pd4j_thread_stack_entry));
-	memcpy(valueCopy, value, sizeof(pd4j_thread_stack_entry));
+	if (thread->numArgs == PD4J_THREAD_MAX_ARGS) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/InternalError", "Too many arguments passed to internal method call");
+		return;
+	}
+	
+	memcpy(&thread->argStack[thread->numArgs++], value, sizeof(pd4j_thread_stack_entry));
+}
+
+bool pd4j_thread_arg_pop(pd4j_thread *thread, pd4j_thread_stack_entry *value) {
+	if (thread->numArgs == 0) {
+		value->tag = pd4j_VARIABLE_NONE;
+		value->name = NULL;
+		value->data.longValue = 0;
+		return false;
+	}
+	
+	memcpy(value, &thread->argStack[--thread->numArgs], sizeof(pd4j_thread_stack_entry));
+	return true;
+}
+
+// slots only carry their type in builds with tagged slots; otherwise it comes from the instruction or descriptor that uses them
+static inline void pd4j_thread_slot_set_tag(pd4j_thread_variable *slot, pd4j_thread_variable_tag tag, uint8_t *name) {
+#ifdef PD4J_TAGGED_SLOTS
+	slot->tag = tag;
+	slot->name = name;
+#else
+	(void)slot;
+	(void)tag;
+	(void)name;
+#endif
+}
+
+static inline uint16_t pd4j_thread_tag_slots(pd4j_thread_variable_tag tag) {
+	return (tag == pd4j_VARIABLE_LONG || tag == pd4j_VARIABLE_DOUBLE) ? 2 : 1;
+}
+
+// the slot type of a value with the given first character of its descriptor
+static pd4j_thread_variable_tag pd4j_thread_descriptor_tag(uint8_t kind) {
+	switch (kind) {
+		case 'B':
+		case 'C':
+		case 'I':
+		case 'S':
+		case 'Z':
+			return pd4j_VARIABLE_INT;
+		case 'F':
+			return pd4j_VARIABLE_FLOAT;
+		case 'J':
+			return pd4j_VARIABLE_LONG;
+		case 'D':
+			return pd4j_VARIABLE_DOUBLE;
+		default:
+			return pd4j_VARIABLE_REFERENCE;
+	}
+}
+
+// the type of value held by the field at a field reference, read from its descriptor without resolving it
+static pd4j_thread_variable_tag pd4j_thread_field_tag(pd4j_class_reference *classRef, uint16_t idx) {
+	pd4j_class *class = classRef->data.class;
+	pd4j_class_constant *nameAndType = &class->constantPool[class->constantPool[idx - 1].data.indices.b - 1];
+	uint8_t *descriptor;
+	
+	if (!pd4j_class_constant_utf8(class, nameAndType->data.indices.b, &descriptor)) {
+		return pd4j_VARIABLE_NONE;
+	}
+	
+	return pd4j_thread_descriptor_tag(descriptor[0]);
+}
+
+static inline void pd4j_thread_slots_set_long(pd4j_thread_variable *slots, pd4j_thread_variable_tag tag, uint8_t *name, int64_t value) {
+	pd4j_thread_slot_set_tag(&slots[0], tag, name);
+	pd4j_thread_slot_set_tag(&slots[1], tag, name);
+	memcpy(pd4j_thread_slots_wide(slots), &value, sizeof(int64_t));
+}
+
+static inline int64_t pd4j_thread_slots_get_long(pd4j_thread_variable *slots) {
+	int64_t value;
+	memcpy(&value, pd4j_thread_slots_wide(slots), sizeof(int64_t));
+	return value;
+}
+
+static inline void pd4j_thread_slots_set_double(pd4j_thread_variable *slots, double value) {
+	pd4j_thread_slot_set_tag(&slots[0], pd4j_VARIABLE_DOUBLE, NULL);
+	pd4j_thread_slot_set_tag(&slots[1], pd4j_VARIABLE_DOUBLE, NULL);
+	memcpy(pd4j_thread_slots_wide(slots), &value, sizeof(double));
+}
+
+static inline double pd4j_thread_slots_get_double(pd4j_thread_variable *slots) {
+	double value;
+	memcpy(&value, pd4j_thread_slots_wide(slots), sizeof(double));
+	return value;
+}
+
+// copies a value into one or two slots and returns how many it took
+static inline uint16_t pd4j_thread_entry_to_slots(pd4j_thread_stack_entry *entry, pd4j_thread_variable *slots) {
+	if (entry->tag == pd4j_VARIABLE_LONG || entry->tag == pd4j_VARIABLE_DOUBLE) {
+		pd4j_thread_slots_set_long(slots, entry->tag, entry->name, entry->data.longValue);
+		return 2;
+	}
+	
+	pd4j_thread_slot_set_tag(&slots[0], entry->tag, entry->name);
+	memcpy(&slots[0].data, &entry->data, sizeof(slots[0].data));
+	return 1;
+}
+
+// boxes the value in one or two slots as the given type
+static inline void pd4j_thread_slots_to_entry(pd4j_thread_variable *slots, pd4j_thread_variable_tag tag, pd4j_thread_stack_entry *entry) {
+	entry->tag = tag;
+	entry->name = NULL;
+	
+	if (tag == pd4j_VARIABLE_LONG || tag == pd4j_VARIABLE_DOUBLE) {
+		entry->data.longValue = pd4j_thread_slots_get_long(slots);
+	}
+	else {
+		memcpy(&entry->data, &slots[0].data, sizeof(slots[0].data));
+	}
+}
+
+static inline void pd4j_thread_push_int(pd4j_thread_frame *frame, int32_t value) {
+	pd4j_thread_variable *top = &frame->operandStack[frame->sp++];
+	
+	pd4j_thread_slot_set_tag(top, pd4j_VARIABLE_INT, NULL);
+	top->data.intValue = value;
+}
+
+static inline int32_t pd4j_thread_pop_int(pd4j_thread_frame *frame) {
+	return frame->operandStack[--frame->sp].data.intValue;
+}
+
+static inline void pd4j_thread_push_float(pd4j_thread_frame *frame, float value) {
+	pd4j_thread_variable *top = &frame->operandStack[frame->sp++];
+	
+	pd4j_thread_slot_set_tag(top, pd4j_VARIABLE_FLOAT, NULL);
+	top->data.floatValue = value;
+}
+
+static inline float pd4j_thread_pop_float(pd4j_thread_frame *frame) {
+	return frame->operandStack[--frame->sp].data.floatValue;
+}
+
+static inline void pd4j_thread_push_reference(pd4j_thread_frame *frame, pd4j_thread_reference *value) {
+	pd4j_thread_variable *top = &frame->operandStack[frame->sp++];
+	
+	pd4j_thread_slot_set_tag(top, pd4j_VARIABLE_REFERENCE, NULL);
+	top->data.referenceValue = value;
+}
+
+static inline pd4j_thread_reference *pd4j_thread_pop_reference(pd4j_thread_frame *frame) {
+	return frame->operandStack[--frame->sp].data.referenceValue;
+}
+
+static inline void pd4j_thread_push_long(pd4j_thread_frame *frame, int64_t value) {
+	pd4j_thread_slots_set_long(&frame->operandStack[frame->sp], pd4j_VARIABLE_LONG, NULL, value);
+	frame->sp += 2;
+}
+
+static inline int64_t pd4j_thread_pop_long(pd4j_thread_frame *frame) {
+	frame->sp -= 2;
+	return pd4j_thread_slots_get_long(&frame->operandStack[frame->sp]);
+}
+
+static inline void pd4j_thread_push_double(pd4j_thread_frame *frame, double value) {
+	pd4j_thread_slots_set_double(&frame->operandStack[frame->sp], value);
+	frame->sp += 2;
+}
+
+static inline double pd4j_thread_pop_double(pd4j_thread_frame *frame) {
+	frame->sp -= 2;
+	return pd4j_thread_slots_get_double(&frame->operandStack[frame->sp]);
+}
+
+static inline void pd4j_thread_push_entry(pd4j_thread_frame *frame, pd4j_thread_stack_entry *entry) {
+	frame->sp += pd4j_thread_entry_to_slots(entry, &frame->operandStack[frame->sp]);
+}
+
+static inline void pd4j_thread_pop_entry(pd4j_thread_frame *frame, pd4j_thread_variable_tag tag, pd4j_thread_stack_entry *entry) {
+	frame->sp -= pd4j_thread_tag_slots(tag);
+	pd4j_thread_slots_to_entry(&frame->operandStack[frame->sp], tag, entry);
+}
+
+// copies the top count slots and inserts them depth slots further down, as the dup instructions do
+static inline void pd4j_thread_dup_insert(pd4j_thread_frame *frame, uint16_t count, uint16_t depth) {
+	pd4j_thread_variable *bottom = &frame->operandStack[frame->sp - count - depth];
+	
+	memmove(bottom + count, bottom, (count + depth) * sizeof(pd4j_thread_variable));
+	memcpy(bottom, bottom + count + depth, count * sizeof(pd4j_thread_variable));
+	frame->sp += count;
+}
+
+// reads the 16-bit offset of a branch instruction and takes it if the condition holds
+static inline bool pd4j_thread_branch(pd4j_thread *thread, bool condition) {
+	if (condition) {
+		int16_t offset = (int16_t)((thread->pc[0] << 8) | thread->pc[1]);
+		thread->pc += offset - 1;
+		
+		if (offset <= 0) {
+			thread->safepoint = true;
+		}
+	}
+	else {
+		thread->pc += 2;
+	}
+	
+	return true;
+}
+
+// jumps to a switch target, relative to the switch instruction at prevPc
+static inline void pd4j_thread_switch_to(pd4j_thread *thread, uint8_t *prevPc, int32_t offset) {
+	thread->pc = prevPc + offset;
 	
-	pd4j_list_push(thread->argStack, valueCopy);
+	if (offset <= 0) {
+		thread->safepoint = true;
+	}
 }
 
-pd4j_thread_stack_entry *pd4j_thread_arg_pop(pd4j_thread *thread) {
-	if (thread->argStack->size == 0) {
+// the ID a thread's lock words and monitors are owned under
+static inline uint32_t pd4j_thread_lock_owner(pd4j_thread *thread) {
+	return thread->threadId + 1;
+}
+
+// swaps the object's thin lock for a monitor in the same state
+static pd4j_thread_monitor *pd4j_thread_monitor_inflate(pd4j_thread *thread, pd4j_thread_reference *object) {
+	uintptr_t lockWord = object->lockWord;
+	
+	if ((lockWord & PD4J_THREAD_LOCK_INFLATED) != 0) {
+		return (pd4j_thread_monitor *)(lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_INFLATED);
+	}
+	
+	pd4j_thread_monitor *monitor = pd4j_malloc(sizeof(pd4j_thread_monitor));
+	if (monitor == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate monitor: Out of memory");
 		return NULL;
 	}
 	
-	return pd4j_list_pop(thread->argStack);
+	monitor->owner = (uint32_t)(lockWord >> PD4J_THREAD_LOCK_OWNER_SHIFT);
+	monitor->entryCount = (lockWord == 0) ? 0 : (uint32_t)((lockWord & PD4J_THREAD_LOCK_RECURSION_MASK) / PD4J_THREAD_LOCK_RECURSION_UNIT) + 1;
+	monitor->entryHead = NULL;
+	monitor->entryTail = NULL;
+	monitor->waitHead = NULL;
+	monitor->waitTail = NULL;
+	
+	object->lockWord = (uintptr_t)monitor | PD4J_THREAD_LOCK_INFLATED;
+	return monitor;
 }
 
-// todo
-bool pd4j_thread_invoke_static_method(pd4j_thread *thread, pd4j_thread_reference *methodRef) {
-	return false;
+static void pd4j_thread_monitor_queue(pd4j_thread **head, pd4j_thread **tail, pd4j_thread *thread) {
+	thread->nextWaiter = NULL;
+	
+	if (*tail == NULL) {
+		*head = thread;
+	}
+	else {
+		(*tail)->nextWaiter = thread;
+	}
+	
+	*tail = thread;
 }
 
-// todo
-bool pd4j_thread_invoke_instance_method(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef) {
-	return false;
+// queues the thread to be handed the monitor, holding it lockCount times once it is
+static void pd4j_thread_monitor_block(pd4j_thread *thread, pd4j_thread_monitor *monitor, uint32_t lockCount) {
+	pd4j_thread_monitor_queue(&monitor->entryHead, &monitor->entryTail, thread);
+	
+	thread->blockedOn = monitor;
+	thread->lockCount = lockCount;
 }
 
-// todo
-bool pd4j_thread_execute(pd4j_thread *thread) {
-	pd4j_thread_frame *frame = thread->jvmStack->array[thread->jvmStack->size - 1];
+// hands the monitor straight to the thread that has waited longest to enter, so it doesn't have to try again when it's resumed
+static void pd4j_thread_monitor_release(pd4j_thread_monitor *monitor) {
+	pd4j_thread *next = monitor->entryHead;
 	
-	uint8_t opcode = *(thread->pc++);
+	if (next == NULL) {
+		monitor->owner = 0;
+		monitor->entryCount = 0;
+		return;
+	}
 	
-	switch (opcode) {
-		case 0x10: {
-			// bipush
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_INT;
-			top->name = NULL;
-			top->data.intValue = (int32_t)((int8_t)(*(thread->pc++)));
+	monitor->entryHead = next->nextWaiter;
+	if (monitor->entryHead == NULL) {
+		monitor->entryTail = NULL;
+	}
+	
+	monitor->owner = pd4j_thread_lock_owner(next);
+	monitor->entryCount = next->lockCount;
+	
+	next->nextWaiter = NULL;
+	next->blockedOn = NULL;
+	pd4j_scheduler_resume(next);
+}
+
+// the monitor of an object the thread holds, inflating its lock word if needed, or NULL if it threw
+static pd4j_thread_monitor *pd4j_thread_monitor_owned(pd4j_thread *thread, pd4j_thread_reference *object) {
+	uintptr_t lockWord = object->lockWord;
+	uint32_t owner;
+	
+	if ((lockWord & PD4J_THREAD_LOCK_INFLATED) == 0) {
+		owner = (uint32_t)(lockWord >> PD4J_THREAD_LOCK_OWNER_SHIFT);
+	}
+	else {
+		owner = ((pd4j_thread_monitor *)(lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_INFLATED))->owner;
+	}
+	
+	if (owner == 0 || owner != pd4j_thread_lock_owner(thread)) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ILLEGAL_MONITOR_STATE, "Current thread doesn't own the monitor", 0, 0);
+		return NULL;
+	}
+	
+	return pd4j_thread_monitor_inflate(thread, object);
+}
+
+// returns false only if it threw; a thread that has to wait is suspended, and owns the lock by the time it runs again
+static bool pd4j_thread_monitor_enter(pd4j_thread *thread, pd4j_thread_reference *object) {
+	uintptr_t lockWord = object->lockWord;
+	uint32_t owner = pd4j_thread_lock_owner(thread);
+	uintptr_t thinLock = (uintptr_t)owner << PD4J_THREAD_LOCK_OWNER_SHIFT;
+	
+	// IDs too big for a thin lock go straight to a monitor
+	if ((thinLock >> PD4J_THREAD_LOCK_OWNER_SHIFT) == owner) {
+		if (lockWord == 0) {
+			object->lockWord = thinLock;
 			return true;
 		}
-		case 0x11: {
-			// sipush
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			top->tag = pd4j_VARIABLE_INT;
-			top->name = NULL;
-			top->data.intValue = (int32_t)((int16_t)temp);
+		else if ((lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_RECURSION_MASK) == thinLock && (lockWord & PD4J_THREAD_LOCK_RECURSION_MASK) != PD4J_THREAD_LOCK_RECURSION_MASK) {
+			object->lockWord = lockWord + PD4J_THREAD_LOCK_RECURSION_UNIT;
 			return true;
 		}
-		case 0x12: {
-			// ldc
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *constant = &currentClass->data.class.constantPool[temp];
-			
-			if (constant->tag == pd4j_VARIABLE_NONE) {
-				pd4j_class_constant *staticConstant = &currentClass->data.class.loaded->data.class->constantPool[temp];
-				
-				switch (staticConstant->tag) {
-					case pd4j_CONSTANT_INT: {
-						constant->tag = pd4j_VARIABLE_INT;
-						constant->name = NULL;
-						constant->data.intValue = staticConstant->data.intValue;
-						break;
-					}
-					case pd4j_CONSTANT_FLOAT: {
-						constant->tag = pd4j_VARIABLE_FLOAT;
-						constant->name = NULL;
-						constant->data.floatValue = staticConstant->data.floatValue;
-						break;
-					}
-					case pd4j_CONSTANT_CLASS: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_class_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_STRING: {
-						uint8_t *stringData;
-						if (!pd4j_class_constant_utf8(currentClass->data.class.loaded->data.class, temp, &stringData)) {
-							return false;
-						}
-						constant->tag = pd4j_VARIABLE_REFERENCE;
-						constant->data.referenceValue = pd4j_class_get_resolved_string_reference(currentClass->data.class.loaded, thread, stringData);
-						break;
-					}
-					case pd4j_CONSTANT_METHODHANDLE: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_method_handle_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_METHODTYPE: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_method_type_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_DYNAMIC: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_dynamic_reference(&entry, thread, staticConstant, currentClass)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					default: {
-						return false;
-					}
+	}
+	
+	pd4j_thread_monitor *monitor = pd4j_thread_monitor_inflate(thread, object);
+	if (monitor == NULL) {
+		return false;
+	}
+	
+	if (monitor->owner == 0) {
+		monitor->owner = owner;
+		monitor->entryCount = 1;
+	}
+	else if (monitor->owner == owner) {
+		monitor->entryCount++;
+	}
+	else {
+		pd4j_thread_monitor_block(thread, monitor, 1);
+		pd4j_scheduler_suspend(thread);
+	}
+	
+	return true;
+}
+
+static bool pd4j_thread_monitor_exit(pd4j_thread *thread, pd4j_thread_reference *object) {
+	uintptr_t lockWord = object->lockWord;
+	uint32_t owner = pd4j_thread_lock_owner(thread);
+	
+	if ((lockWord & PD4J_THREAD_LOCK_INFLATED) == 0) {
+		if (lockWord == 0 || (uint32_t)(lockWord >> PD4J_THREAD_LOCK_OWNER_SHIFT) != owner) {
+			pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ILLEGAL_MONITOR_STATE, "Current thread doesn't own the lock it's releasing", 0, 0);
+			return false;
+		}
+		
+		object->lockWord = ((lockWord & PD4J_THREAD_LOCK_RECURSION_MASK) != 0) ? lockWord - PD4J_THREAD_LOCK_RECURSION_UNIT : 0;
+		return true;
+	}
+	
+	pd4j_thread_monitor *monitor = (pd4j_thread_monitor *)(lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_INFLATED);
+	
+	if (monitor->owner != owner) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ILLEGAL_MONITOR_STATE, "Current thread doesn't own the lock it's releasing", 0, 0);
+		return false;
+	}
+	
+	if (--monitor->entryCount == 0) {
+		pd4j_thread_monitor_release(monitor);
+	}
+	
+	return true;
+}
+
+// called when a waiting thread runs again without being notified, because its wait timed out or it was woken spuriously
+static void pd4j_thread_monitor_wait_end(pd4j_thread *thread) {
+	pd4j_thread_monitor *monitor = thread->waitingOn;
+	pd4j_thread *prev = NULL;
+	
+	for (pd4j_thread *current = monitor->waitHead; current != NULL; prev = current, current = current->nextWaiter) {
+		if (current != thread) {
+			continue;
+		}
+		
+		if (prev == NULL) {
+			monitor->waitHead = thread->nextWaiter;
+		}
+		else {
+			prev->nextWaiter = thread->nextWaiter;
+		}
+		
+		if (monitor->waitTail == thread) {
+			monitor->waitTail = prev;
+		}
+		
+		break;
+	}
+	
+	thread->waitingOn = NULL;
+	
+	if (monitor->owner == 0) {
+		monitor->owner = pd4j_thread_lock_owner(thread);
+		monitor->entryCount = thread->lockCount;
+	}
+	else {
+		pd4j_thread_monitor_block(thread, monitor, thread->lockCount);
+	}
+}
+
+bool pd4j_thread_monitor_wait(pd4j_thread *thread, pd4j_thread_reference *object, uint32_t millis) {
+	pd4j_thread_monitor *monitor = pd4j_thread_monitor_owned(thread, object);
+	if (monitor == NULL) {
+		return false;
+	}
+	
+	pd4j_thread_monitor_queue(&monitor->waitHead, &monitor->waitTail, thread);
+	
+	// however many times the thread entered the monitor, it gives it up completely until it's notified
+	thread->waitingOn = monitor;
+	thread->lockCount = monitor->entryCount;
+	pd4j_thread_monitor_release(monitor);
+	
+	pd4j_scheduler_wait(thread, millis);
+	return true;
+}
+
+// notified threads wait to enter the monitor again, rather than all running just to find it taken
+static void pd4j_thread_monitor_wake_waiters(pd4j_thread_monitor *monitor, bool all) {
+	while (monitor->waitHead != NULL) {
+		pd4j_thread *waiter = monitor->waitHead;
+		
+		monitor->waitHead = waiter->nextWaiter;
+		if (monitor->waitHead == NULL) {
+			monitor->waitTail = NULL;
+		}
+		
+		waiter->waitingOn = NULL;
+		pd4j_thread_monitor_block(waiter, monitor, waiter->lockCount);
+		pd4j_scheduler_notify(waiter);
+		
+		if (!all) {
+			break;
+		}
+	}
+}
+
+bool pd4j_thread_monitor_notify(pd4j_thread *thread, pd4j_thread_reference *object, bool all) {
+	pd4j_thread_monitor *monitor = pd4j_thread_monitor_owned(thread, object);
+	if (monitor == NULL) {
+		return false;
+	}
+	
+	pd4j_thread_monitor_wake_waiters(monitor, all);
+	return true;
+}
+
+void pd4j_thread_monitor_notify_exited(pd4j_thread_reference *object) {
+	// waiting inflates the lock, so a thin one has no waiters
+	if ((object->lockWord & PD4J_THREAD_LOCK_INFLATED) == 0) {
+		return;
+	}
+	
+	pd4j_thread_monitor *monitor = (pd4j_thread_monitor *)(object->lockWord & ~(uintptr_t)PD4J_THREAD_LOCK_INFLATED);
+	pd4j_thread_monitor_wake_waiters(monitor, true);
+	
+	// with no owner to hand the monitor over when it exits, the first of them is handed it here
+	if (monitor->owner == 0) {
+		pd4j_thread_monitor_release(monitor);
+	}
+}
+
+// calls the function bound to a native method straight away, without a frame
+// it gets the arguments where the caller's operand stack already has them, and its return value goes back where they were
+// natives take the monitor themselves if they need it, since the call can't be suspended until the monitor is free
+static bool pd4j_thread_invoke_native(pd4j_thread *thread, pd4j_link_method *link, pd4j_thread_reference *instance, bool internal) {
+	if (link->nativeFunction == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/UnsatisfiedLinkError", "Invoked native method has no implementation");
+		return false;
+	}
+	
+	pd4j_thread_stack_entry result;
+	result.tag = pd4j_VARIABLE_NONE;
+	result.name = NULL;
+	result.data.longValue = 0;
+	
+	if (internal) {
+		uint16_t numArgs = link->signature.numArgs;
+		
+		if (thread->numArgs < numArgs) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/InternalError", "Too few arguments passed to internal method call");
+			return false;
+		}
+		
+		// laid out in slots like the interpreter would have left them
+		pd4j_thread_variable args[PD4J_THREAD_MAX_ARGS];
+		uint16_t slot = 0;
+		
+		if ((link->method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0) {
+			pd4j_thread_slot_set_tag(&args[0], pd4j_VARIABLE_REFERENCE, NULL);
+			args[slot++].data.referenceValue = instance;
+		}
+		
+		thread->numArgs -= numArgs;
+		
+		for (uint16_t i = 0; i < numArgs; i++) {
+			slot += pd4j_thread_entry_to_slots(&thread->argStack[thread->numArgs + i], &args[slot]);
+		}
+		
+		if (!link->nativeFunction(thread, args, &result)) {
+			return false;
+		}
+		
+		if (link->signature.returnKind != pd4j_LINK_RETURN_VOID) {
+			pd4j_thread_arg_push(thread, &result);
+		}
+		return thread->throwable == NULL;
+	}
+	
+	// the native may push or take frames off the thread, like when it yields, so the caller is kept to return to
+	pd4j_thread_frame *caller = thread->frame;
+	uint16_t numArgSlots = link->signature.numArgSlots;
+	
+	if (!link->nativeFunction(thread, &caller->operandStack[caller->sp - numArgSlots], &result)) {
+		return false;
+	}
+	
+	caller->sp -= numArgSlots;
+	
+	if (link->signature.returnKind != pd4j_LINK_RETURN_VOID) {
+		pd4j_thread_push_entry(caller, &result);
+	}
+	return true;
+}
+
+// the arguments come from the argStack for internal calls and from the operand stack of the calling frame otherwise
+static bool pd4j_thread_frame_push(pd4j_thread *thread, pd4j_link_method *link, pd4j_thread_reference *instance, bool internal) {
+	pd4j_class_property *method = link->method;
+	
+	if ((method->accessFlags.method & pd4j_METHOD_ACC_ABSTRACT) != 0) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/AbstractMethodError", "Invoked method is abstract");
+		return false;
+	}
+	else if ((method->accessFlags.method & pd4j_METHOD_ACC_NATIVE) != 0) {
+		return pd4j_thread_invoke_native(thread, link, instance, internal);
+	}
+	
+	pd4j_thread_frame *callingFrame = thread->frame;
+	uint16_t numArgs = link->signature.numArgs;
+	
+	if (internal && thread->numArgs < numArgs) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/InternalError", "Too few arguments passed to internal method call");
+		return false;
+	}
+	
+	// calls from the interpreter leave the arguments where they are, and the new frame's locals start on them
+	pd4j_thread_variable *args = internal ? NULL : &callingFrame->operandStack[callingFrame->sp - link->signature.numArgSlots];
+	
+	pd4j_thread_frame *frame = pd4j_thread_frame_alloc(thread, args, link->signature.numArgSlots, link->codeAttribute->parsedData.code.maxLocals, link->codeAttribute->parsedData.code.maxStack);
+	if (frame == NULL) {
+		return false;
+	}
+	
+	frame->startPc = link->code;
+	frame->currentMethod = link->methodRef;
+	frame->link = link;
+	frame->returnPc = thread->pc;
+	frame->wasInternalCall = internal;
+	
+	if (internal) {
+		uint16_t slot = 0;
+		
+		if ((method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0) {
+			pd4j_thread_slot_set_tag(&frame->locals[0], pd4j_VARIABLE_REFERENCE, NULL);
+			frame->locals[0].data.referenceValue = instance;
+			slot++;
+		}
+		
+		thread->numArgs -= numArgs;
+		
+		for (uint16_t i = 0; i < numArgs; i++) {
+			slot += pd4j_thread_entry_to_slots(&thread->argStack[thread->numArgs + i], &frame->locals[slot]);
+		}
+	}
+	else {
+		callingFrame->sp -= link->signature.numArgSlots;
+	}
+	
+	thread->frame = frame;
+	thread->depth++;
+	thread->pc = link->code;
+	thread->safepoint = true;
+	
+	if (link->signature.isSynchronized) {
+		// static methods lock their class
+		pd4j_thread_reference *lockedObject = ((method->accessFlags.method & pd4j_METHOD_ACC_STATIC) != 0) ? link->methodRef->data.method.class : frame->locals[0].data.referenceValue;
+		
+		if (!pd4j_thread_monitor_enter(thread, lockedObject)) {
+			return false;
+		}
+		
+		frame->lockedObject = lockedObject;
+	}
+	
+	return true;
+}
+
+// resolves the field reference at the given constant pool index of classRef and finds that field in the instance
+static pd4j_thread_stack_entry *pd4j_thread_instance_field(pd4j_thread *thread, pd4j_class_reference *classRef, uint16_t idx, pd4j_thread_reference *instance) {
+	pd4j_thread_stack_entry *fieldRef;
+	
+	if (!pd4j_resolve_field_reference(&fieldRef, thread, &classRef->data.class->constantPool[idx - 1], classRef)) {
+		return NULL;
+	}
+	
+	if (instance->kind == pd4j_REF_NULL) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot access field because instance is null", 0, 0);
+		return NULL;
+	}
+	
+	uint8_t *fieldName = fieldRef->data.referenceValue->data.field.name;
+	
+	for (uint16_t i = 0; i < instance->data.instance.numInstanceFields; i++) {
+		if (strcmp((char *)fieldName, (char *)(instance->data.instance.instanceFields[i].name)) == 0) {
+			return &instance->data.instance.instanceFields[i];
+		}
+	}
+	
+	pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Non-static field reference points to static field");
+	return NULL;
+}
+
+// the field a getter or setter accesses, taken straight from the slot found when it was linked if the instance is of the class itself
+static pd4j_thread_stack_entry *pd4j_thread_shape_field(pd4j_thread *thread, pd4j_link_method *target, pd4j_thread_reference *instance) {
+	if (instance->kind == pd4j_REF_INSTANCE && instance->data.instance.class->data.class.loaded == target->class) {
+		return &instance->data.instance.instanceFields[target->shapeSlot];
+	}
+	
+	return pd4j_thread_instance_field(thread, target->class, target->shapeOperand, instance);
+}
+
+// invokes a statically known target, running methods with a trivial body at the call site instead of pushing a frame for them
+static bool pd4j_thread_invoke_direct(pd4j_thread *thread, pd4j_thread_frame *frame, pd4j_link_method *target) {
+	switch (target->shape) {
+		case pd4j_LINK_SHAPE_EMPTY: {
+			frame->sp -= target->signature.numArgSlots;
+			return true;
+		}
+		case pd4j_LINK_SHAPE_CONSTANT: {
+			frame->sp -= target->signature.numArgSlots;
+			pd4j_thread_push_int(frame, target->shapeConstant);
+			return true;
+		}
+		case pd4j_LINK_SHAPE_GETTER: {
+			pd4j_thread_stack_entry *field = pd4j_thread_shape_field(thread, target, frame->operandStack[frame->sp - 1].data.referenceValue);
+			if (field == NULL) {
+				return false;
+			}
+			
+			frame->sp--;
+			pd4j_thread_push_entry(frame, field);
+			return true;
+		}
+		case pd4j_LINK_SHAPE_SETTER: {
+			frame->sp -= target->signature.numArgSlots;
+			
+			pd4j_thread_stack_entry *field = pd4j_thread_shape_field(thread, target, frame->operandStack[frame->sp].data.referenceValue);
+			if (field == NULL) {
+				return false;
+			}
+			
+			pd4j_thread_stack_entry value;
+			pd4j_thread_slots_to_entry(&frame->operandStack[frame->sp + 1], pd4j_thread_field_tag(target->class, target->shapeOperand), &value);
+			
+			field->tag = value.tag;
+			field->data = value.data;
+			return true;
+		}
+		case pd4j_LINK_SHAPE_SUPER_INIT: {
+			// the constructor becomes empty once the one it calls is known to be empty
+			pd4j_link_call_site *site = &target->callSites[0];
+			
+			if (site->state == pd4j_CALL_SITE_BOUND && site->entries[0].target->shape == pd4j_LINK_SHAPE_EMPTY) {
+				target->shape = pd4j_LINK_SHAPE_EMPTY;
+				frame->sp -= target->signature.numArgSlots;
+				return true;
+			}
+			break;
+		}
+		default:
+			break;
+	}
+	
+	return pd4j_thread_frame_push(thread, target, NULL, false);
+}
+
+bool pd4j_thread_invoke_static_method(pd4j_thread *thread, pd4j_thread_reference *methodRef) {
+	pd4j_link_method *link = pd4j_link_method_from_reference(thread, methodRef);
+	
+	if (link == NULL || !pd4j_thread_frame_push(thread, link, NULL, true)) {
+		return false;
+	}
+	
+	// a native method has already run, without a frame to execute
+	if ((link->method->accessFlags.method & pd4j_METHOD_ACC_NATIVE) == 0) {
+		while (pd4j_thread_execute(thread));
+	}
+	
+	return thread->throwable == NULL;
+}
+
+bool pd4j_thread_invoke_instance_method(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef) {
+	if (instance == NULL || instance->kind == pd4j_REF_NULL) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot invoke method because instance is null", 0, 0);
+		return false;
+	}
+	
+	pd4j_link_method *link = pd4j_link_method_from_reference(thread, methodRef);
+	
+	if (link == NULL || !pd4j_thread_frame_push(thread, link, instance, true)) {
+		return false;
+	}
+	
+	if ((link->method->accessFlags.method & pd4j_METHOD_ACC_NATIVE) == 0) {
+		while (pd4j_thread_execute(thread));
+	}
+	
+	return thread->throwable == NULL;
+}
+
+bool pd4j_thread_start_method(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef) {
+	pd4j_link_method *link = pd4j_link_method_from_reference(thread, methodRef);
+	
+	if (link == NULL) {
+		return false;
+	}
+	
+	if ((link->method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0 && (instance == NULL || instance->kind == pd4j_REF_NULL)) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot invoke method because instance is null", 0, 0);
+		return false;
+	}
+	
+	if (!pd4j_thread_frame_push(thread, link, instance, true)) {
+		return false;
+	}
+	
+	// done before the method runs so the exceptions are there to throw even if it runs out of memory
+	if (!pd4j_thread_prepare_implicit_exceptions(thread)) {
+		thread->throwable = NULL;
+	}
+	
+	return true;
+}
+
+// resolves a loadable constant the first time it's used and caches it in the runtime constant pool
+static pd4j_thread_stack_entry *pd4j_thread_load_constant(pd4j_thread *thread, pd4j_thread_frame *frame, uint16_t idx) {
+	pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
+	pd4j_class_reference *classRef = currentClass->data.class.loaded;
+	pd4j_thread_stack_entry *constant = &currentClass->data.class.constantPool[idx - 1];
+	
+	if (constant->tag != pd4j_VARIABLE_NONE) {
+		return constant;
+	}
+	
+	pd4j_class_constant *staticConstant = &classRef->data.class->constantPool[idx - 1];
+	pd4j_thread_stack_entry *entry = NULL;
+	
+	switch (staticConstant->tag) {
+		case pd4j_CONSTANT_INT: {
+			constant->tag = pd4j_VARIABLE_INT;
+			constant->name = NULL;
+			constant->data.intValue = staticConstant->data.intValue;
+			return constant;
+		}
+		case pd4j_CONSTANT_FLOAT: {
+			constant->tag = pd4j_VARIABLE_FLOAT;
+			constant->name = NULL;
+			constant->data.floatValue = staticConstant->data.floatValue;
+			return constant;
+		}
+		case pd4j_CONSTANT_LONG: {
+			constant->tag = pd4j_VARIABLE_LONG;
+			constant->name = NULL;
+			pd4j_class_constant_long(classRef->data.class, idx, &constant->data.longValue);
+			return constant;
+		}
+		case pd4j_CONSTANT_DOUBLE: {
+			constant->tag = pd4j_VARIABLE_DOUBLE;
+			constant->name = NULL;
+			pd4j_class_constant_double(classRef->data.class, idx, &constant->data.doubleValue);
+			return constant;
+		}
+		case pd4j_CONSTANT_STRING: {
+			uint8_t *stringData;
+			if (!pd4j_class_constant_utf8(classRef->data.class, staticConstant->data.indices.a, &stringData)) {
+				return NULL;
+			}
+			constant->tag = pd4j_VARIABLE_REFERENCE;
+			constant->name = NULL;
+			constant->data.referenceValue = pd4j_class_get_resolved_string_reference(classRef, thread, stringData);
+			return constant;
+		}
+		case pd4j_CONSTANT_CLASS: {
+			if (!pd4j_resolve_class_reference(&entry, thread, staticConstant, classRef)) {
+				return NULL;
+			}
+			break;
+		}
+		case pd4j_CONSTANT_METHODHANDLE: {
+			if (!pd4j_resolve_method_handle_reference(&entry, thread, staticConstant, classRef)) {
+				return NULL;
+			}
+			break;
+		}
+		case pd4j_CONSTANT_METHODTYPE: {
+			if (!pd4j_resolve_method_type_reference(&entry, thread, staticConstant, classRef)) {
+				return NULL;
+			}
+			break;
+		}
+		case pd4j_CONSTANT_DYNAMIC: {
+			if (!pd4j_resolve_dynamic_reference(&entry, thread, staticConstant, currentClass)) {
+				return NULL;
+			}
+			break;
+		}
+		default: {
+			return NULL;
+		}
+	}
+	
+	memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
+	pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
+	return constant;
+}
+
+// finds an element of an array, throwing if the array is null or the index is out of range
+static pd4j_thread_stack_entry *pd4j_thread_array_element(pd4j_thread *thread, pd4j_thread_reference *array, int32_t index) {
+	if (array->kind == pd4j_REF_NULL) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Could not access array because it is null", 0, 0);
+		return NULL;
+	}
+	
+	if (index < 0 || (uint32_t)index >= array->data.instance.numInstanceFields) {
+		pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ARRAY_INDEX_OUT_OF_BOUNDS, "Index %d out of bounds for length %d", index, (int32_t)(array->data.instance.numInstanceFields));
+		return NULL;
+	}
+	
+	return &array->data.instance.instanceFields[index];
+}
+
+// pops the current frame and hands the return value (NULL for void methods) to the caller
+static bool pd4j_thread_return(pd4j_thread *thread, pd4j_thread_stack_entry *value) {
+	if (thread->frame->lockedObject != NULL && !pd4j_thread_monitor_exit(thread, thread->frame->lockedObject)) {
+		return false;
+	}
+	
+	bool internal = thread->frame->wasInternalCall;
+	
+	pd4j_thread_frame_pop(thread);
+	
+	if (internal) {
+		if (value != NULL) {
+			pd4j_thread_arg_push(thread, value);
+		}
+		return false;
+	}
+	
+	// the value goes where the arguments were, which the popped frame's locals no longer need
+	if (value != NULL) {
+		pd4j_thread_push_entry(thread->frame, value);
+	}
+	return true;
+}
+
+// returns the value in the top slots of the current frame's operand stack, copying them straight to the caller's unless the method is synchronized or was called from native code
+static inline bool pd4j_thread_return_slots(pd4j_thread *thread, pd4j_thread_frame *frame, pd4j_thread_variable_tag tag, uint16_t numSlots) {
+	frame->sp -= numSlots;
+	
+	if (frame->link->signature.isSynchronized || frame->wasInternalCall) {
+		pd4j_thread_stack_entry returnValue;
+		
+		pd4j_thread_slots_to_entry(&frame->operandStack[frame->sp], tag, &returnValue);
+		return pd4j_thread_return(thread, &returnValue);
+	}
+	
+	pd4j_thread_variable value[2];
+	memcpy(value, &frame->operandStack[frame->sp], numSlots * sizeof(pd4j_thread_variable));
+	
+	pd4j_thread_frame_pop(thread);
+	
+	pd4j_thread_frame *caller = thread->frame;
+	memcpy(&caller->operandStack[caller->sp], value, numSlots * sizeof(pd4j_thread_variable));
+	caller->sp += numSlots;
+	return true;
+}
+
+// operand stack of the current frame while a run of simple instructions executes, with the top value kept out of memory
+typedef struct {
+	pd4j_thread_variable *stack;
+	uint16_t sp;
+	
+	// when true, top is the value above stack[sp - 1]
+	bool cached;
+	pd4j_thread_variable top;
+} pd4j_thread_stack_cache;
+
+static inline void pd4j_thread_cache_push(pd4j_thread_stack_cache *cache, pd4j_thread_variable value) {
+	if (cache->cached) {
+		cache->stack[cache->sp++] = cache->top;
+	}
+	
+	cache->top = value;
+	cache->cached = true;
+}
+
+static inline pd4j_thread_variable pd4j_thread_cache_pop(pd4j_thread_stack_cache *cache) {
+	if (!cache->cached) {
+		return cache->stack[--cache->sp];
+	}
+	
+	cache->cached = false;
+	return cache->top;
+}
+
+static inline void pd4j_thread_cache_push_int(pd4j_thread_stack_cache *cache, int32_t value) {
+	pd4j_thread_variable slot;
+	
+	pd4j_thread_slot_set_tag(&slot, pd4j_VARIABLE_INT, NULL);
+	slot.data.intValue = value;
+	pd4j_thread_cache_push(cache, slot);
+}
+
+static inline void pd4j_thread_cache_push_float(pd4j_thread_stack_cache *cache, float value) {
+	pd4j_thread_variable slot;
+	
+	pd4j_thread_slot_set_tag(&slot, pd4j_VARIABLE_FLOAT, NULL);
+	slot.data.floatValue = value;
+	pd4j_thread_cache_push(cache, slot);
+}
+
+static inline int32_t pd4j_thread_cache_pop_int(pd4j_thread_stack_cache *cache) {
+	return pd4j_thread_cache_pop(cache).data.intValue;
+}
+
+static inline float pd4j_thread_cache_pop_float(pd4j_thread_stack_cache *cache) {
+	return pd4j_thread_cache_pop(cache).data.floatValue;
+}
+
+// longs and doubles go through memory, since they take both of their slots
+static inline void pd4j_thread_cache_flush(pd4j_thread_stack_cache *cache) {
+	if (cache->cached) {
+		cache->stack[cache->sp++] = cache->top;
+		cache->cached = false;
+	}
+}
+
+static inline void pd4j_thread_cache_push_long(pd4j_thread_stack_cache *cache, int64_t value) {
+	pd4j_thread_cache_flush(cache);
+	pd4j_thread_slots_set_long(&cache->stack[cache->sp], pd4j_VARIABLE_LONG, NULL, value);
+	cache->sp += 2;
+}
+
+static inline int64_t pd4j_thread_cache_pop_long(pd4j_thread_stack_cache *cache) {
+	pd4j_thread_cache_flush(cache);
+	cache->sp -= 2;
+	return pd4j_thread_slots_get_long(&cache->stack[cache->sp]);
+}
+
+static inline void pd4j_thread_cache_push_double(pd4j_thread_stack_cache *cache, double value) {
+	pd4j_thread_cache_flush(cache);
+	pd4j_thread_slots_set_double(&cache->stack[cache->sp], value);
+	cache->sp += 2;
+}
+
+static inline double pd4j_thread_cache_pop_double(pd4j_thread_stack_cache *cache) {
+	pd4j_thread_cache_flush(cache);
+	cache->sp -= 2;
+	return pd4j_thread_slots_get_double(&cache->stack[cache->sp]);
+}
+
+// the condition of if<cond> and if_icmp<cond>, numbered in opcode order
+static inline bool pd4j_thread_int_condition(uint8_t condition, int32_t value1, int32_t value2) {
+	switch (condition) {
+		case 0: return value1 == value2;
+		case 1: return value1 != value2;
+		case 2: return value1 < value2;
+		case 3: return value1 >= value2;
+		case 4: return value1 > value2;
+		default: return value1 <= value2;
+	}
+}
+
+// the opcodes pd4j_thread_execute_cached handles, so the full interpreter only enters it when there's something for it to run
+static const bool pd4j_thread_cached_opcodes[256] = {
+	[0x00] = true, [0x10] = true, [0x11] = true,
+	[0x15] = true, [0x16] = true, [0x17] = true, [0x18] = true, [0x19] = true,
+	[0x1a] = true, [0x1b] = true, [0x1c] = true, [0x1d] = true, [0x1e] = true, [0x1f] = true, [0x20] = true, [0x21] = true,
+	[0x22] = true, [0x23] = true, [0x24] = true, [0x25] = true, [0x26] = true, [0x27] = true, [0x28] = true, [0x29] = true,
+	[0x2a] = true, [0x2b] = true, [0x2c] = true, [0x2d] = true,
+	[0x36] = true, [0x37] = true, [0x38] = true, [0x39] = true, [0x3a] = true,
+	[0x3b] = true, [0x3c] = true, [0x3d] = true, [0x3e] = true, [0x3f] = true, [0x40] = true, [0x41] = true, [0x42] = true,
+	[0x43] = true, [0x44] = true, [0x45] = true, [0x46] = true, [0x47] = true, [0x48] = true, [0x49] = true, [0x4a] = true,
+	[0x4b] = true, [0x4c] = true, [0x4d] = true, [0x4e] = true,
+	[0x57] = true, [0x59] = true,
+	[0x60] = true, [0x61] = true, [0x62] = true, [0x63] = true, [0x64] = true, [0x65] = true, [0x66] = true, [0x67] = true,
+	[0x68] = true, [0x69] = true, [0x6a] = true, [0x6b] = true, [0x6e] = true, [0x6f] = true,
+	[0x74] = true, [0x75] = true, [0x77] = true, [0x78] = true, [0x79] = true, [0x7a] = true, [0x7b] = true, [0x7c] = true,
+	[0x7d] = true, [0x7e] = true, [0x7f] = true, [0x80] = true, [0x81] = true, [0x82] = true, [0x83] = true, [0x84] = true,
+	[0x85] = true, [0x87] = true, [0x88] = true, [0x8a] = true, [0x8d] = true, [0x90] = true, [0x91] = true, [0x92] = true,
+	[0x93] = true, [0x94] = true, [0x97] = true, [0x98] = true,
+	[0x99] = true, [0x9a] = true, [0x9b] = true, [0x9c] = true, [0x9d] = true, [0x9e] = true,
+	[0x9f] = true, [0xa0] = true, [0xa1] = true, [0xa2] = true, [0xa3] = true, [0xa4] = true, [0xa7] = true,
+	[pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE] = true,
+	[pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT] = true,
+	[pd4j_OPCODE_XALOAD_UNCHECKED] = true,
+	[pd4j_OPCODE_IASTORE_UNCHECKED] = true,
+	[pd4j_OPCODE_FASTORE_UNCHECKED] = true
+};
+
+// runs the arithmetic, load and store instructions that can't throw or leave the frame, keeping the top of the operand stack and the PC in registers
+// stops before the first instruction it doesn't handle (or after PD4J_THREAD_CACHED_RUN of them), writing both back for the full interpreter
+static void pd4j_thread_execute_cached(pd4j_thread *thread, pd4j_thread_frame *frame) {
+	pd4j_thread_stack_cache cache;
+	cache.stack = frame->operandStack;
+	cache.sp = frame->sp;
+	cache.cached = false;
+	
+	pd4j_thread_variable *locals = frame->locals;
+	uint8_t *pc = thread->pc;
+	bool running = true;
+	bool backwardBranch = false;
+	uint32_t i;
+	
+	for (i = 0; running && i < PD4J_THREAD_CACHED_RUN; i++) {
+		uint8_t opcode = *pc;
+#ifdef PD4J_PROFILE_OPCODES
+		uint8_t *start = pc;
+#endif
+		
+		switch (opcode) {
+			case 0x00: {
+				// nop
+				pc++;
+				break;
+			}
+			case 0x10: {
+				// bipush
+				pd4j_thread_cache_push_int(&cache, (int8_t)pc[1]);
+				pc += 2;
+				break;
+			}
+			case 0x11: {
+				// sipush
+				pd4j_thread_cache_push_int(&cache, (int16_t)((pc[1] << 8) | pc[2]));
+				pc += 3;
+				break;
+			}
+			case 0x15:
+			case 0x17:
+			case 0x19: {
+				// iload, fload, aload
+				pd4j_thread_cache_push(&cache, locals[pc[1]]);
+				pc += 2;
+				break;
+			}
+			case 0x1a:
+			case 0x1b:
+			case 0x1c:
+			case 0x1d: {
+				// iload_n
+				pd4j_thread_cache_push(&cache, locals[opcode - 0x1a]);
+				pc++;
+				break;
+			}
+			case 0x22:
+			case 0x23:
+			case 0x24:
+			case 0x25: {
+				// fload_n
+				pd4j_thread_cache_push(&cache, locals[opcode - 0x22]);
+				pc++;
+				break;
+			}
+			case 0x2a:
+			case 0x2b:
+			case 0x2c:
+			case 0x2d: {
+				// aload_n
+				pd4j_thread_cache_push(&cache, locals[opcode - 0x2a]);
+				pc++;
+				break;
+			}
+			case 0x36:
+			case 0x38:
+			case 0x3a: {
+				// istore, fstore, astore
+				locals[pc[1]] = pd4j_thread_cache_pop(&cache);
+				pc += 2;
+				break;
+			}
+			case 0x3b:
+			case 0x3c:
+			case 0x3d:
+			case 0x3e: {
+				// istore_n
+				locals[opcode - 0x3b] = pd4j_thread_cache_pop(&cache);
+				pc++;
+				break;
+			}
+			case 0x43:
+			case 0x44:
+			case 0x45:
+			case 0x46: {
+				// fstore_n
+				locals[opcode - 0x43] = pd4j_thread_cache_pop(&cache);
+				pc++;
+				break;
+			}
+			case 0x4b:
+			case 0x4c:
+			case 0x4d:
+			case 0x4e: {
+				// astore_n
+				locals[opcode - 0x4b] = pd4j_thread_cache_pop(&cache);
+				pc++;
+				break;
+			}
+			case 0x57: {
+				// pop
+				pd4j_thread_cache_pop(&cache);
+				pc++;
+				break;
+			}
+			case 0x59: {
+				// dup
+				pd4j_thread_variable value = pd4j_thread_cache_pop(&cache);
+				
+				pd4j_thread_cache_push(&cache, value);
+				pd4j_thread_cache_push(&cache, value);
+				pc++;
+				break;
+			}
+			case 0x60:
+			case 0x64:
+			case 0x68:
+			case 0x78:
+			case 0x7a:
+			case 0x7c:
+			case 0x7e:
+			case 0x80:
+			case 0x82: {
+				// iadd, isub, imul, ishl, ishr, iushr, iand, ior, ixor
+				int32_t value2 = pd4j_thread_cache_pop_int(&cache);
+				int32_t value1 = pd4j_thread_cache_pop_int(&cache);
+				int32_t result;
+				
+				switch (opcode) {
+					case 0x60: result = (int32_t)((uint32_t)value1 + (uint32_t)value2); break;
+					case 0x64: result = (int32_t)((uint32_t)value1 - (uint32_t)value2); break;
+					case 0x68: result = (int32_t)((uint32_t)value1 * (uint32_t)value2); break;
+					case 0x78: result = (int32_t)((uint32_t)value1 << (value2 & 0x1f)); break;
+					case 0x7a: result = value1 >> (value2 & 0x1f); break;
+					case 0x7c: result = (int32_t)((uint32_t)value1 >> (value2 & 0x1f)); break;
+					case 0x7e: result = value1 & value2; break;
+					case 0x80: result = value1 | value2; break;
+					default: result = value1 ^ value2; break;
+				}
+				
+				pd4j_thread_cache_push_int(&cache, result);
+				pc++;
+				break;
+			}
+			case 0x62:
+			case 0x66:
+			case 0x6a:
+			case 0x6e: {
+				// fadd, fsub, fmul, fdiv
+				float value2 = pd4j_thread_cache_pop_float(&cache);
+				float value1 = pd4j_thread_cache_pop_float(&cache);
+				float result;
+				
+				switch (opcode) {
+					case 0x62: result = value1 + value2; break;
+					case 0x66: result = value1 - value2; break;
+					case 0x6a: result = value1 * value2; break;
+					default: result = value1 / value2; break;
+				}
+				
+				pd4j_thread_cache_push_float(&cache, result);
+				pc++;
+				break;
+			}
+			case 0x74: {
+				// ineg
+				pd4j_thread_cache_push_int(&cache, (int32_t)(0u - (uint32_t)pd4j_thread_cache_pop_int(&cache)));
+				pc++;
+				break;
+			}
+			case 0x16:
+			case 0x18: {
+				// lload, dload
+				pd4j_thread_cache_push(&cache, locals[pc[1]]);
+				pd4j_thread_cache_push(&cache, locals[pc[1] + 1]);
+				pc += 2;
+				break;
+			}
+			case 0x1e:
+			case 0x1f:
+			case 0x20:
+			case 0x21:
+			case 0x26:
+			case 0x27:
+			case 0x28:
+			case 0x29: {
+				// lload_n, dload_n
+				uint8_t idx = (opcode - 0x1e) & 0x3;
+				
+				pd4j_thread_cache_push(&cache, locals[idx]);
+				pd4j_thread_cache_push(&cache, locals[idx + 1]);
+				pc++;
+				break;
+			}
+			case 0x37:
+			case 0x39: {
+				// lstore, dstore
+				locals[pc[1] + 1] = pd4j_thread_cache_pop(&cache);
+				locals[pc[1]] = pd4j_thread_cache_pop(&cache);
+				pc += 2;
+				break;
+			}
+			case 0x3f:
+			case 0x40:
+			case 0x41:
+			case 0x42:
+			case 0x47:
+			case 0x48:
+			case 0x49:
+			case 0x4a: {
+				// lstore_n, dstore_n
+				uint8_t idx = (opcode - 0x3f) & 0x3;
+				
+				locals[idx + 1] = pd4j_thread_cache_pop(&cache);
+				locals[idx] = pd4j_thread_cache_pop(&cache);
+				pc++;
+				break;
+			}
+			case 0x61:
+			case 0x65:
+			case 0x69:
+			case 0x7f:
+			case 0x81:
+			case 0x83: {
+				// ladd, lsub, lmul, land, lor, lxor
+				uint64_t value2 = (uint64_t)pd4j_thread_cache_pop_long(&cache);
+				uint64_t value1 = (uint64_t)pd4j_thread_cache_pop_long(&cache);
+				uint64_t result;
+				
+				switch (opcode) {
+					case 0x61: result = value1 + value2; break;
+					case 0x65: result = value1 - value2; break;
+					case 0x69: result = value1 * value2; break;
+					case 0x7f: result = value1 & value2; break;
+					case 0x81: result = value1 | value2; break;
+					default: result = value1 ^ value2; break;
+				}
+				
+				pd4j_thread_cache_push_long(&cache, (int64_t)result);
+				pc++;
+				break;
+			}
+			case 0x79:
+			case 0x7b:
+			case 0x7d: {
+				// lshl, lshr, lushr
+				int32_t shift = pd4j_thread_cache_pop_int(&cache) & 0x3f;
+				int64_t value = pd4j_thread_cache_pop_long(&cache);
+				
+				if (opcode == 0x79) {
+					value = (int64_t)((uint64_t)value << shift);
+				}
+				else if (opcode == 0x7b) {
+					value >>= shift;
+				}
+				else {
+					value = (int64_t)((uint64_t)value >> shift);
+				}
+				
+				pd4j_thread_cache_push_long(&cache, value);
+				pc++;
+				break;
+			}
+			case 0x63:
+			case 0x67:
+			case 0x6b:
+			case 0x6f: {
+				// dadd, dsub, dmul, ddiv
+				double value2 = pd4j_thread_cache_pop_double(&cache);
+				double value1 = pd4j_thread_cache_pop_double(&cache);
+				double result;
+				
+				switch (opcode) {
+					case 0x63: result = value1 + value2; break;
+					case 0x67: result = value1 - value2; break;
+					case 0x6b: result = value1 * value2; break;
+					default: result = value1 / value2; break;
+				}
+				
+				pd4j_thread_cache_push_double(&cache, result);
+				pc++;
+				break;
+			}
+			case 0x75: {
+				// lneg
+				pd4j_thread_cache_push_long(&cache, (int64_t)(0 - (uint64_t)pd4j_thread_cache_pop_long(&cache)));
+				pc++;
+				break;
+			}
+			case 0x77: {
+				// dneg
+				pd4j_thread_cache_push_double(&cache, -pd4j_thread_cache_pop_double(&cache));
+				pc++;
+				break;
+			}
+			case 0x84: {
+				// iinc
+				locals[pc[1]].data.intValue += (int8_t)pc[2];
+				pc += 3;
+				break;
+			}
+			case 0x85: {
+				// i2l
+				pd4j_thread_cache_push_long(&cache, pd4j_thread_cache_pop_int(&cache));
+				pc++;
+				break;
+			}
+			case 0x87: {
+				// i2d
+				pd4j_thread_cache_push_double(&cache, pd4j_thread_cache_pop_int(&cache));
+				pc++;
+				break;
+			}
+			case 0x88: {
+				// l2i
+				pd4j_thread_cache_push_int(&cache, (int32_t)pd4j_thread_cache_pop_long(&cache));
+				pc++;
+				break;
+			}
+			case 0x8a: {
+				// l2d
+				pd4j_thread_cache_push_double(&cache, (double)pd4j_thread_cache_pop_long(&cache));
+				pc++;
+				break;
+			}
+			case 0x8d: {
+				// f2d
+				pd4j_thread_cache_push_double(&cache, pd4j_thread_cache_pop_float(&cache));
+				pc++;
+				break;
+			}
+			case 0x90: {
+				// d2f
+				pd4j_thread_cache_push_float(&cache, (float)pd4j_thread_cache_pop_double(&cache));
+				pc++;
+				break;
+			}
+			case 0x91: {
+				// i2b
+				pd4j_thread_cache_push_int(&cache, (int8_t)(pd4j_thread_cache_pop_int(&cache) & 0xff));
+				pc++;
+				break;
+			}
+			case 0x92: {
+				// i2c
+				pd4j_thread_cache_push_int(&cache, pd4j_thread_cache_pop_int(&cache) & 0xffff);
+				pc++;
+				break;
+			}
+			case 0x93: {
+				// i2s
+				pd4j_thread_cache_push_int(&cache, (int16_t)(pd4j_thread_cache_pop_int(&cache) & 0xffff));
+				pc++;
+				break;
+			}
+			case 0x99:
+			case 0x9a:
+			case 0x9b:
+			case 0x9c:
+			case 0x9d:
+			case 0x9e: {
+				// if<cond>
+				bool condition = pd4j_thread_int_condition(opcode - 0x99, pd4j_thread_cache_pop_int(&cache), 0);
+				int16_t offset = condition ? (int16_t)((pc[1] << 8) | pc[2]) : 3;
+				
+				backwardBranch |= offset <= 0;
+				pc += offset;
+				break;
+			}
+			case 0x94: {
+				// lcmp
+				int64_t value2 = pd4j_thread_cache_pop_long(&cache);
+				int64_t value1 = pd4j_thread_cache_pop_long(&cache);
+				
+				pd4j_thread_cache_push_int(&cache, (value1 > value2) - (value1 < value2));
+				pc++;
+				break;
+			}
+			case 0x97:
+			case 0x98: {
+				// dcmpl, dcmpg
+				double value2 = pd4j_thread_cache_pop_double(&cache);
+				double value1 = pd4j_thread_cache_pop_double(&cache);
+				
+				if (isnan(value1) || isnan(value2)) {
+					pd4j_thread_cache_push_int(&cache, (opcode == 0x98) ? 1 : -1);
+				}
+				else {
+					pd4j_thread_cache_push_int(&cache, (value1 > value2) - (value1 < value2));
+				}
+				pc++;
+				break;
+			}
+			case 0x9f:
+			case 0xa0:
+			case 0xa1:
+			case 0xa2:
+			case 0xa3:
+			case 0xa4: {
+				// if_icmp<cond>
+				int32_t value2 = pd4j_thread_cache_pop_int(&cache);
+				int32_t value1 = pd4j_thread_cache_pop_int(&cache);
+				
+				int16_t offset = pd4j_thread_int_condition(opcode - 0x9f, value1, value2) ? (int16_t)((pc[1] << 8) | pc[2]) : 3;
+				
+				backwardBranch |= offset <= 0;
+				pc += offset;
+				break;
+			}
+			case 0xa7: {
+				// goto
+				int16_t offset = (int16_t)((pc[1] << 8) | pc[2]);
+				
+				backwardBranch |= offset <= 0;
+				pc += offset;
+				break;
+			}
+			case pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE: {
+				pd4j_thread_variable *result = &locals[pc[6]];
+				
+				pd4j_thread_slot_set_tag(result, pd4j_VARIABLE_INT, NULL);
+				result->data.intValue = (int32_t)((uint32_t)locals[pc[1]].data.intValue + (uint32_t)locals[pc[3]].data.intValue);
+				pc += 7;
+				break;
+			}
+			case pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT: {
+				int16_t offset = (locals[pc[1]].data.intValue < (int8_t)pc[3]) ? (int16_t)((pc[5] << 8) | pc[6]) : 3;
+				
+				backwardBranch |= offset <= 0;
+				pc += 4 + offset;
+				break;
+			}
+			case pd4j_OPCODE_XALOAD_UNCHECKED: {
+				int32_t index = pd4j_thread_cache_pop_int(&cache);
+				pd4j_thread_stack_entry *element = &pd4j_thread_cache_pop(&cache).data.referenceValue->data.instance.instanceFields[index];
+				pd4j_thread_variable slots[2];
+				uint16_t numSlots = pd4j_thread_entry_to_slots(element, slots);
+				
+				for (uint16_t j = 0; j < numSlots; j++) {
+					pd4j_thread_cache_push(&cache, slots[j]);
 				}
+				pc++;
+				break;
+			}
+			case pd4j_OPCODE_IASTORE_UNCHECKED:
+			case pd4j_OPCODE_FASTORE_UNCHECKED: {
+				pd4j_thread_variable value = pd4j_thread_cache_pop(&cache);
+				int32_t index = pd4j_thread_cache_pop_int(&cache);
+				pd4j_thread_stack_entry *element = &pd4j_thread_cache_pop(&cache).data.referenceValue->data.instance.instanceFields[index];
+				
+				element->tag = (opcode == pd4j_OPCODE_IASTORE_UNCHECKED) ? pd4j_VARIABLE_INT : pd4j_VARIABLE_FLOAT;
+				memcpy(&element->data, &value.data, sizeof(value.data));
+				pc++;
+				break;
+			}
+			default: {
+				running = false;
+				break;
 			}
+		}
+
+#ifdef PD4J_PROFILE_OPCODES
+		// instructions left for the full interpreter are counted there
+		if (running) {
+			pd4j_link_profile_instruction(start);
+		}
+#endif
+	}
+	
+	if (cache.cached) {
+		cache.stack[cache.sp++] = cache.top;
+	}
+	
+	frame->sp = cache.sp;
+	thread->pc = pc;
+	
+	// the instruction that stopped the run is counted by the full interpreter
+	thread->instructionCount += running ? i : i - 1;
+	if (backwardBranch) {
+		thread->safepoint = true;
+	}
+}
+
+pd4j_thread_continuation *pd4j_thread_continuation_new(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef) {
+	pd4j_link_method *link = pd4j_link_method_from_reference(thread, methodRef);
+	
+	if (link == NULL) {
+		return NULL;
+	}
+	
+	// a native method would run as soon as it's mounted, leaving no frames for the continuation to hold
+	if ((link->method->accessFlags.method & pd4j_METHOD_ACC_NATIVE) != 0) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalArgumentException", "Continuation can't run a native method");
+		return NULL;
+	}
+	
+	pd4j_thread_continuation *continuation = pd4j_malloc(sizeof(pd4j_thread_continuation));
+	if (continuation == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate continuation: Out of memory");
+		return NULL;
+	}
+	
+	continuation->firstSegment = pd4j_thread_stack_segment_new(NULL, PD4J_THREAD_CONTINUATION_SEGMENT_SIZE);
+	if (continuation->firstSegment == NULL) {
+		pd4j_free(continuation, sizeof(pd4j_thread_continuation));
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate continuation stack: Out of memory");
+		return NULL;
+	}
+	
+	continuation->state = pd4j_CONTINUATION_NEW;
+	continuation->entry = link;
+	continuation->instance = instance;
+	continuation->stackSegment = continuation->firstSegment;
+	continuation->bottom = NULL;
+	continuation->frame = NULL;
+	continuation->pc = NULL;
+	continuation->depth = 0;
+	continuation->callerSegment = NULL;
+	continuation->callerDepth = 0;
+	continuation->parent = NULL;
+	continuation->object = NULL;
+	
+	return continuation;
+}
+
+bool pd4j_thread_continuation_done(pd4j_thread_continuation *continuation) {
+	return continuation->state == pd4j_CONTINUATION_DONE;
+}
+
+void pd4j_thread_continuation_destroy(pd4j_thread_continuation *continuation) {
+	pd4j_thread_stack_segment *segment = continuation->firstSegment;
+	
+	while (segment != NULL) {
+		pd4j_thread_stack_segment *next = segment->next;
+		pd4j_free(segment, sizeof(pd4j_thread_stack_segment) + (size_t)(segment->end - (uint8_t *)(segment + 1)));
+		segment = next;
+	}
+	
+	pd4j_free(continuation, sizeof(pd4j_thread_continuation));
+}
+
+bool pd4j_thread_mount(pd4j_thread *thread, pd4j_thread_continuation *continuation) {
+	if (continuation->state == pd4j_CONTINUATION_MOUNTED || continuation->state == pd4j_CONTINUATION_DONE) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalStateException", (continuation->state == pd4j_CONTINUATION_DONE) ? "Continuation has already finished" : "Continuation is already mounted");
+		return false;
+	}
+	
+	pd4j_thread_frame *caller = thread->frame;
+	
+	continuation->callerSegment = thread->stackSegment;
+	continuation->callerDepth = thread->depth;
+	thread->stackSegment = continuation->stackSegment;
+	
+	if (continuation->state == pd4j_CONTINUATION_NEW) {
+		if (!pd4j_thread_frame_push(thread, continuation->entry, continuation->instance, true)) {
+			thread->stackSegment = continuation->callerSegment;
+			return false;
+		}
+		
+		continuation->bottom = thread->frame;
+		continuation->bottom->continuation = continuation;
+	}
+	else {
+		continuation->bottom->prev = caller;
+		continuation->bottom->returnPc = thread->pc;
+		
+		thread->frame = continuation->frame;
+		thread->pc = continuation->pc;
+		thread->depth += continuation->depth;
+	}
+	
+	// returning from a continuation mounted by native code hands the value back like any other internal call
+	continuation->bottom->wasInternalCall = caller == NULL;
+	
+	continuation->parent = thread->continuation;
+	continuation->state = pd4j_CONTINUATION_MOUNTED;
+	thread->continuation = continuation;
+	thread->safepoint = true;
+	
+	return true;
+}
+
+bool pd4j_thread_yield(pd4j_thread *thread) {
+	pd4j_thread_continuation *continuation = thread->continuation;
+	
+	if (continuation == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalStateException", "No continuation is mounted to yield from");
+		return false;
+	}
+	
+	// a frame run by a nested call from native code can't be left, since that code is still waiting on it
+	for (pd4j_thread_frame *frame = thread->frame; frame != continuation->bottom; frame = frame->prev) {
+		if (frame->wasInternalCall) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalStateException", "Continuation is pinned by a call from native code");
+			return false;
+		}
+	}
+	
+	continuation->frame = thread->frame;
+	continuation->pc = thread->pc;
+	continuation->stackSegment = thread->stackSegment;
+	continuation->depth = thread->depth - continuation->callerDepth;
+	
+	thread->frame = continuation->bottom->prev;
+	thread->pc = continuation->bottom->returnPc;
+	thread->stackSegment = continuation->callerSegment;
+	thread->depth = continuation->callerDepth;
+	thread->continuation = continuation->parent;
+	
+	continuation->bottom->prev = NULL;
+	continuation->parent = NULL;
+	continuation->state = pd4j_CONTINUATION_YIELDED;
+	
+	if (thread->frame == NULL) {
+		// nothing is left to run until the continuation is mounted again
+		pd4j_thread_block(thread);
+	}
+	else {
+		thread->safepoint = true;
+	}
+	
+	return true;
+}
+
+// unwinds to the innermost handler for the pending exception, which is left pending if it leaves the frames of the innermost call from native code
+static bool pd4j_thread_dispatch_exception(pd4j_thread *thread) {
+	pd4j_thread_reference *throwable = thread->throwable;
+	thread->throwable = NULL;
+	
+	while (thread->frame != NULL) {
+		pd4j_thread_frame *frame = thread->frame;
+		pd4j_link_method *link = frame->link;
+		pd4j_link_handler *handler;
+		
+		// the PC is past the start of the instruction that threw, or of the invoke that called the frame above
+		uint32_t pcOffset = (uint32_t)(thread->pc - link->code) - 1;
+		
+		if (!pd4j_link_find_handler(thread, link, pcOffset, throwable->data.instance.class->data.class.loaded, &handler)) {
+			// the error from resolving the catch type replaces the exception, and is thrown from the frame's caller
+			throwable = thread->throwable;
+			thread->throwable = NULL;
+		}
+		else if (handler != NULL) {
+			frame->sp = 0;
+			pd4j_thread_push_reference(frame, throwable);
 			
-			memcpy(top, constant, sizeof(pd4j_thread_stack_entry));
+			thread->pc = link->code + handler->handlerPc;
+			thread->safepoint = true;
+			return true;
+		}
+		
+		if (frame->lockedObject != NULL && !pd4j_thread_monitor_exit(thread, frame->lockedObject)) {
+			throwable = thread->throwable;
+			thread->throwable = NULL;
+		}
+		
+		bool internal = frame->wasInternalCall;
+		pd4j_thread_frame_pop(thread);
+		
+		if (internal) {
+			break;
+		}
+	}
+	
+	thread->throwable = throwable;
+	return false;
+}
+
+// returns false after an instruction throws or returns from a method called from native code
+static bool pd4j_thread_execute_instruction(pd4j_thread *thread) {
+	pd4j_thread_frame *frame = thread->frame;
+	
+	if (pd4j_thread_cached_opcodes[*thread->pc]) {
+		pd4j_thread_execute_cached(thread, frame);
+	}
+	
+#ifdef PD4J_PROFILE_OPCODES
+	pd4j_link_profile_instruction(thread->pc);
+#endif
+	
+	thread->instructionCount++;
+	uint8_t opcode = *(thread->pc++);
+	
+	switch (opcode) {
+		case 0x00: {
+			// nop
 			return true;
 		}
-		case 0x13: {
-			// ldc_w
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *constant = &currentClass->data.class.constantPool[temp];
-			
-			if (constant->tag == pd4j_VARIABLE_NONE) {
-				pd4j_class_constant *staticConstant = &currentClass->data.class.loaded->data.class->constantPool[temp];
-				
-				switch (staticConstant->tag) {
-					case pd4j_CONSTANT_INT: {
-						constant->tag = pd4j_VARIABLE_INT;
-						constant->name = NULL;
-						constant->data.intValue = staticConstant->data.intValue;
-						break;
-					}
-					case pd4j_CONSTANT_FLOAT: {
-						constant->tag = pd4j_VARIABLE_FLOAT;
-						constant->name = NULL;
-						constant->data.floatValue = staticConstant->data.floatValue;
-						break;
-					}
-					case pd4j_CONSTANT_CLASS: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_class_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_STRING: {
-						uint8_t *stringData;
-						if (!pd4j_class_constant_utf8(currentClass->data.class.loaded->data.class, temp, &stringData)) {
-							return false;
-						}
-						constant->tag = pd4j_VARIABLE_REFERENCE;
-						constant->data.referenceValue = pd4j_class_get_resolved_string_reference(currentClass->data.class.loaded, thread, stringData);
-						break;
-					}
-					case pd4j_CONSTANT_METHODHANDLE: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_method_handle_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_METHODTYPE: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_method_type_reference(&entry, thread, staticConstant, currentClass->data.class.loaded)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					case pd4j_CONSTANT_DYNAMIC: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_dynamic_reference(&entry, thread, staticConstant, currentClass)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					default: {
-						return false;
-					}
-				}
-			}
-			
-			memcpy(top, constant, sizeof(pd4j_thread_stack_entry));
+		case 0x09:
+		case 0x0a: {
+			// lconst_<l>
+			pd4j_thread_push_long(frame, opcode - 0x09);
 			return true;
 		}
-		case 0x14: {
-			// ldc2_w
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *constant = &currentClass->data.class.constantPool[temp];
-			
-			if (constant->tag == pd4j_VARIABLE_NONE) {
-				pd4j_class_constant *staticConstant = &currentClass->data.class.loaded->data.class->constantPool[temp];
-				pd4j_class_constant *staticConstant2 = &currentClass->data.class.loaded->data.class->constantPool[temp + 1];
-				
-				switch (staticConstant->tag) {
-					case pd4j_CONSTANT_LONG: {
-						constant->tag = pd4j_VARIABLE_LONG;
-						constant->name = NULL;
-						uint32_t *longPtr = (uint32_t *)(&constant->data.longValue);
-						
-						longPtr[1] = staticConstant->data.raw;
-						longPtr[0] = staticConstant2->data.raw;
-						break;
-					}
-					case pd4j_CONSTANT_DOUBLE: {
-						constant->tag = pd4j_VARIABLE_DOUBLE;
-						constant->name = NULL;
-						uint32_t *doublePtr = (uint32_t *)(&constant->data.longValue);
-						
-						doublePtr[1] = staticConstant->data.raw;
-						doublePtr[0] = staticConstant2->data.raw;
-						break;
-					}
-					case pd4j_CONSTANT_DYNAMIC: {
-						pd4j_thread_stack_entry *entry;
-						if (!pd4j_resolve_dynamic_reference(&entry, thread, staticConstant, currentClass)) {
-							return false;
-						}
-						memcpy(constant, entry, sizeof(pd4j_thread_stack_entry));
-						pd4j_free(entry, sizeof(pd4j_thread_stack_entry));
-						break;
-					}
-					default: {
-						return false;
-					}
-				}
-			}
-			
-			memcpy(top, constant, sizeof(pd4j_thread_stack_entry));
+		case 0x0e:
+		case 0x0f: {
+			// dconst_<d>
+			pd4j_thread_push_double(frame, (double)(opcode - 0x0e));
 			return true;
 		}
-		case 0x15: {
-			// iload
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			
-			top->tag = pd4j_VARIABLE_INT;
-			top->name = frame->locals[temp].name;
-			top->data.intValue = frame->locals[temp].data.intValue;
+		case 0x10: {
+			// bipush
+			pd4j_thread_push_int(frame, (int32_t)((int8_t)(*(thread->pc++))));
 			return true;
 		}
-		case 0x16: {
-			// lload
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
+		case 0x11: {
+			// sipush
 			uint16_t temp = *(thread->pc++);
+			temp = (temp << 8) | *(thread->pc++);
 			
-			top->tag = pd4j_VARIABLE_LONG;
-			top->name = frame->locals[temp].name;
-			uint32_t *longPtr = (uint32_t *)(&top->data.longValue);
-			
-			longPtr[1] = frame->locals[temp].data.raw;
-			longPtr[0] = frame->locals[temp + 1].data.raw;
+			pd4j_thread_push_int(frame, (int32_t)((int16_t)temp));
 			return true;
 		}
-		case 0x17: {
-			// fload
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
+		case 0x12:
+		case 0x13:
+		case 0x14: {
+			// ldc, ldc_w, ldc2_w
 			uint16_t temp = *(thread->pc++);
+			if (opcode != 0x12) {
+				temp = (temp << 8) | *(thread->pc++);
+			}
+			
+			pd4j_thread_stack_entry *constant = pd4j_thread_load_constant(thread, frame, temp);
+			if (constant == NULL) {
+				return false;
+			}
 			
-			top->tag = pd4j_VARIABLE_FLOAT;
-			top->name = frame->locals[temp].name;
-			top->data.floatValue = frame->locals[temp].data.floatValue;
+			pd4j_thread_push_entry(frame, constant);
 			return true;
 		}
-		case 0x18: {
-			// dload
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
+		case 0x15:
+		case 0x17:
+		case 0x19: {
+			// iload, fload, aload
 			uint16_t temp = *(thread->pc++);
 			
-			top->tag = pd4j_VARIABLE_DOUBLE;
-			top->name = frame->locals[temp].name;
-			uint32_t *doublePtr = (uint32_t *)(&top->data.longValue);
-			
-			doublePtr[1] = frame->locals[temp].data.raw;
-			doublePtr[0] = frame->locals[temp + 1].data.raw;
+			frame->operandStack[frame->sp++] = frame->locals[temp];
 			return true;
 		}
-		case 0x19: {
-			// aload
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
+		case 0x16:
+		case 0x18: {
+			// lload, dload
 			uint16_t temp = *(thread->pc++);
 			
-			top->tag = pd4j_VARIABLE_REFERENCE;
-			top->name = frame->locals[temp].name;
-			top->data.referenceValue = frame->locals[temp].data.referenceValue;
+			memcpy(&frame->operandStack[frame->sp], &frame->locals[temp], 2 * sizeof(pd4j_thread_variable));
+			frame->sp += 2;
 			return true;
 		}
 		case 0x1a:
@@ -707,11 +2498,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x1c:
 		case 0x1d: {
 			// iload_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_INT;
-			top->name = frame->locals[opcode - 0x1a].name;
-			top->data.intValue = frame->locals[opcode - 0x1a].data.intValue;
+			frame->operandStack[frame->sp++] = frame->locals[opcode - 0x1a];
 			return true;
 		}
 		case 0x1e:
@@ -719,14 +2506,8 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x20:
 		case 0x21: {
 			// lload_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_LONG;
-			top->name = frame->locals[opcode - 0x1e].name;
-			uint32_t *longPtr = (uint32_t *)(&top->data.longValue);
-			
-			longPtr[1] = frame->locals[opcode - 0x1e].data.raw;
-			longPtr[0] = frame->locals[opcode - 0x1e + 1].data.raw;
+			memcpy(&frame->operandStack[frame->sp], &frame->locals[opcode - 0x1e], 2 * sizeof(pd4j_thread_variable));
+			frame->sp += 2;
 			return true;
 		}
 		case 0x22:
@@ -734,11 +2515,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x24:
 		case 0x25: {
 			// fload_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_FLOAT;
-			top->name = frame->locals[opcode - 0x22].name;
-			top->data.floatValue = frame->locals[opcode - 0x22].data.floatValue;
+			frame->operandStack[frame->sp++] = frame->locals[opcode - 0x22];
 			return true;
 		}
 		case 0x26:
@@ -746,14 +2523,8 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x28:
 		case 0x29: {
 			// dload_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_DOUBLE;
-			top->name = frame->locals[opcode - 0x26].name;
-			uint32_t *doublePtr = (uint32_t *)(&top->data.longValue);
-			
-			doublePtr[1] = frame->locals[opcode - 0x26].data.raw;
-			doublePtr[0] = frame->locals[opcode - 0x26 + 1].data.raw;
+			memcpy(&frame->operandStack[frame->sp], &frame->locals[opcode - 0x26], 2 * sizeof(pd4j_thread_variable));
+			frame->sp += 2;
 			return true;
 		}
 		case 0x2a:
@@ -761,11 +2532,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x2c:
 		case 0x2d: {
 			// aload_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			
-			top->tag = pd4j_VARIABLE_REFERENCE;
-			top->name = frame->locals[opcode - 0x2a].name;
-			top->data.referenceValue = frame->locals[opcode - 0x2a].data.referenceValue;
+			frame->operandStack[frame->sp++] = frame->locals[opcode - 0x2a];
 			return true;
 		}
 		case 0x2e:
@@ -777,82 +2544,33 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x34:
 		case 0x35: {
 			// iaload, laload, faload, daload, aaload, baload, caload, saload
-			int32_t indexEntry = frame->operandStack[--frame->sp].data.intValue;
-			pd4j_thread_stack_entry *arrayRefEntry = &frame->operandStack[frame->sp];
-			
-			if (arrayRefEntry->data.referenceValue->kind == pd4j_REF_NULL) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/NullPointerException", "Could not access array because it is null");
-				return false;
-			}
-			
-			pd4j_thread_stack_entry *arrayRef = arrayRefEntry->data.referenceValue->data.instance.instanceFields;
+			int32_t index = pd4j_thread_pop_int(frame);
+			pd4j_thread_reference *array = pd4j_thread_pop_reference(frame);
 			
-			if (indexEntry < 0 || indexEntry >= arrayRefEntry->data.referenceValue->data.instance.numInstanceFields) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArrayIndexOutOfBoundsException", "Array index out of bounds");
+			pd4j_thread_stack_entry *element = pd4j_thread_array_element(thread, array, index);
+			if (element == NULL) {
 				return false;
 			}
 			
-			frame->operandStack[frame->sp] = arrayRef[indexEntry];
-			return true;
-		}
-		case 0x36: {
-			// istore
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			uint16_t temp = *(thread->pc++);
-			
-			frame->locals[temp].tag = pd4j_VARIABLE_INT;
-			frame->locals[temp].name = top->name;
-			frame->locals[temp].data.intValue = top->data.intValue;
-			return true;
-		}
-		case 0x37: {
-			// lstore
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			uint16_t temp = *(thread->pc++);
-			
-			frame->locals[temp].tag = pd4j_VARIABLE_LONG;
-			frame->locals[temp].name = top->name;
-			frame->locals[temp + 1].tag = pd4j_VARIABLE_NONE;
-			frame->locals[temp + 1].name = top->name;
-			uint32_t *longPtr = (uint32_t *)(&top->data.longValue);
-			
-			frame->locals[temp].data.raw = longPtr[1];
-			frame->locals[temp + 1].data.raw = longPtr[0];
+			pd4j_thread_push_entry(frame, element);
 			return true;
 		}
-		case 0x38: {
-			// fstore
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
+		case 0x36:
+		case 0x38:
+		case 0x3a: {
+			// istore, fstore, astore
 			uint16_t temp = *(thread->pc++);
 			
-			frame->locals[temp].tag = pd4j_VARIABLE_FLOAT;
-			frame->locals[temp].name = top->name;
-			frame->locals[temp].data.floatValue = top->data.floatValue;
+			frame->locals[temp] = frame->operandStack[--frame->sp];
 			return true;
 		}
+		case 0x37:
 		case 0x39: {
-			// dstore
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			uint16_t temp = *(thread->pc++);
-			
-			frame->locals[temp].tag = pd4j_VARIABLE_DOUBLE;
-			frame->locals[temp].name = top->name;
-			frame->locals[temp + 1].tag = pd4j_VARIABLE_NONE;
-			frame->locals[temp + 1].name = top->name;
-			uint32_t *doublePtr = (uint32_t *)(&top->data.doubleValue);
-			
-			frame->locals[temp].data.raw = doublePtr[1];
-			frame->locals[temp + 1].data.raw = doublePtr[0];
-			return true;
-		}
-		case 0x3a: {
-			// astore
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
+			// lstore, dstore
 			uint16_t temp = *(thread->pc++);
 			
-			frame->locals[temp].tag = top->tag;
-			frame->locals[temp].name = top->name;
-			frame->locals[temp].data.referenceValue = top->data.referenceValue;
+			frame->sp -= 2;
+			memcpy(&frame->locals[temp], &frame->operandStack[frame->sp], 2 * sizeof(pd4j_thread_variable));
 			return true;
 		}
 		case 0x3b:
@@ -860,11 +2578,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x3d:
 		case 0x3e: {
 			// istore_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			
-			frame->locals[opcode - 0x3b].tag = pd4j_VARIABLE_INT;
-			frame->locals[opcode - 0x3b].name = top->name;
-			frame->locals[opcode - 0x3b].data.intValue = top->data.intValue;
+			frame->locals[opcode - 0x3b] = frame->operandStack[--frame->sp];
 			return true;
 		}
 		case 0x3f:
@@ -872,16 +2586,8 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x41:
 		case 0x42: {
 			// lstore_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			
-			frame->locals[opcode - 0x3f].tag = pd4j_VARIABLE_LONG;
-			frame->locals[opcode - 0x3f].name = top->name;
-			frame->locals[opcode - 0x3f + 1].tag = pd4j_VARIABLE_NONE;
-			frame->locals[opcode - 0x3f + 1].name = top->name;
-			uint32_t *longPtr = (uint32_t *)(&top->data.longValue);
-			
-			frame->locals[opcode - 0x3f].data.raw = longPtr[1];
-			frame->locals[opcode - 0x3f + 1].data.raw = longPtr[0];
+			frame->sp -= 2;
+			memcpy(&frame->locals[opcode - 0x3f], &frame->operandStack[frame->sp], 2 * sizeof(pd4j_thread_variable));
 			return true;
 		}
 		case 0x43:
@@ -889,11 +2595,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x45:
 		case 0x46: {
 			// fstore_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			
-			frame->locals[opcode - 0x43].tag = pd4j_VARIABLE_FLOAT;
-			frame->locals[opcode - 0x43].name = top->name;
-			frame->locals[opcode - 0x43].data.floatValue = top->data.floatValue;
+			frame->locals[opcode - 0x43] = frame->operandStack[--frame->sp];
 			return true;
 		}
 		case 0x47:
@@ -901,16 +2603,8 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x49:
 		case 0x4a: {
 			// dstore_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			
-			frame->locals[opcode - 0x47].tag = pd4j_VARIABLE_DOUBLE;
-			frame->locals[opcode - 0x47].name = top->name;
-			frame->locals[opcode - 0x47 + 1].tag = pd4j_VARIABLE_NONE;
-			frame->locals[opcode - 0x47 + 1].name = top->name;
-			uint32_t *doublePtr = (uint32_t *)(&top->data.doubleValue);
-			
-			frame->locals[opcode - 0x47].data.raw = doublePtr[1];
-			frame->locals[opcode - 0x47 + 1].data.raw = doublePtr[0];
+			frame->sp -= 2;
+			memcpy(&frame->locals[opcode - 0x47], &frame->operandStack[frame->sp], 2 * sizeof(pd4j_thread_variable));
 			return true;
 		}
 		case 0x4b:
@@ -918,11 +2612,7 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x4d:
 		case 0x4e: {
 			// astore_n
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			
-			frame->locals[opcode - 0x4b].tag = top->tag;
-			frame->locals[opcode - 0x4b].name = top->name;
-			frame->locals[opcode - 0x4b].data.referenceValue = top->data.referenceValue;
+			frame->locals[opcode - 0x4b] = frame->operandStack[--frame->sp];
 			return true;
 		}
 		case 0x4f:
@@ -934,23 +2624,21 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		case 0x55:
 		case 0x56: {
 			// iastore, lastore, fastore, dastore, aastore, bastore, castore, sastore
-			pd4j_thread_stack_entry *valueEntry = &frame->operandStack[--frame->sp];
-			int32_t indexEntry = frame->operandStack[--frame->sp].data.intValue;
-			pd4j_thread_stack_entry *arrayRefEntry = &frame->operandStack[--frame->sp];
+			static const pd4j_thread_variable_tag elementTags[] = {pd4j_VARIABLE_INT, pd4j_VARIABLE_LONG, pd4j_VARIABLE_FLOAT, pd4j_VARIABLE_DOUBLE, pd4j_VARIABLE_REFERENCE, pd4j_VARIABLE_INT, pd4j_VARIABLE_INT, pd4j_VARIABLE_INT};
+			pd4j_thread_stack_entry value;
 			
-			if (arrayRefEntry->data.referenceValue->kind == pd4j_REF_NULL) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/NullPointerException", "Could not access array because it is null");
-				return false;
-			}
+			pd4j_thread_pop_entry(frame, elementTags[opcode - 0x4f], &value);
 			
-			pd4j_thread_stack_entry *arrayRef = arrayRefEntry->data.referenceValue->data.instance.instanceFields;
+			int32_t index = pd4j_thread_pop_int(frame);
+			pd4j_thread_reference *array = pd4j_thread_pop_reference(frame);
 			
-			if (indexEntry < 0 || indexEntry >= arrayRefEntry->data.referenceValue->data.instance.numInstanceFields) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArrayIndexOutOfBoundsException", "Array index out of bounds");
+			pd4j_thread_stack_entry *element = pd4j_thread_array_element(thread, array, index);
+			if (element == NULL) {
 				return false;
 			}
 			
-			arrayRef[indexEntry] = *valueEntry;
+			element->tag = value.tag;
+			element->data = value.data;
 			return true;
 		}
 		case 0x57: {
@@ -960,512 +2648,342 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		}
 		case 0x58: {
 			// pop2
-			pd4j_thread_stack_entry *valueEntry = &frame->operandStack[--frame->sp];
-			
-			if (valueEntry->tag != pd4j_VARIABLE_LONG && valueEntry->tag != pd4j_VARIABLE_DOUBLE) {
-				frame->sp--;
-			}
+			frame->sp -= 2;
 			return true;
 		}
 		case 0x59: {
 			// dup
-			pd4j_thread_stack_entry *value = &frame->operandStack[frame->sp++];
-			memcpy(&frame->operandStack[frame->sp], value, sizeof(pd4j_thread_stack_entry));
+			pd4j_thread_dup_insert(frame, 1, 0);
 			return true;
 		}
 		case 0x5a: {
 			// dup_x1
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			
-			frame->operandStack[frame->sp++] = value1;
-			frame->operandStack[frame->sp++] = value2;
-			frame->operandStack[frame->sp++] = value1;
+			pd4j_thread_dup_insert(frame, 1, 1);
 			return true;
 		}
 		case 0x5b: {
 			// dup_x2
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			
-			if (value2.tag == pd4j_VARIABLE_LONG || value2.tag == pd4j_VARIABLE_DOUBLE) {
-				frame->operandStack[frame->sp++] = value1;
-			}
-			else {
-				pd4j_thread_stack_entry value3 = frame->operandStack[--frame->sp];
-				
-				frame->operandStack[frame->sp++] = value1;
-				frame->operandStack[frame->sp++] = value3;
-			}
-			frame->operandStack[frame->sp++] = value2;
-			frame->operandStack[frame->sp++] = value1;
+			pd4j_thread_dup_insert(frame, 1, 2);
 			return true;
 		}
 		case 0x5c: {
 			// dup2
-			pd4j_thread_stack_entry value1 = frame->operandStack[frame->sp - 1];
-			
-			if (value1.tag != pd4j_VARIABLE_LONG && value1.tag != pd4j_VARIABLE_DOUBLE) {
-				pd4j_thread_stack_entry value2 = frame->operandStack[frame->sp - 2];
-				frame->operandStack[frame->sp++] = value2;
-			}
-			frame->operandStack[frame->sp++] = value1;
+			pd4j_thread_dup_insert(frame, 2, 0);
 			return true;
 		}
 		case 0x5d: {
 			// dup2_x1
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			
-			if (value1.tag != pd4j_VARIABLE_LONG && value1.tag != pd4j_VARIABLE_DOUBLE) {
-				pd4j_thread_stack_entry value3 = frame->operandStack[--frame->sp];
-				
-				frame->operandStack[frame->sp++] = value2;
-				frame->operandStack[frame->sp++] = value1;
-				frame->operandStack[frame->sp++] = value3;
-			}
-			frame->operandStack[frame->sp++] = value2;
-			frame->operandStack[frame->sp++] = value1;
+			pd4j_thread_dup_insert(frame, 2, 1);
 			return true;
 		}
 		case 0x5e: {
 			// dup2_x2
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			
-			if (value1.tag != pd4j_VARIABLE_LONG && value1.tag != pd4j_VARIABLE_DOUBLE) {
-				pd4j_thread_stack_entry value3 = frame->operandStack[--frame->sp];
-				pd4j_thread_stack_entry value4 = frame->operandStack[--frame->sp];
-				
-				frame->operandStack[frame->sp++] = value2;
-				frame->operandStack[frame->sp++] = value1;
-				frame->operandStack[frame->sp++] = value4;
-				frame->operandStack[frame->sp++] = value3;
-			}
-			else if (value2.tag != pd4j_VARIABLE_LONG && value2.tag != pd4j_VARIABLE_DOUBLE) {
-				pd4j_thread_stack_entry value3 = frame->operandStack[--frame->sp];
-				
-				if (value3.tag != pd4j_VARIABLE_LONG && value3.tag != pd4j_VARIABLE_DOUBLE) {
-					frame->operandStack[frame->sp++] = value1;
-					frame->operandStack[frame->sp++] = value3;
-				}
-				else {
-					frame->operandStack[frame->sp++] = value2;
-					frame->operandStack[frame->sp++] = value1;
-					frame->operandStack[frame->sp++] = value3;
-				}
-			}
-			else {
-				frame->operandStack[frame->sp++] = value1;
-			}
-			
-			frame->operandStack[frame->sp++] = value2;
-			frame->operandStack[frame->sp++] = value1;
+			pd4j_thread_dup_insert(frame, 2, 2);
 			return true;
 		}
 		case 0x5f: {
 			// swap
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
+			pd4j_thread_variable value1 = frame->operandStack[frame->sp - 1];
 			
-			frame->operandStack[frame->sp++] = value1;
-			frame->operandStack[frame->sp++] = value2;
+			frame->operandStack[frame->sp - 1] = frame->operandStack[frame->sp - 2];
+			frame->operandStack[frame->sp - 2] = value1;
 			return true;
 		}
 		case 0x60: {
 			// iadd
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue + value2.data.intValue;
+			pd4j_thread_push_int(frame, (int32_t)((uint32_t)value1 + (uint32_t)value2));
 			return true;
 		}
 		case 0x61: {
 			// ladd
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue + value2.data.longValue;
+			pd4j_thread_push_long(frame, (int64_t)((uint64_t)value1 + (uint64_t)value2));
 			return true;
 		}
 		case 0x62: {
 			// fadd
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->name = NULL;
-			outVal->data.floatValue = value1.data.floatValue + value2.data.floatValue;
+			pd4j_thread_push_float(frame, value1 + value2);
 			return true;
 		}
 		case 0x63: {
 			// dadd
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->name = NULL;
-			outVal->data.doubleValue = value1.data.doubleValue + value2.data.doubleValue;
+			pd4j_thread_push_double(frame, value1 + value2);
 			return true;
 		}
 		case 0x64: {
 			// isub
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue - value2.data.intValue;
+			pd4j_thread_push_int(frame, (int32_t)((uint32_t)value1 - (uint32_t)value2));
 			return true;
 		}
 		case 0x65: {
 			// lsub
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue - value2.data.longValue;
+			pd4j_thread_push_long(frame, (int64_t)((uint64_t)value1 - (uint64_t)value2));
 			return true;
 		}
 		case 0x66: {
 			// fsub
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->name = NULL;
-			outVal->data.floatValue = value1.data.floatValue - value2.data.floatValue;
+			pd4j_thread_push_float(frame, value1 - value2);
 			return true;
 		}
 		case 0x67: {
 			// dsub
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->name = NULL;
-			outVal->data.doubleValue = value1.data.doubleValue - value2.data.doubleValue;
+			pd4j_thread_push_double(frame, value1 - value2);
 			return true;
 		}
 		case 0x68: {
 			// imul
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue * value2.data.intValue;
+			pd4j_thread_push_int(frame, (int32_t)((uint32_t)value1 * (uint32_t)value2));
 			return true;
 		}
 		case 0x69: {
 			// lmul
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue * value2.data.longValue;
+			pd4j_thread_push_long(frame, (int64_t)((uint64_t)value1 * (uint64_t)value2));
 			return true;
 		}
 		case 0x6a: {
 			// fmul
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->name = NULL;
-			outVal->data.floatValue = value1.data.floatValue * value2.data.floatValue;
+			pd4j_thread_push_float(frame, value1 * value2);
 			return true;
 		}
 		case 0x6b: {
 			// dmul
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->name = NULL;
-			outVal->data.doubleValue = value1.data.doubleValue * value2.data.doubleValue;
+			pd4j_thread_push_double(frame, value1 * value2);
 			return true;
 		}
 		case 0x6c: {
 			// idiv
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			if (value2.data.intValue == 0) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArithmeticException", "Attempted division by zero");
+			if (value2 == 0) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ARITHMETIC, "/ by zero", 0, 0);
 				return false;
 			}
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue / value2.data.intValue;
+			// INT32_MIN / -1 overflows back to INT32_MIN
+			pd4j_thread_push_int(frame, (value2 == -1) ? (int32_t)(0u - (uint32_t)value1) : value1 / value2);
 			return true;
 		}
 		case 0x6d: {
 			// ldiv
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			if (value2.data.longValue == 0) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArithmeticException", "Attempted division by zero");
+			if (value2 == 0) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ARITHMETIC, "/ by zero", 0, 0);
 				return false;
 			}
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue / value2.data.longValue;
+			pd4j_thread_push_long(frame, (value2 == -1) ? (int64_t)(0u - (uint64_t)value1) : value1 / value2);
 			return true;
 		}
 		case 0x6e: {
 			// fdiv
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->name = NULL;
-			outVal->data.floatValue = value1.data.floatValue / value2.data.floatValue;
+			pd4j_thread_push_float(frame, value1 / value2);
 			return true;
 		}
 		case 0x6f: {
 			// ddiv
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->name = NULL;
-			outVal->data.doubleValue = value1.data.doubleValue / value2.data.doubleValue;
+			pd4j_thread_push_double(frame, value1 / value2);
 			return true;
 		}
 		case 0x70: {
 			// irem
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			if (value2.data.intValue == 0) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArithmeticException", "Attempted division by zero");
+			if (value2 == 0) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ARITHMETIC, "/ by zero", 0, 0);
 				return false;
 			}
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue % value2.data.intValue;
+			pd4j_thread_push_int(frame, (value2 == -1) ? 0 : value1 % value2);
 			return true;
 		}
 		case 0x71: {
 			// lrem
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			if (value2.data.longValue == 0) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/ArithmeticException", "Attempted division by zero");
+			if (value2 == 0) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_ARITHMETIC, "/ by zero", 0, 0);
 				return false;
 			}
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue % value2.data.longValue;
+			pd4j_thread_push_long(frame, (value2 == -1) ? 0 : value1 % value2);
 			return true;
 		}
 		case 0x72: {
 			// frem
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->name = NULL;
-			outVal->data.floatValue = fmodf(value1.data.floatValue, value2.data.floatValue);
+			pd4j_thread_push_float(frame, fmodf(value1, value2));
 			return true;
 		}
 		case 0x73: {
 			// drem
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->name = NULL;
-			outVal->data.doubleValue = fmod(value1.data.doubleValue, value2.data.doubleValue);
+			pd4j_thread_push_double(frame, fmod(value1, value2));
 			return true;
 		}
 		case 0x74: {
 			// ineg
-			pd4j_thread_stack_entry *value = &frame->operandStack[frame->sp];
-			value->data.intValue = -value->data.intValue;
+			pd4j_thread_push_int(frame, (int32_t)(0u - (uint32_t)pd4j_thread_pop_int(frame)));
 			return true;
 		}
 		case 0x75: {
 			// lneg
-			pd4j_thread_stack_entry *value = &frame->operandStack[frame->sp];
-			value->data.longValue = -value->data.longValue;
+			pd4j_thread_push_long(frame, (int64_t)(0u - (uint64_t)pd4j_thread_pop_long(frame)));
 			return true;
 		}
 		case 0x76: {
 			// fneg
-			pd4j_thread_stack_entry *value = &frame->operandStack[frame->sp];
-			value->data.floatValue = -value->data.floatValue;
+			pd4j_thread_push_float(frame, -pd4j_thread_pop_float(frame));
 			return true;
 		}
 		case 0x77: {
 			// dneg
-			pd4j_thread_stack_entry *value1 = &frame->operandStack[frame->sp];
-			value1->data.doubleValue = -value1->data.doubleValue;
+			pd4j_thread_push_double(frame, -pd4j_thread_pop_double(frame));
 			return true;
 		}
 		case 0x78: {
 			// ishl
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue << (value2.data.intValue & 0x1f);
+			pd4j_thread_push_int(frame, (int32_t)((uint32_t)value1 << (value2 & 0x1f)));
 			return true;
 		}
 		case 0x79: {
 			// lshl
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue << (value2.data.intValue & 0x3f);
+			pd4j_thread_push_long(frame, (int64_t)((uint64_t)value1 << (value2 & 0x3f)));
 			return true;
 		}
 		case 0x7a: {
 			// ishr
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue >> (value2.data.intValue & 0x1f);
+			pd4j_thread_push_int(frame, value1 >> (value2 & 0x1f));
 			return true;
 		}
 		case 0x7b: {
 			// lshr
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue >> (value2.data.intValue & 0x3f);
+			pd4j_thread_push_long(frame, value1 >> (value2 & 0x3f));
 			return true;
 		}
 		case 0x7c: {
 			// iushr
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = (int32_t)(((uint32_t)(value1.data.intValue)) >> (value2.data.intValue & 0x1f));
+			pd4j_thread_push_int(frame, (int32_t)((uint32_t)value1 >> (value2 & 0x1f)));
 			return true;
 		}
 		case 0x7d: {
 			// lushr
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = (int64_t)(((uint64_t)(value1.data.longValue)) >> (value2.data.longValue & 0x1f));
+			pd4j_thread_push_long(frame, (int64_t)((uint64_t)value1 >> (value2 & 0x3f)));
 			return true;
 		}
 		case 0x7e: {
 			// iand
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue & value2.data.intValue;
+			pd4j_thread_push_int(frame, value1 & value2);
 			return true;
 		}
 		case 0x7f: {
 			// land
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue & value2.data.longValue;
+			pd4j_thread_push_long(frame, value1 & value2);
 			return true;
 		}
 		case 0x80: {
 			// ior
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue | value2.data.intValue;
+			pd4j_thread_push_int(frame, value1 | value2);
 			return true;
 		}
 		case 0x81: {
 			// lor
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue | value2.data.longValue;
+			pd4j_thread_push_long(frame, value1 | value2);
 			return true;
 		}
 		case 0x82: {
 			// ixor
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			int32_t value1 = pd4j_thread_pop_int(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			outVal->data.intValue = value1.data.intValue ^ value2.data.intValue;
+			pd4j_thread_push_int(frame, value1 ^ value2);
 			return true;
 		}
 		case 0x83: {
 			// lxor
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->name = NULL;
-			outVal->data.longValue = value1.data.longValue ^ value2.data.longValue;
+			pd4j_thread_push_long(frame, value1 ^ value2);
 			return true;
 		}
 		case 0x84: {
@@ -1478,761 +2996,1179 @@ bool pd4j_thread_execute(pd4j_thread *thread) {
 		}
 		case 0x85: {
 			// i2l
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_LONG;
-			outVal->data.longValue = value.data.intValue;
+			pd4j_thread_push_long(frame, pd4j_thread_pop_int(frame));
 			return true;
 		}
 		case 0x86: {
 			// i2f
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->data.floatValue = value.data.intValue;
+			pd4j_thread_push_float(frame, (float)pd4j_thread_pop_int(frame));
 			return true;
 		}
 		case 0x87: {
 			// i2d
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->data.doubleValue = value.data.intValue;
+			pd4j_thread_push_double(frame, (double)pd4j_thread_pop_int(frame));
 			return true;
 		}
 		case 0x88: {
 			// l2i
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->data.intValue = (int32_t)(value.data.longValue);
+			pd4j_thread_push_int(frame, (int32_t)pd4j_thread_pop_long(frame));
 			return true;
 		}
 		case 0x89: {
 			// l2f
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->data.floatValue = value.data.longValue;
+			pd4j_thread_push_float(frame, (float)pd4j_thread_pop_long(frame));
 			return true;
 		}
 		case 0x8a: {
 			// l2d
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->data.doubleValue = value.data.longValue;
+			pd4j_thread_push_double(frame, (double)pd4j_thread_pop_long(frame));
 			return true;
 		}
 		case 0x8b: {
 			// f2i
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_INT;
+			float value = pd4j_thread_pop_float(frame);
 			
-			if (isnan(value.data.floatValue)) {
-				outVal->data.intValue = 0;
+			if (isnan(value)) {
+				pd4j_thread_push_int(frame, 0);
 			}
-			else if (isinf(value.data.floatValue)) {
-				if (value.data.floatValue > 0) {
-					outVal->data.intValue = INT32_MAX;
-				}
-				else {
-					outVal->data.intValue = INT32_MIN;
-				}
+			else if (value >= 2147483648.0f) {
+				pd4j_thread_push_int(frame, INT32_MAX);
+			}
+			else if (value <= -2147483648.0f) {
+				pd4j_thread_push_int(frame, INT32_MIN);
 			}
 			else {
-				outVal->data.intValue = (int32_t)(value.data.floatValue);
+				pd4j_thread_push_int(frame, (int32_t)value);
 			}
+			return true;
 		}
 		case 0x8c: {
 			// f2l
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_LONG;
+			float value = pd4j_thread_pop_float(frame);
 			
-			if (isnan(value.data.floatValue)) {
-				outVal->data.longValue = 0;
+			if (isnan(value)) {
+				pd4j_thread_push_long(frame, 0);
 			}
-			else if (isinf(value.data.floatValue)) {
-				if (value.data.floatValue > 0) {
-					outVal->data.longValue = INT64_MAX;
-				}
-				else {
-					outVal->data.longValue = INT64_MIN;
-				}
+			else if (value >= 9223372036854775808.0f) {
+				pd4j_thread_push_long(frame, INT64_MAX);
+			}
+			else if (value <= -9223372036854775808.0f) {
+				pd4j_thread_push_long(frame, INT64_MIN);
 			}
 			else {
-				outVal->data.longValue = (int64_t)(value.data.floatValue);
+				pd4j_thread_push_long(frame, (int64_t)value);
 			}
+			return true;
 		}
 		case 0x8d: {
 			// f2d
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_DOUBLE;
-			outVal->data.doubleValue = (double)(value.data.floatValue);
+			pd4j_thread_push_double(frame, (double)pd4j_thread_pop_float(frame));
 			return true;
 		}
 		case 0x8e: {
 			// d2i
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_INT;
+			double value = pd4j_thread_pop_double(frame);
 			
-			if (isnan(value.data.doubleValue)) {
-				outVal->data.intValue = 0;
+			if (isnan(value)) {
+				pd4j_thread_push_int(frame, 0);
 			}
-			else if (isinf(value.data.doubleValue)) {
-				if (value.data.doubleValue > 0) {
-					outVal->data.intValue = INT32_MAX;
-				}
-				else {
-					outVal->data.intValue = INT32_MIN;
-				}
+			else if (value >= 2147483647.0) {
+				pd4j_thread_push_int(frame, INT32_MAX);
+			}
+			else if (value <= -2147483648.0) {
+				pd4j_thread_push_int(frame, INT32_MIN);
 			}
 			else {
-				outVal->data.intValue = (int32_t)(value.data.doubleValue);
+				pd4j_thread_push_int(frame, (int32_t)value);
 			}
+			return true;
 		}
 		case 0x8f: {
 			// d2l
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_LONG;
+			double value = pd4j_thread_pop_double(frame);
 			
-			if (isnan(value.data.doubleValue)) {
-				outVal->data.longValue = 0;
+			if (isnan(value)) {
+				pd4j_thread_push_long(frame, 0);
 			}
-			else if (isinf(value.data.doubleValue)) {
-				if (value.data.doubleValue > 0) {
-					outVal->data.longValue = INT64_MAX;
-				}
-				else {
-					outVal->data.longValue = INT64_MIN;
-				}
+			else if (value >= 9223372036854775808.0) {
+				pd4j_thread_push_long(frame, INT64_MAX);
+			}
+			else if (value <= -9223372036854775808.0) {
+				pd4j_thread_push_long(frame, INT64_MIN);
 			}
 			else {
-				outVal->data.longValue = (int64_t)(value.data.doubleValue);
+				pd4j_thread_push_long(frame, (int64_t)value);
 			}
+			return true;
 		}
 		case 0x90: {
 			// d2f
-			pd4j_thread_stack_entry value = frame->operandStack[frame->sp];
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->tag = pd4j_VARIABLE_FLOAT;
-			outVal->data.floatValue = (float)(value.data.doubleValue);
+			pd4j_thread_push_float(frame, (float)pd4j_thread_pop_double(frame));
 			return true;
 		}
 		case 0x91: {
 			// i2b
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->data.intValue = (int8_t)(outVal->data.intValue & 0xff);
+			pd4j_thread_push_int(frame, (int8_t)(pd4j_thread_pop_int(frame) & 0xff));
 			return true;
 		}
 		case 0x92: {
 			// i2c
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->data.intValue = (uint16_t)(outVal->data.intValue & 0xffff);
+			pd4j_thread_push_int(frame, pd4j_thread_pop_int(frame) & 0xffff);
 			return true;
 		}
 		case 0x93: {
 			// i2s
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp];
-			outVal->data.intValue = (int16_t)(outVal->data.intValue & 0xffff);
+			pd4j_thread_push_int(frame, (int16_t)(pd4j_thread_pop_int(frame) & 0xffff));
 			return true;
 		}
 		case 0x94: {
 			// lcmp
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
+			int64_t value2 = pd4j_thread_pop_long(frame);
+			int64_t value1 = pd4j_thread_pop_long(frame);
 			
-			if (value1.data.intValue > value2.data.intValue) {
-				outVal->data.intValue = 1;
-			}
-			else if (value1.data.intValue < value2.data.intValue) {
-				outVal->data.intValue = -1;
-			}
-			else {
-				outVal->data.intValue = 0;
-			}
+			pd4j_thread_push_int(frame, (value1 > value2) - (value1 < value2));
 			return true;
 		}
 		case 0x95:
 		case 0x96: {
 			// fcmpl, fcmpg
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			float value2 = pd4j_thread_pop_float(frame);
+			float value1 = pd4j_thread_pop_float(frame);
 			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
-			
-			if (value1.data.floatValue > value2.data.floatValue) {
-				outVal->data.intValue = 1;
-			}
-			else if (value1.data.floatValue < value2.data.floatValue) {
-				outVal->data.intValue = -1;
-			}
-			else if (value1.data.floatValue == value2.data.floatValue) {
-				outVal->data.intValue = 0;
+			if (isnan(value1) || isnan(value2)) {
+				pd4j_thread_push_int(frame, (opcode == 0x96) ? 1 : -1);
 			}
 			else {
-				outVal->data.intValue = (opcode == 0x96) ? 1 : -1;
+				pd4j_thread_push_int(frame, (value1 > value2) - (value1 < value2));
 			}
 			return true;
 		}
 		case 0x97:
 		case 0x98: {
 			// dcmpl, dcmpg
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			
-			pd4j_thread_stack_entry *outVal = &frame->operandStack[frame->sp++];
-			outVal->tag = pd4j_VARIABLE_INT;
-			outVal->name = NULL;
+			double value2 = pd4j_thread_pop_double(frame);
+			double value1 = pd4j_thread_pop_double(frame);
 			
-			if (value1.data.doubleValue > value2.data.doubleValue) {
-				outVal->data.intValue = 1;
-			}
-			else if (value1.data.doubleValue < value2.data.doubleValue) {
-				outVal->data.intValue = -1;
-			}
-			else if (value1.data.doubleValue == value2.data.doubleValue) {
-				outVal->data.intValue = 0;
+			if (isnan(value1) || isnan(value2)) {
+				pd4j_thread_push_int(frame, (opcode == 0x98) ? 1 : -1);
 			}
 			else {
-				outVal->data.intValue = (opcode == 0x98) ? 1 : -1;
+				pd4j_thread_push_int(frame, (value1 > value2) - (value1 < value2));
 			}
 			return true;
 		}
 		case 0x99: {
 			// ifeq
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			if (value.data.intValue == 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
-			}
-			return true;
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) == 0);
 		}
 		case 0x9a: {
 			// ifne
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			if (value.data.intValue != 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
-			}
-			return true;
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) != 0);
 		}
 		case 0x9b: {
 			// iflt
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) < 0);
+		}
+		case 0x9c: {
+			// ifge
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) >= 0);
+		}
+		case 0x9d: {
+			// ifgt
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) > 0);
+		}
+		case 0x9e: {
+			// ifle
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) <= 0);
+		}
+		case 0x9f: {
+			// if_icmpeq
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) == value2);
+		}
+		case 0xa0: {
+			// if_icmpne
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) != value2);
+		}
+		case 0xa1: {
+			// if_icmplt
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) < value2);
+		}
+		case 0xa2: {
+			// if_icmpge
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) >= value2);
+		}
+		case 0xa3: {
+			// if_icmpgt
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) > value2);
+		}
+		case 0xa4: {
+			// if_icmple
+			int32_t value2 = pd4j_thread_pop_int(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_int(frame) <= value2);
+		}
+		case 0xa5: {
+			// if_acmpeq
+			pd4j_thread_reference *value2 = pd4j_thread_pop_reference(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_reference(frame) == value2);
+		}
+		case 0xa6: {
+			// if_acmpne
+			pd4j_thread_reference *value2 = pd4j_thread_pop_reference(frame);
+			return pd4j_thread_branch(thread, pd4j_thread_pop_reference(frame) != value2);
+		}
+		case 0xa7: {
+			// goto
+			return pd4j_thread_branch(thread, true);
+		}
+		case 0xa8: {
+			// jsr
+			pd4j_thread_variable *address = &frame->operandStack[frame->sp++];
+			pd4j_thread_slot_set_tag(address, pd4j_VARIABLE_RETURNADDRESS, NULL);
+			address->data.returnAddrValue = thread->pc + 2;
 			
-			if (value.data.intValue < 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			return pd4j_thread_branch(thread, true);
+		}
+		case 0xa9: {
+			// ret
+			uint8_t temp = *(thread->pc++);
+			uint8_t *target = frame->locals[temp].data.returnAddrValue;
+
+#ifdef PD4J_TRUST_UNVERIFIED
+			// nothing proved the local holds a return address, so at least keep the jump inside the method
+			if (target < frame->link->code || target >= frame->link->code + frame->link->codeLength) {
+				pd4j_thread_throw_class_with_message(thread, "java/lang/VerifyError", "ret to an address outside the method");
+				return false;
 			}
+#endif
+			
+			thread->pc = target;
 			return true;
 		}
-		case 0x9c: {
-			// ifge
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+		case pd4j_OPCODE_TABLESWITCH_QUICK: {
+			// tableswitch
+			uint8_t *prevPc = thread->pc - 1;
+			uint8_t *operands = frame->startPc + (((uint32_t)(prevPc - frame->startPc) + 4) & ~(uint32_t)3);
+			pd4j_link_switch *table = &frame->link->switches[(operands[2] << 8) | operands[3]];
+			
+			uint32_t entry = (uint32_t)pd4j_thread_pop_int(frame) - (uint32_t)table->lowValue;
+			
+			pd4j_thread_switch_to(thread, prevPc, (entry < table->numEntries) ? table->offsets[entry] : table->defaultOffset);
+			return true;
+		}
+		case pd4j_OPCODE_LOOKUPSWITCH_QUICK: {
+			// lookupswitch
+			uint8_t *prevPc = thread->pc - 1;
+			uint8_t *operands = frame->startPc + (((uint32_t)(prevPc - frame->startPc) + 4) & ~(uint32_t)3);
+			pd4j_link_switch *table = &frame->link->switches[(operands[2] << 8) | operands[3]];
+			
+			int32_t keyValue = pd4j_thread_pop_int(frame);
+			
+			if (table->keys == NULL) {
+				uint32_t entry = (uint32_t)keyValue - (uint32_t)table->lowValue;
+				
+				pd4j_thread_switch_to(thread, prevPc, (entry < table->numEntries) ? table->offsets[entry] : table->defaultOffset);
+				return true;
+			}
+			
+			uint32_t low = 0;
+			uint32_t high = table->numEntries;
 			
-			if (value.data.intValue >= 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			while (low < high) {
+				uint32_t middle = low + (high - low) / 2;
+				
+				if (table->keys[middle] < keyValue) {
+					low = middle + 1;
+				}
+				else {
+					high = middle;
+				}
 			}
+			
+			pd4j_thread_switch_to(thread, prevPc, (low < table->numEntries && table->keys[low] == keyValue) ? table->offsets[low] : table->defaultOffset);
 			return true;
 		}
-		case 0x9d: {
-			// ifgt
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+		case 0xac: {
+			// ireturn (special-cased for narrowing conversions)
+			pd4j_thread_variable *top = &frame->operandStack[frame->sp - 1];
 			
-			if (value.data.intValue > 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			switch (frame->link->signature.returnKind) {
+				case pd4j_LINK_RETURN_BOOLEAN:
+					top->data.intValue &= 0x1;
+					break;
+				case pd4j_LINK_RETURN_BYTE:
+					top->data.intValue = (int8_t)(top->data.intValue & 0xff);
+					break;
+				case pd4j_LINK_RETURN_CHAR:
+					top->data.intValue &= 0xffff;
+					break;
+				case pd4j_LINK_RETURN_SHORT:
+					top->data.intValue = (int16_t)(top->data.intValue & 0xffff);
+					break;
 			}
-			return true;
+			
+			return pd4j_thread_return_slots(thread, frame, pd4j_VARIABLE_INT, 1);
 		}
-		case 0x9e: {
-			// ifle
-			pd4j_thread_stack_entry value = frame->operandStack[--frame->sp];
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+		case 0xad:
+		case 0xae:
+		case 0xaf:
+		case 0xb0: {
+			// lreturn, freturn, dreturn, areturn
+			static const pd4j_thread_variable_tag returnTags[] = {pd4j_VARIABLE_LONG, pd4j_VARIABLE_FLOAT, pd4j_VARIABLE_DOUBLE, pd4j_VARIABLE_REFERENCE};
 			
-			if (value.data.intValue <= 0) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			return pd4j_thread_return_slots(thread, frame, returnTags[opcode - 0xad], (opcode == 0xad || opcode == 0xaf) ? 2 : 1);
+		}
+		case 0xb1: {
+			// return
+			if (frame->link->signature.isSynchronized || frame->wasInternalCall) {
+				return pd4j_thread_return(thread, NULL);
 			}
+			
+			pd4j_thread_frame_pop(thread);
 			return true;
 		}
-		case 0x9f: {
-			// if_icmpeq
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			
-			int16_t temp = *(thread->pc++);
+		case 0xb2: {
+			// getstatic
+			uint16_t temp = *(thread->pc++);
 			temp = (temp << 8) | *(thread->pc++);
 			
-			if (value1.data.intValue == value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
+			pd4j_thread_stack_entry *fieldRef;
+			
+			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp - 1], currentClass->data.class.loaded)) {
+				return false;
 			}
-			return true;
-		}
-		case 0xa0: {
-			// if_icmpne
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
 			
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			pd4j_thread_reference *fieldClass = fieldRef->data.referenceValue->data.field.class;
 			
-			if (value1.data.intValue != value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			for (uint16_t i = 0; i < fieldClass->data.class.numStaticFields; i++) {
+				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldClass->data.class.staticFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
+					pd4j_thread_push_entry(frame, &fieldClass->data.class.staticFields[i]);
+					return true;
+				}
 			}
-			return true;
-		}
-		case 0xa1: {
-			// if_icmplt
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
 			
-			int16_t temp = *(thread->pc++);
+			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Static field reference points to non-static field");
+			return false;
+		}
+		case 0xb3: {
+			// putstatic
+			uint16_t temp = *(thread->pc++);
 			temp = (temp << 8) | *(thread->pc++);
 			
-			if (value1.data.intValue < value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
-			}
-			return true;
-		}
-		case 0xa2: {
-			// if_icmpge
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
+			pd4j_thread_stack_entry *fieldRef;
 			
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			pd4j_thread_stack_entry value;
+			pd4j_thread_pop_entry(frame, pd4j_thread_field_tag(currentClass->data.class.loaded, temp), &value);
 			
-			if (value1.data.intValue >= value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp - 1], currentClass->data.class.loaded)) {
+				return false;
 			}
-			return true;
-		}
-		case 0xa3: {
-			// if_icmpgt
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
 			
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			pd4j_thread_reference *fieldClass = fieldRef->data.referenceValue->data.field.class;
 			
-			if (value1.data.intValue > value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			for (uint16_t i = 0; i < fieldClass->data.class.numStaticFields; i++) {
+				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldClass->data.class.staticFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
+					// todo: check whether the field is final and block access if it is
+					fieldClass->data.class.staticFields[i].tag = value.tag;
+					fieldClass->data.class.staticFields[i].data = value.data;
+					
+					return true;
+				}
 			}
-			return true;
-		}
-		case 0xa4: {
-			// if_icmple
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
 			
-			int16_t temp = *(thread->pc++);
+			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Static field reference points to non-static field");
+			return false;
+		}
+		case 0xb4: {
+			// getfield
+			uint16_t temp = *(thread->pc++);
 			temp = (temp << 8) | *(thread->pc++);
 			
-			if (value1.data.intValue <= value2.data.intValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			pd4j_thread_stack_entry *field = pd4j_thread_instance_field(thread, frame->currentMethod->data.method.class->data.class.loaded, temp, frame->operandStack[frame->sp - 1].data.referenceValue);
+			if (field == NULL) {
+				return false;
 			}
+			
+			frame->sp--;
+			pd4j_thread_push_entry(frame, field);
 			return true;
 		}
-		case 0xa5: {
-			// if_acmpeq
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
-			
-			int16_t temp = *(thread->pc++);
+		case 0xb5: {
+			// putfield
+			uint16_t temp = *(thread->pc++);
 			temp = (temp << 8) | *(thread->pc++);
 			
-			if (value1.data.referenceValue == value2.data.referenceValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
-			}
-			return true;
-		}
-		case 0xa6: {
-			// if_acmpne
-			pd4j_thread_stack_entry value2 = frame->operandStack[--frame->sp];
-			pd4j_thread_stack_entry value1 = frame->operandStack[--frame->sp];
+			pd4j_class_reference *classRef = frame->currentMethod->data.method.class->data.class.loaded;
 			
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			pd4j_thread_stack_entry value;
+			pd4j_thread_pop_entry(frame, pd4j_thread_field_tag(classRef, temp), &value);
 			
-			if (value1.data.referenceValue != value2.data.referenceValue) {
-				thread->pc -= 3;
-				thread->pc += temp;
+			pd4j_thread_stack_entry *field = pd4j_thread_instance_field(thread, classRef, temp, pd4j_thread_pop_reference(frame));
+			if (field == NULL) {
+				return false;
 			}
+			
+			// todo: check whether the field is final and block access if it is
+			field->tag = value.tag;
+			field->data = value.data;
 			return true;
 		}
-		case 0xa7: {
-			// goto
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			thread->pc -= 3;
-			thread->pc += temp;
-			return true;
+		case 0xb6:
+		case 0xb7:
+		case 0xb8:
+		case 0xb9: {
+			// invokevirtual, invokespecial, invokestatic, invokeinterface
+			// these are rewritten to their quick forms when the method is linked and never run directly
+			return false;
 		}
-		case 0xa8: {
-			// jsr
-			int16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+		case 0xbf: {
+			// athrow
+			pd4j_thread_reference *throwable = pd4j_thread_pop_reference(frame);
 			
-			pd4j_thread_stack_entry *address = &frame->operandStack[frame->sp++];
-			address->tag = pd4j_VARIABLE_RETURNADDRESS;
-			address->data.returnAddrValue = thread->pc;
+			if (throwable == NULL || throwable->kind == pd4j_REF_NULL) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot throw exception because it is null", 0, 0);
+				return false;
+			}
 			
-			thread->pc -= 3;
-			thread->pc += temp;
-			return true;
-		}
-		case 0xa9: {
-			// ret
-			uint8_t temp = *(thread->pc++);
-			thread->pc = frame->locals[temp].data.returnAddrValue;
-			return true;
+			pd4j_thread_throw(thread, throwable);
+			return false;
 		}
-		case 0xaa: {
-			// tableswitch
-			uint8_t *prevPc = thread->pc - 1;
+		case 0xc2: {
+			// monitorenter
+			pd4j_thread_reference *object = pd4j_thread_pop_reference(frame);
 			
-			while ((thread->pc - frame->startPc) % 4 != 0) {
-				thread->pc++;
+			if (object == NULL || object->kind == pd4j_REF_NULL) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot enter synchronized block because object is null", 0, 0);
+				return false;
 			}
 			
-			ssize_t defaultValue = *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
-			
-			int32_t lowValue = *(thread->pc++);
-			lowValue = (lowValue << 8) | *(thread->pc++);
-			lowValue = (lowValue << 8) | *(thread->pc++);
-			lowValue = (lowValue << 8) | *(thread->pc++);
+			return pd4j_thread_monitor_enter(thread, object);
+		}
+		case 0xc3: {
+			// monitorexit
+			pd4j_thread_reference *object = pd4j_thread_pop_reference(frame);
 			
-			int32_t highValue = *(thread->pc++);
-			highValue = (highValue << 8) | *(thread->pc++);
-			highValue = (highValue << 8) | *(thread->pc++);
-			highValue = (highValue << 8) | *(thread->pc++);
+			if (object == NULL || object->kind == pd4j_REF_NULL) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot exit synchronized block because object is null", 0, 0);
+				return false;
+			}
 			
-			ssize_t offsetTable[highValue - lowValue + 1];
+			return pd4j_thread_monitor_exit(thread, object);
+		}
+		case pd4j_OPCODE_INVOKEVIRTUAL_QUICK:
+		case pd4j_OPCODE_INVOKEINTERFACE_QUICK: {
+			uint16_t temp = *(thread->pc++);
+			temp = (temp << 8) | *(thread->pc++);
 			
-			for (int32_t i = 0; i < highValue - lowValue + 1; i++) {
-				offsetTable[i] = *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
+			if (opcode == pd4j_OPCODE_INVOKEINTERFACE_QUICK) {
+				// skip the count and the zero byte
+				thread->pc += 2;
 			}
 			
-			int32_t indexValue = frame->operandStack[--frame->sp].data.intValue;
+			pd4j_link_call_site *site = &frame->link->callSites[temp];
 			
-			if (indexValue > highValue || indexValue < lowValue) {
-				thread->pc = prevPc + defaultValue;
+			if (site->state == pd4j_CALL_SITE_UNRESOLVED && !pd4j_link_call_site_resolve(thread, frame->link, site)) {
+				return false;
 			}
-			else {
-				thread->pc = prevPc + offsetTable[indexValue - lowValue];
+			
+			pd4j_thread_reference *instance = frame->operandStack[frame->sp - site->numArgSlots - 1].data.referenceValue;
+			
+			if (instance->kind == pd4j_REF_NULL) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot invoke method because instance is null", 0, 0);
+				return false;
 			}
-			return true;
-		}
-		case 0xab: {
-			// lookupswitch
-			uint8_t *prevPc = thread->pc - 1;
 			
-			while ((thread->pc - frame->startPc) % 4 != 0) {
-				thread->pc++;
+			if (site->state == pd4j_CALL_SITE_BOUND || site->state == pd4j_CALL_SITE_DEVIRTUALIZED) {
+				// resolution just bound the site directly
+				site->hits++;
+				return pd4j_thread_invoke_direct(thread, frame, site->entries[0].target);
 			}
 			
-			ssize_t defaultValue = *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
-			defaultValue = (defaultValue << 8) | *(thread->pc++);
+			pd4j_link_method *target = pd4j_link_call_site_dispatch(thread, site, instance->data.instance.class->data.class.loaded);
 			
-			int32_t numPairs = *(thread->pc++);
-			numPairs = (numPairs << 8) | *(thread->pc++);
-			numPairs = (numPairs << 8) | *(thread->pc++);
-			numPairs = (numPairs << 8) | *(thread->pc++);
+			return target != NULL && pd4j_thread_frame_push(thread, target, NULL, false);
+		}
+		case pd4j_OPCODE_INVOKESPECIAL_QUICK:
+		case pd4j_OPCODE_INVOKESTATIC_QUICK:
+		case pd4j_OPCODE_INVOKEDIRECT_QUICK: {
+			uint16_t temp = *(thread->pc++);
+			temp = (temp << 8) | *(thread->pc++);
 			
-			int32_t matchTable[numPairs];
-			ssize_t offsetTable[numPairs];
+			pd4j_link_call_site *site = &frame->link->callSites[temp];
 			
-			for (int32_t i = 0; i < numPairs; i++) {
-				matchTable[i] = *(thread->pc++);
-				matchTable[i] = (matchTable[i] << 8) | *(thread->pc++);
-				matchTable[i] = (matchTable[i] << 8) | *(thread->pc++);
-				matchTable[i] = (matchTable[i] << 8) | *(thread->pc++);
-				
-				offsetTable[i] = *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
-				offsetTable[i] = (offsetTable[i] << 8) | *(thread->pc++);
+			if (site->state == pd4j_CALL_SITE_UNRESOLVED && !pd4j_link_call_site_resolve(thread, frame->link, site)) {
+				return false;
 			}
 			
-			int32_t keyValue = frame->operandStack[--frame->sp].data.intValue;
-			
-			for (int32_t i = 0; i < numPairs; i++) {
-				if (keyValue == matchTable[i]) {
-					thread->pc = prevPc + offsetTable[i];
-					return true;
-				}
+			if (opcode != pd4j_OPCODE_INVOKESTATIC_QUICK && frame->operandStack[frame->sp - site->numArgSlots - 1].data.referenceValue->kind == pd4j_REF_NULL) {
+				pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_NULL_POINTER, "Cannot invoke method because instance is null", 0, 0);
+				return false;
 			}
 			
-			thread->pc = prevPc + defaultValue;
-			return true;
+			site->hits++;
+			return pd4j_thread_invoke_direct(thread, frame, site->entries[0].target);
 		}
-		case 0xac: {
-			// ireturn (special-cased for narrowing conversions)
-			if (thread->monitor != NULL) {
-				if (--thread->monitor->monitor.entryCount != 0) {
-					pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalMonitorStateException", "Structured locking rule 1 violated");
-					return false;
-				}
-			}
+		case pd4j_OPCODE_ALOAD_0_GETFIELD: {
+			// aload_0, getfield
+			uint16_t temp = (uint16_t)((thread->pc[1] << 8) | thread->pc[2]);
+			thread->pc += 3;
 			
-			int32_t returnValue = frame->operandStack[--frame->sp].data.intValue;
-			if (frame->currentMethod->data.method.returnTypeDescriptor == pd4j_class_get_primitive_class_reference((uint8_t)'Z')) {
-				returnValue &= 0x1;
-			}
-			else if (frame->currentMethod->data.method.returnTypeDescriptor == pd4j_class_get_primitive_class_reference((uint8_t)'B')) {
-				returnValue = (int8_t)(returnValue & 0xff);
-			}
-			else if (frame->currentMethod->data.method.returnTypeDescriptor == pd4j_class_get_primitive_class_reference((uint8_t)'C')) {
-				returnValue &= 0xffff;
-			}
-			else if (frame->currentMethod->data.method.returnTypeDescriptor == pd4j_class_get_primitive_class_reference((uint8_t)'S')) {
-				returnValue = (int16_t)(returnValue & 0xffff);
+			pd4j_thread_stack_entry *field = pd4j_thread_instance_field(thread, frame->currentMethod->data.method.class->data.class.loaded, temp, frame->locals[0].data.referenceValue);
+			if (field == NULL) {
+				return false;
 			}
 			
-			bool internal = frame->wasInternalCall;
+			pd4j_thread_push_entry(frame, field);
+			return true;
+		}
+		case pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE: {
+			// iload, iload, iadd, istore
+			pd4j_thread_variable *result = &frame->locals[thread->pc[5]];
 			
-			pd4j_thread_frame_pop(thread);
+			pd4j_thread_slot_set_tag(result, pd4j_VARIABLE_INT, NULL);
+			result->data.intValue = (int32_t)((uint32_t)frame->locals[thread->pc[0]].data.intValue + (uint32_t)frame->locals[thread->pc[2]].data.intValue);
+			thread->pc += 6;
+			return true;
+		}
+		case pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT: {
+			// iload, bipush, if_icmplt
+			bool condition = frame->locals[thread->pc[0]].data.intValue < (int8_t)thread->pc[2];
 			
-			if (internal) {
-				pd4j_thread_stack_entry outVal;
-				
-				outVal.tag = pd4j_VARIABLE_INT;
-				outVal.name = NULL;
-				outVal.data.intValue = returnValue;
-				pd4j_thread_arg_push(thread, &outVal);
-				
+			thread->pc += 4;
+			return pd4j_thread_branch(thread, condition);
+		}
+		case pd4j_OPCODE_ALOAD_ILOAD_IALOAD: {
+			// aload, iload, iaload
+			pd4j_thread_reference *array = frame->locals[thread->pc[0]].data.referenceValue;
+			int32_t index = frame->locals[thread->pc[2]].data.intValue;
+			thread->pc += 4;
+			
+			pd4j_thread_stack_entry *element = pd4j_thread_array_element(thread, array, index);
+			if (element == NULL) {
 				return false;
 			}
-			else {
-				pd4j_thread_frame *callingFrame = thread->jvmStack->array[thread->jvmStack->size - 1];
-				pd4j_thread_stack_entry *outVal = &callingFrame->operandStack[callingFrame->sp++];
-				outVal->tag = pd4j_VARIABLE_INT;
-				outVal->name = NULL;
-				outVal->data.intValue = returnValue;
-				
-				return true;
-			}
+			
+			pd4j_thread_push_int(frame, element->data.intValue);
+			return true;
+		}
+		case pd4j_OPCODE_XALOAD_UNCHECKED: {
+			// <t>aload in bounds of a non-null array
+			int32_t index = pd4j_thread_pop_int(frame);
+			pd4j_thread_reference *array = pd4j_thread_pop_reference(frame);
+			
+			pd4j_thread_push_entry(frame, &array->data.instance.instanceFields[index]);
+			return true;
+		}
+		case pd4j_OPCODE_IASTORE_UNCHECKED:
+		case pd4j_OPCODE_LASTORE_UNCHECKED:
+		case pd4j_OPCODE_FASTORE_UNCHECKED:
+		case pd4j_OPCODE_DASTORE_UNCHECKED: {
+			// <t>astore in bounds of a non-null array
+			static const pd4j_thread_variable_tag elementTags[] = {pd4j_VARIABLE_INT, pd4j_VARIABLE_LONG, pd4j_VARIABLE_FLOAT, pd4j_VARIABLE_DOUBLE};
+			pd4j_thread_stack_entry value;
+			
+			pd4j_thread_pop_entry(frame, elementTags[opcode - pd4j_OPCODE_IASTORE_UNCHECKED], &value);
+			
+			int32_t index = pd4j_thread_pop_int(frame);
+			pd4j_thread_stack_entry *element = &pd4j_thread_pop_reference(frame)->data.instance.instanceFields[index];
+			
+			element->tag = value.tag;
+			element->data = value.data;
+			return true;
+		}
+		default: {
+			return false;
+		}
+	}
+	
+	return false;
+}
+
+bool pd4j_thread_execute(pd4j_thread *thread) {
+	if (pd4j_thread_execute_instruction(thread)) {
+		return true;
+	}
+	
+	return thread->throwable != NULL && pd4j_thread_dispatch_exception(thread);
+}
+
+void pd4j_thread_block(pd4j_thread *thread) {
+	thread->blocked = true;
+	thread->safepoint = true;
+}
+
+pd4j_thread_run_status pd4j_thread_run(pd4j_thread *thread, uint32_t maxInstructions, uint32_t maxMicros) {
+	if (thread->frame == NULL) {
+		return pd4j_THREAD_RUN_FINISHED;
+	}
+	
+	uint32_t startCount = thread->instructionCount;
+	// the elapsed time clock is only read from, so games are still free to reset it between runs
+	float deadline = (maxMicros != 0) ? pd->system->getElapsedTime() + (float)maxMicros / 1000000.0f : 0.0f;
+	
+	if (thread->waitingOn != NULL) {
+		pd4j_thread_monitor_wait_end(thread);
+	}
+	
+	// a thread waiting to enter a monitor can't go on until it's been handed the lock
+	if (thread->blockedOn != NULL) {
+		pd4j_scheduler_suspend(thread);
+		return pd4j_THREAD_RUN_BLOCKED;
+	}
+	
+	thread->safepoint = false;
+	thread->blocked = false;
+	
+	while (pd4j_thread_execute(thread)) {
+		if (!thread->safepoint) {
+			continue;
+		}
+		
+		thread->safepoint = false;
+		
+		if (thread->blocked) {
+			thread->blocked = false;
+			return pd4j_THREAD_RUN_BLOCKED;
+		}
+		else if (maxInstructions != 0 && thread->instructionCount - startCount >= maxInstructions) {
+			return pd4j_THREAD_RUN_BUDGET_EXHAUSTED;
+		}
+		else if (maxMicros != 0 && pd->system->getElapsedTime() >= deadline) {
+			return pd4j_THREAD_RUN_BUDGET_EXHAUSTED;
+		}
+	}
+	
+	return (thread->throwable != NULL) ? pd4j_THREAD_RUN_THREW : pd4j_THREAD_RUN_FINISHED;
+}
+
+// records the method and PC of as many frames as the backtrace has room for, leaving the rest of the stack trace to be worked out if it's ever asked for
+static void pd4j_thread_fill_backtrace(pd4j_thread *thread, pd4j_thread_backtrace *backtrace) {
+	uint8_t *pc = thread->pc;
+	uint32_t numFrames = 0;
+	
+	for (pd4j_thread_frame *frame = thread->frame; frame != NULL && numFrames < backtrace->capacity; frame = frame->prev) {
+		pd4j_thread_backtrace_frame *entry = &backtrace->frames[numFrames++];
+		
+		entry->method = frame->link;
+		entry->pcOffset = (pc > frame->link->code) ? (uint16_t)(pc - frame->link->code - 1) : 0;
+		
+		pc = frame->returnPc;
+	}
+	
+	backtrace->numFrames = numFrames;
+}
+
+static void pd4j_thread_capture_backtrace(pd4j_thread *thread, pd4j_thread_reference *throwable) {
+	pd4j_thread_backtrace *backtrace = pd4j_malloc(sizeof(pd4j_thread_backtrace) + thread->depth * sizeof(pd4j_thread_backtrace_frame));
+	
+	// the exception is thrown without a stack trace rather than replaced by an OutOfMemoryError
+	if (backtrace == NULL) {
+		return;
+	}
+	
+	backtrace->capacity = thread->depth;
+	backtrace->messageFormat = NULL;
+	
+	pd4j_thread_fill_backtrace(thread, backtrace);
+	throwable->data.instance.backtrace = backtrace;
+}
+
+void pd4j_thread_throw(pd4j_thread *thread, pd4j_thread_reference *throwable) {
+	// rethrowing keeps the stack trace from where it was first thrown
+	if (throwable->data.instance.backtrace == NULL) {
+		pd4j_thread_capture_backtrace(thread, throwable);
+	}
+	
+	thread->throwable = throwable;
+}
+
+pd4j_thread_reference *pd4j_thread_get_exception(pd4j_thread *thread) {
+	return thread->throwable;
+}
+
+uint32_t pd4j_thread_stack_trace_depth(pd4j_thread_reference *throwable) {
+	if (throwable->kind != pd4j_REF_INSTANCE || throwable->data.instance.backtrace == NULL) {
+		return 0;
+	}
+	
+	return throwable->data.instance.backtrace->numFrames;
+}
+
+bool pd4j_thread_stack_trace_get(pd4j_thread_reference *throwable, uint32_t idx, pd4j_thread_stack_trace_element *outElement) {
+	if (idx >= pd4j_thread_stack_trace_depth(throwable)) {
+		return false;
+	}
+	
+	pd4j_thread_backtrace_frame *frame = &throwable->data.instance.backtrace->frames[idx];
+	pd4j_link_method *link = frame->method;
+	
+	outElement->className = link->class->name;
+	outElement->methodName = link->method->name;
+	outElement->sourceFile = link->class->data.class->sourceFile;
+	outElement->lineNumber = pd4j_class_line_number(link->codeAttribute, frame->pcOffset);
+	
+	return true;
+}
+
+// a copy of the class name written with dots, like Java prints it
+static char *pd4j_thread_binary_name(uint8_t *className) {
+	char *name;
+	pd->system->formatString(&name, "%s", className);
+	
+	for (char *c = name; *c != '\0'; c++) {
+		if (*c == '/') {
+			*c = '.';
+		}
+	}
+	
+	return name;
+}
+
+void pd4j_thread_print_stack_trace(pd4j_thread_reference *throwable) {
+	if (throwable->kind != pd4j_REF_INSTANCE) {
+		return;
+	}
+	
+	char *className = pd4j_thread_binary_name(throwable->data.instance.class->data.class.name);
+	pd4j_thread_backtrace *backtrace = throwable->data.instance.backtrace;
+	
+	if (backtrace != NULL && backtrace->messageFormat != NULL) {
+		char *message;
+		pd->system->formatString(&message, backtrace->messageFormat, (int)(backtrace->messageArgs[0]), (int)(backtrace->messageArgs[1]));
+		
+		pd->system->logToConsole("%s: %s", className, message);
+		pd->system->realloc(message, 0);
+	}
+	else {
+		pd->system->logToConsole("%s", className);
+	}
+	
+	pd->system->realloc(className, 0);
+	
+	pd4j_thread_stack_trace_element element;
+	
+	for (uint32_t i = 0; pd4j_thread_stack_trace_get(throwable, i, &element); i++) {
+		className = pd4j_thread_binary_name(element.className);
+		
+		if (element.sourceFile == NULL) {
+			pd->system->logToConsole("\tat %s.%s(Unknown Source)", className, element.methodName);
+		}
+		else if (element.lineNumber < 0) {
+			pd->system->logToConsole("\tat %s.%s(%s)", className, element.methodName, element.sourceFile);
+		}
+		else {
+			pd->system->logToConsole("\tat %s.%s(%s:%d)", className, element.methodName, element.sourceFile, (int)element.lineNumber);
+		}
+		
+		pd->system->realloc(className, 0);
+	}
+}
+
+// the field a Throwable keeps its message in, or NULL if its class doesn't declare one
+static pd4j_thread_stack_entry *pd4j_thread_message_field(pd4j_thread_reference *throwable) {
+	for (uint32_t i = 0; i < throwable->data.instance.numInstanceFields; i++) {
+		pd4j_thread_stack_entry *field = &throwable->data.instance.instanceFields[i];
+		
+		if (strcmp((const char *)(field->name), "detailMessage") == 0) {
+			return field;
 		}
-		case 0xad:
-		case 0xae:
-		case 0xaf:
-		case 0xb0: {
-			// lreturn, freturn, dreturn, areturn
-			if (thread->monitor != NULL) {
-				if (--thread->monitor->monitor.entryCount != 0) {
-					pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalMonitorStateException", "Structured locking rule 1 was violated");
-					return false;
-				}
-			}
-			
-			pd4j_thread_stack_entry returnValue = frame->operandStack[--frame->sp];
-			bool internal = frame->wasInternalCall;
-			
-			pd4j_thread_frame_pop(thread);
+	}
+	
+	return NULL;
+}
+
+// the class loader's pool for the running method, or NULL if it hasn't made one
+static pd4j_thread_implicit_pool *pd4j_thread_implicit_pool_get(pd4j_thread *thread) {
+	if (thread->frame == NULL) {
+		return NULL;
+	}
+	
+	return pd4j_class_loader_get_implicit_pool(thread->frame->link->class->definingLoader);
+}
+
+void pd4j_thread_throw_class_with_message(pd4j_thread *thread, const char *class, char *message) {
+	// there's no class loader to make the Throwable with until a method runs
+	if (thread->frame == NULL || thread->throwing) {
+		pd->system->error("%s: %s", class, message);
+		return;
+	}
+	
+	pd4j_class_reference *resolvingClass = thread->frame->link->class;
+	pd4j_thread_reference *instance = NULL;
+	
+	thread->throwing = true;
+	
+	pd4j_thread_reference *classRef = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)class);
+	
+	if (classRef != NULL && pd4j_thread_construct_instance(thread, classRef, &instance) && message != NULL) {
+		pd4j_thread_stack_entry *field = pd4j_thread_message_field(instance);
+		
+		if (field != NULL) {
+			pd4j_thread_reference *string = pd4j_class_get_resolved_string_reference(resolvingClass, thread, (uint8_t *)message);
 			
-			if (internal) {
-				pd4j_thread_arg_push(thread, &returnValue);
-				
-				return false;
-			}
-			else {
-				pd4j_thread_frame *callingFrame = thread->jvmStack->array[thread->jvmStack->size - 1];
-				pd4j_thread_stack_entry *outVal = &callingFrame->operandStack[callingFrame->sp++];
-				memcpy(outVal, &returnValue, sizeof(pd4j_thread_stack_entry));
-				
-				return true;
+			if (string != NULL) {
+				field->data.referenceValue = string;
 			}
 		}
-		case 0xb1: {
-			// return
-			if (thread->monitor != NULL) {
-				if (--thread->monitor->monitor.entryCount != 0) {
-					pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalMonitorStateException", "Structured locking rule 1 was violated");
-					return false;
-				}
-			}
-			
-			bool internal = frame->wasInternalCall;
-			
-			pd4j_thread_frame_pop(thread);
-			
-			return !internal;
+	}
+	
+	thread->throwing = false;
+	
+	if (instance == NULL) {
+		pd4j_thread_implicit_pool *pool = pd4j_thread_implicit_pool_get(thread);
+		
+		if (pool != NULL && pool->instances[pd4j_IMPLICIT_OUT_OF_MEMORY][0] != NULL && pool->instances[pd4j_IMPLICIT_OUT_OF_MEMORY][0]->data.instance.backtrace != NULL) {
+			pd4j_thread_throw_implicit(thread, pd4j_IMPLICIT_OUT_OF_MEMORY, "Unable to allocate Throwable: Out of memory", 0, 0);
+			return;
 		}
-		case 0xb2: {
-			// getstatic
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp++];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *fieldRef;
-			
-			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp], currentClass->data.class.loaded)) {
-				return false;
-			}
-			
-			pd4j_thread_reference *fieldClass = fieldRef->data.referenceValue->data.field.class;
-			
-			for (uint16_t i = 0; i < fieldClass->data.class.numStaticFields; i++) {
-				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldClass->data.class.staticFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
-					memcpy(top, &fieldClass->data.class.staticFields[i], sizeof(pd4j_thread_stack_entry));
-					return true;
-				}
-			}
-			
-			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Static field reference points to non-static field");
-			return false;
+		
+		pd->system->error("%s: %s", class, message);
+		return;
+	}
+	
+	pd4j_thread_throw(thread, instance);
+}
+
+bool pd4j_thread_prepare_implicit_exceptions(pd4j_thread *thread) {
+	if (thread->frame == NULL) {
+		return false;
+	}
+	
+	pd4j_class_reference *resolvingClass = thread->frame->link->class;
+	
+	if (pd4j_class_loader_get_implicit_pool(resolvingClass->definingLoader) != NULL) {
+		return true;
+	}
+	
+	pd4j_thread_implicit_pool *pool = pd4j_malloc(sizeof(pd4j_thread_implicit_pool));
+	if (pool == NULL) {
+		return false;
+	}
+	
+	for (uint32_t kind = 0; kind < pd4j_IMPLICIT_COUNT; kind++) {
+		for (uint32_t i = 0; i < PD4J_THREAD_IMPLICIT_POOL_SIZE; i++) {
+			pool->instances[kind][i] = NULL;
 		}
-		case 0xb3: {
-			// putstatic
-			pd4j_thread_stack_entry *top = &frame->operandStack[--frame->sp];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *fieldRef;
-			
-			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp], currentClass->data.class.loaded)) {
-				return false;
-			}
-			
-			pd4j_thread_reference *fieldClass = fieldRef->data.referenceValue->data.field.class;
-			
-			for (uint16_t i = 0; i < fieldClass->data.class.numStaticFields; i++) {
-				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldClass->data.class.staticFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
-					// todo: check whether the field is final and block access if it is
-					fieldClass->data.class.staticFields[i].tag = top->tag;
-					fieldClass->data.class.staticFields[i].data = top->data;
-					
-					return true;
-				}
-			}
-			
-			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Static field reference points to non-static field");
-			return false;
+		pool->next[kind] = 0;
+	}
+	
+	pool->nullMessage.resolved = true;
+	pool->nullMessage.kind = pd4j_REF_NULL;
+	pool->nullMessage.lockWord = 0;
+	
+	// set before anything is resolved, so an exception thrown while the classes are initialized doesn't come back here
+	pd4j_class_loader_set_implicit_pool(resolvingClass->definingLoader, pool);
+	
+	bool prepared = true;
+	
+	for (uint32_t kind = 0; kind < pd4j_IMPLICIT_COUNT; kind++) {
+		pd4j_thread_reference *classRef = pd4j_class_get_resolved_class_reference(resolvingClass, thread, (uint8_t *)pd4j_thread_implicit_class_names[kind]);
+		
+		// the loader might not have every class, which is left to the fallback
+		if (classRef == NULL) {
+			thread->throwable = NULL;
+			prepared = false;
+			continue;
 		}
-		case 0xb4: {
-			// getfield
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp - 1];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
-			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *fieldRef;
+		
+		for (uint32_t i = 0; i < PD4J_THREAD_IMPLICIT_POOL_SIZE; i++) {
+			pd4j_thread_reference *instance = NULL;
 			
-			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp], currentClass->data.class.loaded)) {
-				return false;
+			if (!pd4j_thread_construct_instance(thread, classRef, &instance)) {
+				prepared = false;
+				break;
 			}
 			
-			pd4j_thread_reference *fieldInstance = top->data.referenceValue;
-			
-			if (fieldInstance->kind == pd4j_REF_NULL) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/NullPointerException", "Cannot access field because instance is null");
-				return false;
-			}
+			pd4j_thread_backtrace *backtrace = pd4j_malloc(sizeof(pd4j_thread_backtrace) + PD4J_THREAD_IMPLICIT_MAX_FRAMES * sizeof(pd4j_thread_backtrace_frame));
 			
-			for (uint16_t i = 0; i < fieldInstance->data.instance.numInstanceFields; i++) {
-				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldInstance->data.instance.instanceFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
-					memcpy(top, &fieldInstance->data.instance.instanceFields[i], sizeof(pd4j_thread_stack_entry));
-					return true;
-				}
+			if (backtrace == NULL) {
+				pd4j_thread_reference_destroy(instance);
+				prepared = false;
+				break;
 			}
 			
-			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Non-static field reference points to static field");
-			return false;
-		}
-		case 0xb5: {
-			// putfield
-			pd4j_thread_stack_entry *value = &frame->operandStack[--frame->sp];
-			
-			pd4j_thread_stack_entry *top = &frame->operandStack[frame->sp - 1];
-			uint16_t temp = *(thread->pc++);
-			temp = (temp << 8) | *(thread->pc++);
+			backtrace->capacity = PD4J_THREAD_IMPLICIT_MAX_FRAMES;
+			backtrace->numFrames = 0;
+			backtrace->messageFormat = NULL;
+			instance->data.instance.backtrace = backtrace;
 			
-			pd4j_thread_reference *currentClass = frame->currentMethod->data.method.class;
-			pd4j_thread_stack_entry *fieldRef;
+			pd4j_thread_stack_entry *field = pd4j_thread_message_field(instance);
 			
-			if (!pd4j_resolve_field_reference(&fieldRef, thread, &currentClass->data.class.loaded->data.class->constantPool[temp], currentClass->data.class.loaded)) {
-				return false;
+			if (field != NULL) {
+				pd4j_free(field->data.referenceValue, sizeof(pd4j_thread_reference));
+				field->data.referenceValue = &pool->nullMessage;
 			}
 			
-			pd4j_thread_reference *fieldInstance = top->data.referenceValue;
-			
-			if (fieldInstance->kind == pd4j_REF_NULL) {
-				pd4j_thread_throw_class_with_message(thread, "java/lang/NullPointerException", "Cannot access field because instance is null");
-				return false;
-			}
+			pool->instances[kind][i] = instance;
+		}
+	}
+	
+	return prepared;
+}
+
+void pd4j_thread_implicit_pool_destroy(pd4j_thread_implicit_pool *pool) {
+	for (uint32_t kind = 0; kind < pd4j_IMPLICIT_COUNT; kind++) {
+		for (uint32_t i = 0; i < PD4J_THREAD_IMPLICIT_POOL_SIZE && pool->instances[kind][i] != NULL; i++) {
+			pd4j_thread_reference_destroy(pool->instances[kind][i]);
+		}
+	}
+	
+	pd4j_free(pool, sizeof(pd4j_thread_implicit_pool));
+}
+
+void pd4j_thread_throw_implicit(pd4j_thread *thread, pd4j_thread_implicit_exception kind, const char *format, int32_t arg1, int32_t arg2) {
+	pd4j_thread_implicit_pool *pool = pd4j_thread_implicit_pool_get(thread);
+	pd4j_thread_reference *instance = NULL;
+	
+	if (pool != NULL && pool->instances[kind][0] != NULL) {
+		uint8_t slot = pool->next[kind];
+		
+		// only some of the instances may have been made
+		if (pool->instances[kind][slot] == NULL) {
+			slot = 0;
+		}
+		
+		pool->next[kind] = (slot + 1 < PD4J_THREAD_IMPLICIT_POOL_SIZE) ? slot + 1 : 0;
+		instance = pool->instances[kind][slot];
+	}
+	
+	// an instance without its backtrace has nowhere to keep the message, so it's thrown like any other exception
+	if (instance == NULL || instance->data.instance.backtrace == NULL) {
+		char *message;
+		pd->system->formatString(&message, format, (int)arg1, (int)arg2);
+		
+		pd4j_thread_throw_class_with_message(thread, pd4j_thread_implicit_class_names[kind], message);
+		pd->system->realloc(message, 0);
+		return;
+	}
+	
+	pd4j_thread_backtrace *backtrace = instance->data.instance.backtrace;
+	pd4j_thread_stack_entry *field = pd4j_thread_message_field(instance);
+	
+	if (field != NULL) {
+		field->data.referenceValue = &pool->nullMessage;
+	}
+	
+	backtrace->messageFormat = format;
+	backtrace->messageArgs[0] = arg1;
+	backtrace->messageArgs[1] = arg2;
+	
+	pd4j_thread_fill_backtrace(thread, backtrace);
+	thread->throwable = instance;
+}
+
+bool pd4j_thread_build_exception_message(pd4j_thread *thread, pd4j_thread_reference *throwable) {
+	if (throwable->kind != pd4j_REF_INSTANCE) {
+		return true;
+	}
+	
+	pd4j_thread_backtrace *backtrace = throwable->data.instance.backtrace;
+	
+	if (backtrace == NULL || backtrace->messageFormat == NULL) {
+		return true;
+	}
+	
+	pd4j_thread_stack_entry *field = pd4j_thread_message_field(throwable);
+	
+	if (field == NULL) {
+		backtrace->messageFormat = NULL;
+		return true;
+	}
+	
+	char *message;
+	pd->system->formatString(&message, backtrace->messageFormat, (int)(backtrace->messageArgs[0]), (int)(backtrace->messageArgs[1]));
+	
+	pd4j_thread_reference *string = pd4j_class_get_resolved_string_reference(throwable->data.instance.class->data.class.loaded, thread, (uint8_t *)message);
+	pd->system->realloc(message, 0);
+	
+	if (string == NULL) {
+		return false;
+	}
+	
+	field->data.referenceValue = string;
+	backtrace->messageFormat = NULL;
+	return true;
+}
+
+static bool pd4j_thread_native_object_hash_code(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)thread;
+	
+	// references never move, so the address is a stable identity hash
+	PD4J_NATIVE_RETURN_INT(result, (uintptr_t)PD4J_NATIVE_ARG_REFERENCE(args, 0) >> 3);
+	return true;
+}
+
+static bool pd4j_thread_native_object_get_class(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	// the class's canonical run-time reference, the same one a class literal resolves to, so getClass() == Foo.class holds
+	pd4j_thread_reference *mirror = pd4j_class_get_mirror(PD4J_NATIVE_ARG_REFERENCE(args, 0)->data.instance.class->data.class.loaded, thread);
+	if (mirror == NULL) {
+		return false;
+	}
+	
+	PD4J_NATIVE_RETURN_REFERENCE(result, mirror);
+	return true;
+}
+
+static bool pd4j_thread_native_object_wait(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	int64_t timeout = PD4J_NATIVE_ARG_LONG(args, 1);
+	
+	if (timeout < 0) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/IllegalArgumentException", "timeout value is negative");
+		return false;
+	}
+	
+	return pd4j_thread_monitor_wait(thread, PD4J_NATIVE_ARG_REFERENCE(args, 0), (timeout > PD4J_SCHEDULER_MAX_TIMEOUT) ? PD4J_SCHEDULER_MAX_TIMEOUT : (uint32_t)timeout);
+}
+
+static bool pd4j_thread_native_object_notify(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	return pd4j_thread_monitor_notify(thread, PD4J_NATIVE_ARG_REFERENCE(args, 0), false);
+}
+
+static bool pd4j_thread_native_object_notify_all(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	return pd4j_thread_monitor_notify(thread, PD4J_NATIVE_ARG_REFERENCE(args, 0), true);
+}
+
+static bool pd4j_thread_native_throwable_fill_in_stack_trace(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	pd4j_thread_reference *instance = PD4J_NATIVE_ARG_REFERENCE(args, 0);
+	pd4j_thread_backtrace *backtrace = instance->data.instance.backtrace;
+	
+	// a backtrace without room for the stack is replaced, except for the pooled ones of implicit exceptions, which are refilled as far as they go
+	if (backtrace == NULL || (backtrace->capacity < thread->depth && !pd4j_thread_implicit_pool_owns(instance))) {
+		pd4j_thread_capture_backtrace(thread, instance);
+	}
+	
+	if (instance->data.instance.backtrace == backtrace) {
+		// also where a new backtrace couldn't be allocated
+		if (backtrace != NULL) {
+			pd4j_thread_fill_backtrace(thread, backtrace);
+		}
+	}
+	else if (backtrace != NULL) {
+		pd4j_free(backtrace, sizeof(pd4j_thread_backtrace) + backtrace->capacity * sizeof(pd4j_thread_backtrace_frame));
+	}
+	
+	backtrace = instance->data.instance.backtrace;
+	
+	if (backtrace != NULL) {
+		// the Java half of fillInStackTrace and the constructors that called it aren't part of the stack trace
+		uint32_t skip = 0;
+		
+		while (skip < backtrace->numFrames) {
+			pd4j_link_method *method = backtrace->frames[skip].method;
 			
-			for (uint16_t i = 0; i < fieldInstance->data.instance.numInstanceFields; i++) {
-				if (strncmp((char *)(fieldRef->data.referenceValue->data.field.name), (char *)(fieldInstance->data.instance.instanceFields[i].name), strlen((char *)(fieldRef->data.referenceValue->data.field.name))) == 0) {
-					// todo: check whether the field is final and block access if it is
-					fieldInstance->data.instance.instanceFields[i].tag = value->tag;
-					fieldInstance->data.instance.instanceFields[i].data = value->data;
-					
-					return true;
-				}
+			if (strcmp((const char *)(method->method->name), "fillInStackTrace") != 0 && (strcmp((const char *)(method->method->name), "<init>") != 0 || !pd4j_class_extends(instance->data.instance.class->data.class.loaded, method->class))) {
+				break;
 			}
 			
-			pd4j_thread_throw_class_with_message(thread, "java/lang/IncompatibleClassChangeError", "Non-static field reference points to static field");
-			return false;
+			skip++;
 		}
-		case 0xb6: {
-			// todo: invokevirtual
+		
+		backtrace->numFrames -= skip;
+		memmove(backtrace->frames, &backtrace->frames[skip], backtrace->numFrames * sizeof(pd4j_thread_backtrace_frame));
+	}
+	
+	PD4J_NATIVE_RETURN_REFERENCE(result, instance);
+	return true;
+}
+
+// Continuation.run calls this each time it's run, to enter the Continuation for the first time or resume it where it last yielded
+// isContinue isn't used, since it comes from whether the stack chunk that HotSpot would have set is there
+static bool pd4j_thread_native_continuation_enter_special(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)result;
+	
+	pd4j_thread_reference *object = PD4J_NATIVE_ARG_REFERENCE(args, 0);
+	
+	if (javaContinuations == NULL) {
+		javaContinuations = pd4j_list_new(4);
+		
+		if (javaContinuations == NULL) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate continuation list: Out of memory");
 			return false;
 		}
-		default: {
-			return false;
+	}
+	
+	for (uint32_t i = 0; i < javaContinuations->size; i++) {
+		pd4j_thread_continuation *continuation = javaContinuations->array[i];
+		
+		if (continuation->object == object) {
+			return pd4j_thread_mount(thread, continuation);
 		}
 	}
 	
-	return false;
+	// Continuation.enter runs the target, then marks the Continuation done once it returns
+	pd4j_thread_reference enterRef;
+	enterRef.resolved = true;
+	enterRef.kind = pd4j_REF_CLASS_METHOD;
+	enterRef.data.method.name = (uint8_t *)"enter";
+	enterRef.data.method.descriptor = (uint8_t *)"(Ljdk/internal/vm/Continuation;Z)V";
+	enterRef.data.method.class = object->data.instance.class;
+	enterRef.data.method.declaringClass = NULL;
+	enterRef.data.method.property = NULL;
+	enterRef.lockWord = 0;
+	
+	pd4j_thread_continuation *continuation = pd4j_thread_continuation_new(thread, NULL, &enterRef);
+	if (continuation == NULL) {
+		return false;
+	}
+	
+	continuation->object = object;
+	
+	pd4j_thread_stack_entry arg;
+	arg.tag = pd4j_VARIABLE_REFERENCE;
+	arg.name = NULL;
+	arg.data.referenceValue = object;
+	pd4j_thread_arg_push(thread, &arg);
+	
+	arg.tag = pd4j_VARIABLE_INT;
+	arg.data.intValue = 0;
+	pd4j_thread_arg_push(thread, &arg);
+	
+	if (thread->throwable != NULL || !pd4j_thread_mount(thread, continuation)) {
+		pd4j_thread_continuation_destroy(continuation);
+		return false;
+	}
+	
+	pd4j_list_add(javaContinuations, continuation);
+	return true;
 }
 
-// todo
-void pd4j_thread_throw_class_with_message(pd4j_thread *thread, const char *class, char *message) {
-	(void)thread;
+static bool pd4j_thread_native_continuation_do_yield(pd4j_thread *thread, pd4j_thread_variable *args, pd4j_thread_stack_entry *result) {
+	(void)args;
 	
-	pd->system->error("%s: %s", class, message);
+	if (!pd4j_thread_yield(thread)) {
+		return false;
+	}
+	
+	// the value doYield returns once the continuation is mounted again
+	PD4J_NATIVE_RETURN_INT(result, 0);
+	return true;
+}
+
+static const pd4j_native_method pd4j_thread_natives[] = {
+	{"java/lang/Object", "hashCode", "()I", pd4j_thread_native_object_hash_code},
+	{"java/lang/Object", "getClass", "()Ljava/lang/Class;", pd4j_thread_native_object_get_class},
+	// wait0 is what Object.wait calls since JDK 19
+	{"java/lang/Object", "wait", "(J)V", pd4j_thread_native_object_wait},
+	{"java/lang/Object", "wait0", "(J)V", pd4j_thread_native_object_wait},
+	{"java/lang/Object", "notify", "()V", pd4j_thread_native_object_notify},
+	{"java/lang/Object", "notifyAll", "()V", pd4j_thread_native_object_notify_all},
+	{"java/lang/Throwable", "fillInStackTrace", "(I)Ljava/lang/Throwable;", pd4j_thread_native_throwable_fill_in_stack_trace},
+	{"jdk/internal/vm/Continuation", "enterSpecial", "(Ljdk/internal/vm/Continuation;ZZ)V", pd4j_thread_native_continuation_enter_special},
+	{"jdk/internal/vm/Continuation", "doYield", "()I", pd4j_thread_native_continuation_do_yield}
+};
+
+bool pd4j_thread_register_natives(void) {
+	return pd4j_native_register(pd4j_thread_natives, sizeof(pd4j_thread_natives) / sizeof(pd4j_native_method));
 }
\ No newline at end of file
@@ -7,6 +7,21 @@
 #include "class.h"
 #include "list.h"
 
+// default limit on the number of frames on a thread's stack before StackOverflowError is thrown
+#define PD4J_THREAD_DEFAULT_MAX_DEPTH 1024
+// usable bytes in each chained segment of a thread's stack
+#define PD4J_THREAD_STACK_SEGMENT_SIZE 16384
+// usable bytes in the first stack segment of a continuation, which is kept small since there may be thousands of them
+#define PD4J_THREAD_CONTINUATION_SEGMENT_SIZE 2048
+// values that can be waiting on a thread's argStack at once, enough for the 255 argument slots a method can take
+#define PD4J_THREAD_MAX_ARGS 256
+// most simple instructions run with the top of the operand stack cached before pd4j_thread_execute goes back to the full interpreter
+#define PD4J_THREAD_CACHED_RUN 64
+// instances of each implicit exception a class loader makes ahead of time, which are reused in turn
+#define PD4J_THREAD_IMPLICIT_POOL_SIZE 4
+// frames kept in the stack trace of an implicit exception, whose backtrace is made with the instance
+#define PD4J_THREAD_IMPLICIT_MAX_FRAMES 32
+
 typedef enum {
 	pd4j_REF_NULL = 0,
 	pd4j_REF_CLASS,
@@ -28,7 +43,18 @@ typedef enum {
 	pd4j_REF_HANDLE_INVOKEINTERFACE = 9
 } pd4j_thread_reference_handle_kind;
 
+// the exceptions the interpreter throws from its own checks, in the order of a pool's instances
+typedef enum {
+	pd4j_IMPLICIT_NULL_POINTER = 0,
+	pd4j_IMPLICIT_ARRAY_INDEX_OUT_OF_BOUNDS,
+	pd4j_IMPLICIT_ARITHMETIC,
+	pd4j_IMPLICIT_ILLEGAL_MONITOR_STATE,
+	pd4j_IMPLICIT_OUT_OF_MEMORY,
+	pd4j_IMPLICIT_COUNT
+} pd4j_thread_implicit_exception;
+
 typedef struct pd4j_thread_stack_entry pd4j_thread_stack_entry;
+typedef struct pd4j_thread_implicit_pool pd4j_thread_implicit_pool;
 
 typedef struct pd4j_thread_reference {
 	bool resolved;
@@ -54,17 +80,20 @@ typedef struct pd4j_thread_reference {
 			// components should be pd4j_thread_reference *
 			pd4j_list *argumentDescriptors;
 			struct pd4j_thread_reference *class;
+			// the class declaring the resolved method and its property; NULL for references built inside the VM
+			pd4j_class_reference *declaringClass;
+			pd4j_class_property *property;
 		} method;
 		struct {
 			uint32_t numInstanceFields;
 			pd4j_thread_stack_entry *instanceFields;
 			struct pd4j_thread_reference *class;
+			// where a Throwable was first thrown from, or NULL
+			struct pd4j_thread_backtrace *backtrace;
 		} instance;
 	} data;
-	struct {
-		pd4j_thread *owner;
-		uint32_t entryCount;
-	} monitor;
+	// 0 while unlocked, the owning thread and its recursion count while thinly locked, or a monitor with the low bit set once inflated
+	uintptr_t lockWord;
 } pd4j_thread_reference;
 
 typedef enum {
@@ -77,18 +106,36 @@ typedef enum {
 	pd4j_VARIABLE_DOUBLE
 } pd4j_thread_variable_tag;
 
+// a local variable or operand stack slot, with long and double values taking two
+// the type tag and name are only kept when PD4J_TAGGED_SLOTS is defined, as a debugging aid
+// a long or double is stored whole in native byte order, across both of its slots (or all in the first one if slots are tagged)
 typedef struct {
+#ifdef PD4J_TAGGED_SLOTS
 	pd4j_thread_variable_tag tag;
 	uint8_t *name;
+#endif
 	union {
 		int32_t intValue;
 		float floatValue;
 		pd4j_thread_reference *referenceValue;
 		uint8_t *returnAddrValue;
 		uint32_t raw;
+#ifdef PD4J_TAGGED_SLOTS
+		int64_t longValue;
+		double doubleValue;
+#endif
 	} data;
 } pd4j_thread_variable;
 
+// where the 64-bit value in a pair of slots is kept
+static inline void *pd4j_thread_slots_wide(pd4j_thread_variable *slots) {
+#ifdef PD4J_TAGGED_SLOTS
+	return &slots[0].data.longValue;
+#else
+	return slots;
+#endif
+}
+
 struct pd4j_thread_stack_entry {
 	pd4j_thread_variable_tag tag;
 	uint8_t *name;
@@ -102,10 +149,39 @@ struct pd4j_thread_stack_entry {
 	} data;
 };
 
+// one frame of a stack trace
+typedef struct {
+	uint8_t *className;
+	uint8_t *methodName;
+	// NULL if the class has no SourceFile attribute
+	uint8_t *sourceFile;
+	// -1 if the method has no line number table
+	int32_t lineNumber;
+} pd4j_thread_stack_trace_element;
+
 typedef struct pd4j_thread pd4j_thread;
+typedef struct pd4j_scheduler_task pd4j_scheduler_task;
+typedef struct pd4j_thread_continuation pd4j_thread_continuation;
+
+// why pd4j_thread_run stopped
+typedef enum {
+	// the method the thread was started with returned, leaving its value on the argStack
+	pd4j_THREAD_RUN_FINISHED = 0,
+	// the instruction or time budget ran out, and the thread picks up where it left off on the next run
+	pd4j_THREAD_RUN_BUDGET_EXHAUSTED,
+	// a native method called pd4j_thread_block, and the thread picks up after the call on the next run
+	pd4j_THREAD_RUN_BLOCKED,
+	// an exception left the method the thread was started with
+	pd4j_THREAD_RUN_THREW
+} pd4j_thread_run_status;
 
 pd4j_thread *pd4j_thread_new(uint8_t *name);
 pd4j_thread_reference *pd4j_thread_current_class(pd4j_thread *thread);
+void pd4j_thread_set_max_depth(pd4j_thread *thread, uint32_t maxDepth);
+
+// the scheduler's record of the thread, or NULL if it isn't scheduled
+pd4j_scheduler_task *pd4j_thread_get_task(pd4j_thread *thread);
+void pd4j_thread_set_task(pd4j_thread *thread, pd4j_scheduler_task *task);
 
 void pd4j_thread_destroy(pd4j_thread *thread);
 
@@ -115,17 +191,76 @@ bool pd4j_thread_initialize_class(pd4j_thread *thread, pd4j_thread_reference *th
 bool pd4j_thread_construct_instance(pd4j_thread *thread, pd4j_thread_reference *thRef, pd4j_thread_reference **outInstance);
 
 // these functions manipulate the argStack for JVM method calls
+// pushing copies the value into space the thread already owns, and popping copies it out into the caller's entry, so neither allocates
+// popping returns false, leaving an empty entry, if there was nothing to pop
 void pd4j_thread_arg_push(pd4j_thread *thread, pd4j_thread_stack_entry *value);
-pd4j_thread_stack_entry *pd4j_thread_arg_pop(pd4j_thread *thread);
+bool pd4j_thread_arg_pop(pd4j_thread *thread, pd4j_thread_stack_entry *value);
 
 // these functions invoke the method immediately and don't return until its execution is complete
 bool pd4j_thread_invoke_static_method(pd4j_thread *thread, pd4j_thread_reference *methodRef);
 bool pd4j_thread_invoke_instance_method(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef);
 
+// pushes a frame for the method, with its arguments taken from the argStack, without running it
+bool pd4j_thread_start_method(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef);
+
 // normal execution function for threads
 bool pd4j_thread_execute(pd4j_thread *thread);
 
-// throws a predefined Throwable from native code
+// a method run on frames of its own, which can yield partway through and be resumed later on any thread
+// the method's arguments are taken from the argStack when the continuation is first mounted
+pd4j_thread_continuation *pd4j_thread_continuation_new(pd4j_thread *thread, pd4j_thread_reference *instance, pd4j_thread_reference *methodRef);
+bool pd4j_thread_continuation_done(pd4j_thread_continuation *continuation);
+// a continuation can't be destroyed while it's mounted
+void pd4j_thread_continuation_destroy(pd4j_thread_continuation *continuation);
+
+// puts the frames of the continuation on top of the thread's, to run until it yields or returns to the frame that mounted it
+// mounting with no frames on the thread makes pd4j_thread_run come back with pd4j_THREAD_RUN_BLOCKED when it yields
+bool pd4j_thread_mount(pd4j_thread *thread, pd4j_thread_continuation *continuation);
+// takes the frames of the innermost mounted continuation back off the thread, without copying them
+bool pd4j_thread_yield(pd4j_thread *thread);
+
+// Object.wait, notify and notifyAll, which throw IllegalMonitorStateException unless the thread holds the object's monitor
+// a waiting thread stops at the next safepoint like after pd4j_thread_block, and holds the monitor again by the time it carries on
+// a timeout of 0 waits until notified
+bool pd4j_thread_monitor_wait(pd4j_thread *thread, pd4j_thread_reference *object, uint32_t millis);
+bool pd4j_thread_monitor_notify(pd4j_thread *thread, pd4j_thread_reference *object, bool all);
+// notifies every thread waiting on the object without holding its monitor, like when a java.lang.Thread terminates
+void pd4j_thread_monitor_notify_exited(pd4j_thread_reference *object);
+
+// makes pd4j_thread_run return at the next safepoint, which comes straight after the native method that calls this returns
+void pd4j_thread_block(pd4j_thread *thread);
+
+// registers the natives of java.lang.Object and Throwable, and Continuation.enterSpecial and doYield
+bool pd4j_thread_register_natives(void);
+
+// executes until the thread finishes, throws, blocks, or uses up its budget (0 for no limit on either)
+// the budget is only checked at backward branches and method entries, so a run can go a little past it
+pd4j_thread_run_status pd4j_thread_run(pd4j_thread *thread, uint32_t maxInstructions, uint32_t maxMicros);
+
+// throws from native code, which then returns false; the exception goes to a handler once control is back in the interpreter
+void pd4j_thread_throw(pd4j_thread *thread, pd4j_thread_reference *throwable);
+// the exception that left the method the thread was started with, or NULL
+pd4j_thread_reference *pd4j_thread_get_exception(pd4j_thread *thread);
+
+// a Throwable only keeps the method and PC of each frame when it's first thrown, which are looked up in line number tables when these are called
+uint32_t pd4j_thread_stack_trace_depth(pd4j_thread_reference *throwable);
+bool pd4j_thread_stack_trace_get(pd4j_thread_reference *throwable, uint32_t idx, pd4j_thread_stack_trace_element *outElement);
+// writes the class of the Throwable and the frames it was thrown from to the console, like Throwable.printStackTrace
+void pd4j_thread_print_stack_trace(pd4j_thread_reference *throwable);
+
+// makes the Throwable with the class loader of the running method, and is fatal if no method is running or making it throws
+// if there isn't the memory to make it, the class loader's preallocated OutOfMemoryError is thrown instead
 void pd4j_thread_throw_class_with_message(pd4j_thread *thread, const char *class, char *message);
 
+// resolves the implicit exceptions for the class loader of the running method and makes a pool of each, if it hasn't been done yet
+// a class loader without some of them makes those like pd4j_thread_throw_class_with_message when they're thrown
+bool pd4j_thread_prepare_implicit_exceptions(pd4j_thread *thread);
+void pd4j_thread_implicit_pool_destroy(pd4j_thread_implicit_pool *pool);
+
+// throws the next instance from the pool without allocating anything, overwriting its stack trace
+// the format (which must be a string constant) and its two arguments are only made into a detailMessage if it's asked for
+void pd4j_thread_throw_implicit(pd4j_thread *thread, pd4j_thread_implicit_exception kind, const char *format, int32_t arg1, int32_t arg2);
+// sets detailMessage from the message an implicit exception was thrown with, like Throwable.getMessage needs
+bool pd4j_thread_build_exception_message(pd4j_thread *thread, pd4j_thread_reference *throwable);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1400 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "api_ptr.h"
+#include "class.h"
+#include "link.h"
+#include "memory.h"
+#include "thread.h"
+#include "verify.h"
+
+typedef struct {
+	pd4j_link_method *link;
+	pd4j_class *class;
+	
+	uint8_t *code;
+	uint32_t codeLength;
+	
+	uint16_t maxLocals;
+	uint16_t maxStack;
+	
+	// the types at the instruction being checked
+	pd4j_verify_type *locals;
+	pd4j_verify_type *stack;
+	uint16_t sp;
+	
+	// scratch space for decoding the StackMapTable
+	pd4j_verify_type *mapLocals;
+	pd4j_verify_type *mapStack;
+	
+	uint32_t offset;
+	// why verification failed, or NULL if another exception was thrown instead
+	const char *error;
+} pd4j_verify_state;
+
+static const pd4j_verify_type pd4j_verify_top = { pd4j_VERIFY_TOP, { NULL } };
+
+static inline uint16_t pd4j_verify_read16(uint8_t *ptr) {
+	return (uint16_t)((ptr[0] << 8) | ptr[1]);
+}
+
+static inline int32_t pd4j_verify_read32(uint8_t *ptr) {
+	return (int32_t)(((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | (uint32_t)ptr[3]);
+}
+
+static bool pd4j_verify_fail(pd4j_verify_state *state, const char *error) {
+	state->error = error;
+	return false;
+}
+
+static inline bool pd4j_verify_is_wide(pd4j_verify_type_tag tag) {
+	return tag == pd4j_VERIFY_LONG || tag == pd4j_VERIFY_DOUBLE;
+}
+
+static inline bool pd4j_verify_is_reference(pd4j_verify_type_tag tag) {
+	return tag == pd4j_VERIFY_NULL || tag == pd4j_VERIFY_UNINITIALIZED_THIS || tag == pd4j_VERIFY_OBJECT || tag == pd4j_VERIFY_UNINITIALIZED;
+}
+
+static inline pd4j_verify_type pd4j_verify_type_new(pd4j_verify_type_tag tag) {
+	pd4j_verify_type type;
+	type.tag = tag;
+	type.data.className = NULL;
+	return type;
+}
+
+// references are only checked by kind; whether their classes fit is left to resolution at run time
+static bool pd4j_verify_is_assignable(pd4j_verify_type *from, pd4j_verify_type *to) {
+	switch (to->tag) {
+		case pd4j_VERIFY_TOP:
+			return true;
+		case pd4j_VERIFY_OBJECT:
+			return from->tag == pd4j_VERIFY_OBJECT || from->tag == pd4j_VERIFY_NULL;
+		case pd4j_VERIFY_UNINITIALIZED:
+			return from->tag == pd4j_VERIFY_UNINITIALIZED && from->data.newOffset == to->data.newOffset;
+		default:
+			return from->tag == to->tag;
+	}
+}
+
+// reads one field type from a descriptor and returns where the next one starts, with void becoming TOP
+static uint8_t *pd4j_verify_parse_descriptor(uint8_t *descriptor, pd4j_verify_type *type) {
+	*type = pd4j_verify_type_new(pd4j_VERIFY_OBJECT);
+	
+	switch (*descriptor) {
+		case 'B':
+		case 'C':
+		case 'I':
+		case 'S':
+		case 'Z':
+			type->tag = pd4j_VERIFY_INTEGER;
+			return descriptor + 1;
+		case 'F':
+			type->tag = pd4j_VERIFY_FLOAT;
+			return descriptor + 1;
+		case 'J':
+			type->tag = pd4j_VERIFY_LONG;
+			return descriptor + 1;
+		case 'D':
+			type->tag = pd4j_VERIFY_DOUBLE;
+			return descriptor + 1;
+		case '[':
+			while (*descriptor == '[') {
+				descriptor++;
+			}
+			return (*descriptor == 'L') ? (uint8_t *)strchr((char *)descriptor, ';') + 1 : descriptor + 1;
+		case 'L':
+			return (uint8_t *)strchr((char *)descriptor, ';') + 1;
+		default:
+			type->tag = pd4j_VERIFY_TOP;
+			return descriptor + 1;
+	}
+}
+
+static pd4j_verify_type_tag pd4j_verify_char_tag(char c) {
+	switch (c) {
+		case 'I': return pd4j_VERIFY_INTEGER;
+		case 'F': return pd4j_VERIFY_FLOAT;
+		case 'J': return pd4j_VERIFY_LONG;
+		case 'D': return pd4j_VERIFY_DOUBLE;
+		default: return pd4j_VERIFY_OBJECT;
+	}
+}
+
+static bool pd4j_verify_push(pd4j_verify_state *state, pd4j_verify_type type) {
+	uint16_t size = pd4j_verify_is_wide(type.tag) ? 2 : 1;
+	
+	if (state->sp + size > state->maxStack) {
+		return pd4j_verify_fail(state, "Operand stack overflow");
+	}
+	
+	state->stack[state->sp++] = type;
+	if (size == 2) {
+		state->stack[state->sp++] = pd4j_verify_top;
+	}
+	return true;
+}
+
+static inline bool pd4j_verify_push_tag(pd4j_verify_state *state, pd4j_verify_type_tag tag) {
+	return pd4j_verify_push(state, pd4j_verify_type_new(tag));
+}
+
+// pops a value of a primitive type
+static bool pd4j_verify_pop(pd4j_verify_state *state, pd4j_verify_type_tag tag) {
+	uint16_t size = pd4j_verify_is_wide(tag) ? 2 : 1;
+	
+	if (state->sp < size) {
+		return pd4j_verify_fail(state, "Operand stack underflow");
+	}
+	if (state->stack[state->sp - size].tag != tag || (size == 2 && state->stack[state->sp - 1].tag != pd4j_VERIFY_TOP)) {
+		return pd4j_verify_fail(state, "Wrong type on the operand stack");
+	}
+	
+	state->sp -= size;
+	return true;
+}
+
+// pops a reference, which may only be to an object that isn't initialized yet when the instruction allows it
+static pd4j_verify_type *pd4j_verify_pop_reference(pd4j_verify_state *state, bool allowUninitialized) {
+	if (state->sp < 1) {
+		pd4j_verify_fail(state, "Operand stack underflow");
+		return NULL;
+	}
+	
+	pd4j_verify_type *type = &state->stack[--state->sp];
+	
+	if (type->tag == pd4j_VERIFY_OBJECT || type->tag == pd4j_VERIFY_NULL) {
+		return type;
+	}
+	if (allowUninitialized && (type->tag == pd4j_VERIFY_UNINITIALIZED_THIS || type->tag == pd4j_VERIFY_UNINITIALIZED)) {
+		return type;
+	}
+	
+	pd4j_verify_fail(state, "Expected an initialized reference on the operand stack");
+	return NULL;
+}
+
+static bool pd4j_verify_pop_char(pd4j_verify_state *state, char c) {
+	if (c == 'A') {
+		return pd4j_verify_pop_reference(state, false) != NULL;
+	}
+	return pd4j_verify_pop(state, pd4j_verify_char_tag(c));
+}
+
+// checks an instruction given as its operand types in the order they were pushed, then '>' and the result type
+static bool pd4j_verify_apply(pd4j_verify_state *state, const char *signature) {
+	const char *result = strchr(signature, '>');
+	
+	for (const char *c = result; c > signature; c--) {
+		if (!pd4j_verify_pop_char(state, c[-1])) {
+			return false;
+		}
+	}
+	
+	return pd4j_verify_push_tag(state, pd4j_verify_char_tag(result[1]));
+}
+
+// checks that the top depth slots of the operand stack don't split a long or double value
+static bool pd4j_verify_stack_boundary(pd4j_verify_state *state, uint16_t depth) {
+	if (state->sp < depth) {
+		return pd4j_verify_fail(state, "Operand stack underflow");
+	}
+	if (state->stack[state->sp - depth].tag == pd4j_VERIFY_TOP) {
+		return pd4j_verify_fail(state, "Instruction splits a long or double value on the operand stack");
+	}
+	return true;
+}
+
+// the dup family, with the same meaning of count and depth as in the interpreter
+static bool pd4j_verify_dup(pd4j_verify_state *state, uint16_t count, uint16_t depth) {
+	if (!pd4j_verify_stack_boundary(state, count) || !pd4j_verify_stack_boundary(state, count + depth)) {
+		return false;
+	}
+	if (state->sp + count > state->maxStack) {
+		return pd4j_verify_fail(state, "Operand stack overflow");
+	}
+	
+	pd4j_verify_type *top = &state->stack[state->sp - count];
+	memmove(top - depth + count, top - depth, (depth + count) * sizeof(pd4j_verify_type));
+	memcpy(top - depth, top + count, count * sizeof(pd4j_verify_type));
+	state->sp += count;
+	return true;
+}
+
+static void pd4j_verify_set_local(pd4j_verify_state *state, uint16_t idx, pd4j_verify_type *type) {
+	// overwriting the second half of a long or double invalidates the whole value
+	if (idx > 0 && pd4j_verify_is_wide(state->locals[idx - 1].tag)) {
+		state->locals[idx - 1] = pd4j_verify_top;
+	}
+	
+	state->locals[idx] = *type;
+	if (pd4j_verify_is_wide(type->tag)) {
+		state->locals[idx + 1] = pd4j_verify_top;
+	}
+}
+
+static bool pd4j_verify_load(pd4j_verify_state *state, uint16_t idx, char c) {
+	pd4j_verify_type_tag tag = pd4j_verify_char_tag(c);
+	
+	if (idx + (pd4j_verify_is_wide(tag) ? 2 : 1) > state->maxLocals) {
+		return pd4j_verify_fail(state, "Local variable index out of range");
+	}
+	
+	pd4j_verify_type *type = &state->locals[idx];
+	
+	if (c == 'A') {
+		if (!pd4j_verify_is_reference(type->tag)) {
+			return pd4j_verify_fail(state, "Expected a reference in the local variable");
+		}
+		return pd4j_verify_push(state, *type);
+	}
+	
+	if (type->tag != tag) {
+		return pd4j_verify_fail(state, "Wrong type in the local variable");
+	}
+	return pd4j_verify_push_tag(state, tag);
+}
+
+static bool pd4j_verify_store(pd4j_verify_state *state, uint16_t idx, char c) {
+	pd4j_verify_type_tag tag = pd4j_verify_char_tag(c);
+	pd4j_verify_type type = pd4j_verify_type_new(tag);
+	
+	if (idx + (pd4j_verify_is_wide(tag) ? 2 : 1) > state->maxLocals) {
+		return pd4j_verify_fail(state, "Local variable index out of range");
+	}
+	
+	if (c == 'A') {
+		pd4j_verify_type *popped = pd4j_verify_pop_reference(state, true);
+		if (popped == NULL) {
+			return false;
+		}
+		type = *popped;
+	}
+	else if (!pd4j_verify_pop(state, tag)) {
+		return false;
+	}
+	
+	pd4j_verify_set_local(state, idx, &type);
+	return true;
+}
+
+static bool pd4j_verify_iinc(pd4j_verify_state *state, uint16_t idx) {
+	if (idx >= state->maxLocals) {
+		return pd4j_verify_fail(state, "Local variable index out of range");
+	}
+	if (state->locals[idx].tag != pd4j_VERIFY_INTEGER) {
+		return pd4j_verify_fail(state, "Wrong type in the local variable");
+	}
+	return true;
+}
+
+// appends a value to the slot types of a stack map frame being decoded
+static bool pd4j_verify_append(pd4j_verify_state *state, pd4j_verify_type *types, uint16_t *count, uint16_t max, pd4j_verify_type *type) {
+	if (*count + (pd4j_verify_is_wide(type->tag) ? 2 : 1) > max) {
+		return pd4j_verify_fail(state, "StackMapTable frame has more slots than the method allows");
+	}
+	
+	types[(*count)++] = *type;
+	if (pd4j_verify_is_wide(type->tag)) {
+		types[(*count)++] = pd4j_verify_top;
+	}
+	return true;
+}
+
+static bool pd4j_verify_read_type(pd4j_verify_state *state, uint8_t **ptr, uint8_t *end, pd4j_verify_type *type) {
+	if (*ptr >= end) {
+		return pd4j_verify_fail(state, "StackMapTable is truncated");
+	}
+	
+	uint8_t tag = *((*ptr)++);
+	
+	if (tag > pd4j_VERIFY_UNINITIALIZED) {
+		return pd4j_verify_fail(state, "StackMapTable has an invalid verification type");
+	}
+	*type = pd4j_verify_type_new((pd4j_verify_type_tag)tag);
+	
+	if (tag == pd4j_VERIFY_OBJECT || tag == pd4j_VERIFY_UNINITIALIZED) {
+		if (end - *ptr < 2) {
+			return pd4j_verify_fail(state, "StackMapTable is truncated");
+		}
+		
+		uint16_t value = pd4j_verify_read16(*ptr);
+		*ptr += 2;
+		
+		if (tag == pd4j_VERIFY_OBJECT) {
+			if (value == 0 || value >= state->class->numConstants || state->class->constantPool[value - 1].tag != pd4j_CONSTANT_CLASS) {
+				return pd4j_verify_fail(state, "StackMapTable object type is not a class constant");
+			}
+			pd4j_class_constant_utf8(state->class, state->class->constantPool[value - 1].data.indices.a, &type->data.className);
+		}
+		else {
+			if (value >= state->codeLength || state->code[value] != 0xbb) {
+				return pd4j_verify_fail(state, "StackMapTable uninitialized type doesn't refer to a new instruction");
+			}
+			type->data.newOffset = value;
+		}
+	}
+	
+	return true;
+}
+
+// the local variables on entry to the method, as implied by its descriptor
+static bool pd4j_verify_initial_locals(pd4j_verify_state *state, uint16_t *numLocals) {
+	pd4j_class_property *method = state->link->method;
+	pd4j_verify_type type;
+	
+	*numLocals = 0;
+	
+	if ((method->accessFlags.method & pd4j_METHOD_ACC_STATIC) == 0) {
+		bool isInit = strcmp((const char *)(method->name), "<init>") == 0 && strcmp((const char *)(state->link->class->name), "java/lang/Object") != 0;
+		
+		type = pd4j_verify_type_new(isInit ? pd4j_VERIFY_UNINITIALIZED_THIS : pd4j_VERIFY_OBJECT);
+		if (!isInit) {
+			type.data.className = state->link->class->name;
+		}
+		
+		if (!pd4j_verify_append(state, state->mapLocals, numLocals, state->maxLocals, &type)) {
+			return false;
+		}
+	}
+	
+	uint8_t *descriptor = method->descriptor + 1;
+	
+	while (*descriptor != ')') {
+		descriptor = pd4j_verify_parse_descriptor(descriptor, &type);
+		
+		if (!pd4j_verify_append(state, state->mapLocals, numLocals, state->maxLocals, &type)) {
+			return false;
+		}
+	}
+	
+	for (uint16_t i = 0; i < *numLocals; i++) {
+		state->locals[i] = state->mapLocals[i];
+	}
+	for (uint16_t i = *numLocals; i < state->maxLocals; i++) {
+		state->locals[i] = pd4j_verify_top;
+	}
+	state->sp = 0;
+	
+	return true;
+}
+
+// decodes the compressed frames of the StackMapTable into full stack maps, each frame building on the one before it
+static bool pd4j_verify_decode_stack_maps(pd4j_thread *thread, pd4j_verify_state *state, uint16_t numLocals) {
+	pd4j_link_method *link = state->link;
+	uint8_t *ptr = link->codeAttribute->parsedData.code.stackMapTable;
+	
+	if (ptr == NULL) {
+		return true;
+	}
+	
+	uint8_t *end = ptr + link->codeAttribute->parsedData.code.stackMapTableLength;
+	
+	if (end - ptr < 2) {
+		return pd4j_verify_fail(state, "StackMapTable is truncated");
+	}
+	
+	uint16_t numFrames = pd4j_verify_read16(ptr);
+	ptr += 2;
+	
+	if (numFrames == 0) {
+		return true;
+	}
+	
+	link->stackMaps = pd4j_malloc(numFrames * sizeof(pd4j_verify_stack_map));
+	
+	if (link->stackMaps == NULL) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate stack maps: Out of memory");
+		state->error = NULL;
+		return false;
+	}
+	
+	memset(link->stackMaps, 0, numFrames * sizeof(pd4j_verify_stack_map));
+	link->numStackMaps = numFrames;
+	
+	uint32_t offset = 0;
+	
+	for (uint16_t i = 0; i < numFrames; i++) {
+		pd4j_verify_type type;
+		uint16_t numStack = 0;
+		uint16_t delta;
+		
+		if (ptr >= end) {
+			return pd4j_verify_fail(state, "StackMapTable is truncated");
+		}
+		
+		uint8_t frameType = *(ptr++);
+		
+		if (frameType < 64) {
+			// same_frame
+			delta = frameType;
+		}
+		else if (frameType < 128) {
+			// same_locals_1_stack_item_frame
+			delta = frameType - 64;
+			
+			if (!pd4j_verify_read_type(state, &ptr, end, &type) || !pd4j_verify_append(state, state->mapStack, &numStack, state->maxStack, &type)) {
+				return false;
+			}
+		}
+		else if (frameType < 247) {
+			return pd4j_verify_fail(state, "StackMapTable uses a reserved frame type");
+		}
+		else {
+			if (end - ptr < 2) {
+				return pd4j_verify_fail(state, "StackMapTable is truncated");
+			}
+			
+			delta = pd4j_verify_read16(ptr);
+			ptr += 2;
+			
+			if (frameType == 247) {
+				// same_locals_1_stack_item_frame_extended
+				if (!pd4j_verify_read_type(state, &ptr, end, &type) || !pd4j_verify_append(state, state->mapStack, &numStack, state->maxStack, &type)) {
+					return false;
+				}
+			}
+			else if (frameType < 251) {
+				// chop_frame
+				for (uint8_t k = 0; k < 251 - frameType; k++) {
+					if (numLocals == 0) {
+						return pd4j_verify_fail(state, "StackMapTable chops more local variables than there are");
+					}
+					
+					if (numLocals >= 2 && state->mapLocals[numLocals - 1].tag == pd4j_VERIFY_TOP && pd4j_verify_is_wide(state->mapLocals[numLocals - 2].tag)) {
+						numLocals -= 2;
+					}
+					else {
+						numLocals--;
+					}
+				}
+			}
+			else if (frameType == 251) {
+				// same_frame_extended
+			}
+			else if (frameType < 255) {
+				// append_frame
+				for (uint8_t k = 0; k < frameType - 251; k++) {
+					if (!pd4j_verify_read_type(state, &ptr, end, &type) || !pd4j_verify_append(state, state->mapLocals, &numLocals, state->maxLocals, &type)) {
+						return false;
+					}
+				}
+			}
+			else {
+				// full_frame
+				if (end - ptr < 2) {
+					return pd4j_verify_fail(state, "StackMapTable is truncated");
+				}
+				
+				uint16_t count = pd4j_verify_read16(ptr);
+				ptr += 2;
+				numLocals = 0;
+				
+				for (uint16_t k = 0; k < count; k++) {
+					if (!pd4j_verify_read_type(state, &ptr, end, &type) || !pd4j_verify_append(state, state->mapLocals, &numLocals, state->maxLocals, &type)) {
+						return false;
+					}
+				}
+				
+				if (end - ptr < 2) {
+					return pd4j_verify_fail(state, "StackMapTable is truncated");
+				}
+				
+				count = pd4j_verify_read16(ptr);
+				ptr += 2;
+				
+				for (uint16_t k = 0; k < count; k++) {
+					if (!pd4j_verify_read_type(state, &ptr, end, &type) || !pd4j_verify_append(state, state->mapStack, &numStack, state->maxStack, &type)) {
+						return false;
+					}
+				}
+			}
+		}
+		
+		offset = (i == 0) ? delta : offset + delta + 1;
+		
+		if (offset >= state->codeLength) {
+			return pd4j_verify_fail(state, "StackMapTable frame is outside the code");
+		}
+		
+		pd4j_verify_stack_map *map = &link->stackMaps[i];
+		
+		map->types = pd4j_malloc((numLocals + numStack) * sizeof(pd4j_verify_type));
+		
+		if (map->types == NULL && numLocals + numStack > 0) {
+			pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate stack map: Out of memory");
+			state->error = NULL;
+			return false;
+		}
+		
+		map->pcOffset = (uint16_t)offset;
+		map->numLocals = numLocals;
+		map->numStack = numStack;
+		memcpy(map->types, state->mapLocals, numLocals * sizeof(pd4j_verify_type));
+		memcpy(&map->types[numLocals], state->mapStack, numStack * sizeof(pd4j_verify_type));
+	}
+	
+	if (ptr != end) {
+		return pd4j_verify_fail(state, "StackMapTable has trailing data");
+	}
+	
+	return true;
+}
+
+pd4j_verify_stack_map *pd4j_verify_find_stack_map(pd4j_link_method *link, uint32_t pcOffset) {
+	uint16_t low = 0;
+	uint16_t high = link->numStackMaps;
+	
+	while (low < high) {
+		uint16_t mid = low + (high - low) / 2;
+		
+		if (link->stackMaps[mid].pcOffset == pcOffset) {
+			return &link->stackMaps[mid];
+		}
+		else if (link->stackMaps[mid].pcOffset < pcOffset) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	
+	return NULL;
+}
+
+static bool pd4j_verify_matches_locals(pd4j_verify_state *state, pd4j_verify_stack_map *map) {
+	for (uint16_t i = 0; i < state->maxLocals; i++) {
+		pd4j_verify_type *to = (i < map->numLocals) ? &map->types[i] : (pd4j_verify_type *)&pd4j_verify_top;
+		
+		if (!pd4j_verify_is_assignable(&state->locals[i], to)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool pd4j_verify_matches_frame(pd4j_verify_state *state, pd4j_verify_stack_map *map) {
+	if (!pd4j_verify_matches_locals(state, map)) {
+		return pd4j_verify_fail(state, "Local variables don't match the StackMapTable frame");
+	}
+	if (state->sp != map->numStack) {
+		return pd4j_verify_fail(state, "Operand stack depth doesn't match the StackMapTable frame");
+	}
+	
+	for (uint16_t i = 0; i < state->sp; i++) {
+		if (!pd4j_verify_is_assignable(&state->stack[i], &map->types[map->numLocals + i])) {
+			return pd4j_verify_fail(state, "Operand stack doesn't match the StackMapTable frame");
+		}
+	}
+	return true;
+}
+
+static void pd4j_verify_load_frame(pd4j_verify_state *state, pd4j_verify_stack_map *map) {
+	memcpy(state->locals, map->types, map->numLocals * sizeof(pd4j_verify_type));
+	for (uint16_t i = map->numLocals; i < state->maxLocals; i++) {
+		state->locals[i] = pd4j_verify_top;
+	}
+	
+	memcpy(state->stack, &map->types[map->numLocals], map->numStack * sizeof(pd4j_verify_type));
+	state->sp = map->numStack;
+}
+
+static bool pd4j_verify_branch(pd4j_verify_state *state, int32_t displacement) {
+	int64_t target = (int64_t)state->offset + displacement;
+	
+	if (target < 0 || target >= state->codeLength) {
+		return pd4j_verify_fail(state, "Branch target is outside the code");
+	}
+	
+	pd4j_verify_stack_map *map = pd4j_verify_find_stack_map(state->link, (uint32_t)target);
+	
+	if (map == NULL) {
+		return pd4j_verify_fail(state, "Branch target has no StackMapTable frame");
+	}
+	return pd4j_verify_matches_frame(state, map);
+}
+
+// any instruction in a try block can transfer control to its handlers with the current local variables
+static bool pd4j_verify_handlers(pd4j_verify_state *state) {
+	pd4j_class_attribute *codeAttribute = state->link->codeAttribute;
+	
+	for (uint16_t i = 0; i < codeAttribute->parsedData.code.exceptionTableLength; i++) {
+		pd4j_class_exception_table_entry *entry = &codeAttribute->parsedData.code.exceptionTable[i];
+		
+		if (state->offset < (uint32_t)(entry->startPc - state->code) || state->offset >= (uint32_t)(entry->endPc - state->code)) {
+			continue;
+		}
+		
+		pd4j_verify_stack_map *map = pd4j_verify_find_stack_map(state->link, (uint32_t)(entry->handlerPc - state->code));
+		
+		if (map == NULL) {
+			return pd4j_verify_fail(state, "Exception handler has no StackMapTable frame");
+		}
+		if (map->numStack != 1 || map->types[map->numLocals].tag != pd4j_VERIFY_OBJECT) {
+			return pd4j_verify_fail(state, "Exception handler frame must hold only the exception on the operand stack");
+		}
+		if (!pd4j_verify_matches_locals(state, map)) {
+			return pd4j_verify_fail(state, "Local variables don't match the exception handler frame");
+		}
+	}
+	
+	return true;
+}
+
+// finds the name and descriptor of the member a constant refers to, which must have one of the given tags
+static bool pd4j_verify_member(pd4j_verify_state *state, uint16_t idx, pd4j_class_constant_tag tag1, pd4j_class_constant_tag tag2, uint8_t **name, uint8_t **descriptor) {
+	if (idx == 0 || idx >= state->class->numConstants) {
+		return false;
+	}
+	
+	pd4j_class_constant *constant = &state->class->constantPool[idx - 1];
+	
+	if (constant->tag != tag1 && constant->tag != tag2) {
+		return false;
+	}
+	
+	uint16_t nameAndTypeIdx = constant->data.indices.b;
+	
+	if (nameAndTypeIdx == 0 || nameAndTypeIdx >= state->class->numConstants || state->class->constantPool[nameAndTypeIdx - 1].tag != pd4j_CONSTANT_NAMEANDTYPE) {
+		return false;
+	}
+	
+	pd4j_class_constant *nameAndType = &state->class->constantPool[nameAndTypeIdx - 1];
+	
+	return pd4j_class_constant_utf8(state->class, nameAndType->data.indices.a, name) && pd4j_class_constant_utf8(state->class, nameAndType->data.indices.b, descriptor);
+}
+
+static bool pd4j_verify_field(pd4j_verify_state *state, uint8_t opcode, uint16_t idx) {
+	uint8_t *name;
+	uint8_t *descriptor;
+	pd4j_verify_type type;
+	
+	if (!pd4j_verify_member(state, idx, pd4j_CONSTANT_FIELDREF, pd4j_CONSTANT_FIELDREF, &name, &descriptor)) {
+		return pd4j_verify_fail(state, "Field instruction doesn't refer to a field");
+	}
+	
+	pd4j_verify_parse_descriptor(descriptor, &type);
+	
+	switch (opcode) {
+		case 0xb2:
+			// getstatic
+			return pd4j_verify_push(state, type);
+		case 0xb3:
+			// putstatic
+			return (type.tag == pd4j_VERIFY_OBJECT) ? pd4j_verify_pop_reference(state, false) != NULL : pd4j_verify_pop(state, type.tag);
+		case 0xb4:
+			// getfield
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_push(state, type);
+		default: {
+			// putfield (a constructor may set its own fields before calling the superclass constructor)
+			if (!((type.tag == pd4j_VERIFY_OBJECT) ? pd4j_verify_pop_reference(state, false) != NULL : pd4j_verify_pop(state, type.tag))) {
+				return false;
+			}
+			
+			pd4j_verify_type *receiver = pd4j_verify_pop_reference(state, true);
+			
+			if (receiver != NULL && receiver->tag == pd4j_VERIFY_UNINITIALIZED) {
+				return pd4j_verify_fail(state, "Field of an uninitialized object set outside its constructor");
+			}
+			return receiver != NULL;
+		}
+	}
+}
+
+static bool pd4j_verify_invoke(pd4j_verify_state *state, uint8_t opcode, uint16_t idx) {
+	uint8_t *name;
+	uint8_t *descriptor;
+	bool found;
+	
+	switch (opcode) {
+		case 0xb6:
+			found = pd4j_verify_member(state, idx, pd4j_CONSTANT_METHODREF, pd4j_CONSTANT_METHODREF, &name, &descriptor);
+			break;
+		case 0xb9:
+			found = pd4j_verify_member(state, idx, pd4j_CONSTANT_INTERFACEMETHODREF, pd4j_CONSTANT_INTERFACEMETHODREF, &name, &descriptor);
+			break;
+		case 0xba:
+			found = pd4j_verify_member(state, idx, pd4j_CONSTANT_INVOKEDYNAMIC, pd4j_CONSTANT_INVOKEDYNAMIC, &name, &descriptor);
+			break;
+		default:
+			found = pd4j_verify_member(state, idx, pd4j_CONSTANT_METHODREF, pd4j_CONSTANT_INTERFACEMETHODREF, &name, &descriptor);
+			break;
+	}
+	
+	if (!found || descriptor[0] != '(') {
+		return pd4j_verify_fail(state, "Invoke instruction doesn't refer to a method");
+	}
+	
+	bool isInit = strcmp((const char *)name, "<init>") == 0;
+	
+	if (opcode != 0xba && name[0] == '<' && !(isInit && opcode == 0xb7)) {
+		return pd4j_verify_fail(state, "Initialization method called with the wrong invoke instruction");
+	}
+	
+	// check the arguments in place, then pop them together
+	pd4j_verify_type type;
+	uint16_t numSlots = 0;
+	uint8_t *ptr = descriptor + 1;
+	
+	while (*ptr != ')') {
+		ptr = pd4j_verify_parse_descriptor(ptr, &type);
+		numSlots += pd4j_verify_is_wide(type.tag) ? 2 : 1;
+	}
+	
+	if (state->sp < numSlots) {
+		return pd4j_verify_fail(state, "Operand stack underflow");
+	}
+	
+	pd4j_verify_type *arg = &state->stack[state->sp - numSlots];
+	ptr = descriptor + 1;
+	
+	while (*ptr != ')') {
+		ptr = pd4j_verify_parse_descriptor(ptr, &type);
+		
+		if (!pd4j_verify_is_assignable(arg, &type) || (pd4j_verify_is_wide(type.tag) && arg[1].tag != pd4j_VERIFY_TOP)) {
+			return pd4j_verify_fail(state, "Method argument has the wrong type");
+		}
+		arg += pd4j_verify_is_wide(type.tag) ? 2 : 1;
+	}
+	
+	state->sp -= numSlots;
+	
+	if (opcode != 0xb8 && opcode != 0xba) {
+		pd4j_verify_type *receiver = pd4j_verify_pop_reference(state, isInit);
+		
+		if (receiver == NULL) {
+			return false;
+		}
+		
+		if (isInit) {
+			pd4j_verify_type uninitialized = *receiver;
+			pd4j_verify_type initialized = pd4j_verify_type_new(pd4j_VERIFY_OBJECT);
+			
+			if (uninitialized.tag != pd4j_VERIFY_UNINITIALIZED_THIS && uninitialized.tag != pd4j_VERIFY_UNINITIALIZED) {
+				return pd4j_verify_fail(state, "Constructor called on an object that is already initialized");
+			}
+			
+			// every copy of the object becomes initialized at once
+			for (uint16_t i = 0; i < state->maxLocals; i++) {
+				if (state->locals[i].tag == uninitialized.tag && (uninitialized.tag == pd4j_VERIFY_UNINITIALIZED_THIS || state->locals[i].data.newOffset == uninitialized.data.newOffset)) {
+					state->locals[i] = initialized;
+				}
+			}
+			for (uint16_t i = 0; i < state->sp; i++) {
+				if (state->stack[i].tag == uninitialized.tag && (uninitialized.tag == pd4j_VERIFY_UNINITIALIZED_THIS || state->stack[i].data.newOffset == uninitialized.data.newOffset)) {
+					state->stack[i] = initialized;
+				}
+			}
+		}
+	}
+	
+	pd4j_verify_parse_descriptor(ptr + 1, &type);
+	
+	return (type.tag == pd4j_VERIFY_TOP) || pd4j_verify_push(state, type);
+}
+
+static bool pd4j_verify_ldc(pd4j_verify_state *state, uint16_t idx, bool wide) {
+	if (idx == 0 || idx >= state->class->numConstants) {
+		return pd4j_verify_fail(state, "Constant pool index out of range");
+	}
+	
+	pd4j_class_constant *constant = &state->class->constantPool[idx - 1];
+	pd4j_verify_type type = pd4j_verify_type_new(pd4j_VERIFY_OBJECT);
+	
+	switch (constant->tag) {
+		case pd4j_CONSTANT_INT:
+			type.tag = pd4j_VERIFY_INTEGER;
+			break;
+		case pd4j_CONSTANT_FLOAT:
+			type.tag = pd4j_VERIFY_FLOAT;
+			break;
+		case pd4j_CONSTANT_LONG:
+			type.tag = pd4j_VERIFY_LONG;
+			break;
+		case pd4j_CONSTANT_DOUBLE:
+			type.tag = pd4j_VERIFY_DOUBLE;
+			break;
+		case pd4j_CONSTANT_STRING:
+			type.data.className = (uint8_t *)"java/lang/String";
+			break;
+		case pd4j_CONSTANT_CLASS:
+			type.data.className = (uint8_t *)"java/lang/Class";
+			break;
+		case pd4j_CONSTANT_METHODTYPE:
+			type.data.className = (uint8_t *)"java/lang/invoke/MethodType";
+			break;
+		case pd4j_CONSTANT_METHODHANDLE:
+			type.data.className = (uint8_t *)"java/lang/invoke/MethodHandle";
+			break;
+		case pd4j_CONSTANT_DYNAMIC: {
+			uint8_t *name;
+			uint8_t *descriptor;
+			
+			if (!pd4j_verify_member(state, idx, pd4j_CONSTANT_DYNAMIC, pd4j_CONSTANT_DYNAMIC, &name, &descriptor)) {
+				return pd4j_verify_fail(state, "Dynamic constant has no valid descriptor");
+			}
+			pd4j_verify_parse_descriptor(descriptor, &type);
+			break;
+		}
+		default:
+			return pd4j_verify_fail(state, "ldc refers to a constant that can't be loaded");
+	}
+	
+	if (pd4j_verify_is_wide(type.tag) != wide) {
+		return pd4j_verify_fail(state, "ldc2_w must load a long or double and ldc any other constant");
+	}
+	
+	return pd4j_verify_push(state, type);
+}
+
+static bool pd4j_verify_return(pd4j_verify_state *state, char c) {
+	pd4j_verify_type type;
+	pd4j_verify_parse_descriptor((uint8_t *)strchr((char *)(state->link->method->descriptor), ')') + 1, &type);
+	
+	if (c == 'V') {
+		if (type.tag != pd4j_VERIFY_TOP) {
+			return pd4j_verify_fail(state, "Return instruction doesn't match the method's return type");
+		}
+		
+		for (uint16_t i = 0; i < state->maxLocals; i++) {
+			if (state->locals[i].tag == pd4j_VERIFY_UNINITIALIZED_THIS) {
+				return pd4j_verify_fail(state, "Constructor returns before calling another constructor");
+			}
+		}
+		return true;
+	}
+	
+	if (type.tag != pd4j_verify_char_tag(c)) {
+		return pd4j_verify_fail(state, "Return instruction doesn't match the method's return type");
+	}
+	return pd4j_verify_pop_char(state, c);
+}
+
+// arithmetic, conversions and comparisons (0x60 - 0x98), in the format pd4j_verify_apply takes
+static const char *const pd4j_verify_arithmetic[] = {
+	// add, sub, mul, div, rem
+	"II>I", "JJ>J", "FF>F", "DD>D",
+	"II>I", "JJ>J", "FF>F", "DD>D",
+	"II>I", "JJ>J", "FF>F", "DD>D",
+	"II>I", "JJ>J", "FF>F", "DD>D",
+	"II>I", "JJ>J", "FF>F", "DD>D",
+	// neg
+	"I>I", "J>J", "F>F", "D>D",
+	// shl, shr, ushr
+	"II>I", "JI>J", "II>I", "JI>J", "II>I", "JI>J",
+	// and, or, xor
+	"II>I", "JJ>J", "II>I", "JJ>J", "II>I", "JJ>J",
+	// iinc is handled separately
+	NULL,
+	// conversions
+	"I>J", "I>F", "I>D", "J>I", "J>F", "J>D", "F>I", "F>J", "F>D", "D>I", "D>J", "D>F", "I>I", "I>I", "I>I",
+	// lcmp, fcmpl, fcmpg, dcmpl, dcmpg
+	"JJ>I", "FF>I", "FF>I", "DD>I", "DD>I"
+};
+
+// checks one instruction against the types before it, leaving the types after it
+static bool pd4j_verify_instruction(pd4j_verify_state *state, bool *fallsThrough) {
+	uint8_t *ins = &state->code[state->offset];
+	uint8_t opcode = ins[0];
+	
+	*fallsThrough = true;
+	
+	if (opcode >= 0x60 && opcode <= 0x98 && opcode != 0x84) {
+		return pd4j_verify_apply(state, pd4j_verify_arithmetic[opcode - 0x60]);
+	}
+	
+	switch (opcode) {
+		case 0x00:
+			// nop
+			return true;
+		case 0x01:
+			// aconst_null
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_NULL);
+		case 0x02:
+		case 0x03:
+		case 0x04:
+		case 0x05:
+		case 0x06:
+		case 0x07:
+		case 0x08:
+		case 0x10:
+		case 0x11:
+			// iconst_<i>, bipush, sipush
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_INTEGER);
+		case 0x09:
+		case 0x0a:
+			// lconst_<l>
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_LONG);
+		case 0x0b:
+		case 0x0c:
+		case 0x0d:
+			// fconst_<f>
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_FLOAT);
+		case 0x0e:
+		case 0x0f:
+			// dconst_<d>
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_DOUBLE);
+		case 0x12:
+			// ldc
+			return pd4j_verify_ldc(state, ins[1], false);
+		case 0x13:
+		case 0x14:
+			// ldc_w, ldc2_w
+			return pd4j_verify_ldc(state, pd4j_verify_read16(&ins[1]), opcode == 0x14);
+		case 0x15:
+		case 0x16:
+		case 0x17:
+		case 0x18:
+		case 0x19:
+			// <t>load
+			return pd4j_verify_load(state, ins[1], "IJFDA"[opcode - 0x15]);
+		case 0x1a:
+		case 0x1b:
+		case 0x1c:
+		case 0x1d:
+		case 0x1e:
+		case 0x1f:
+		case 0x20:
+		case 0x21:
+		case 0x22:
+		case 0x23:
+		case 0x24:
+		case 0x25:
+		case 0x26:
+		case 0x27:
+		case 0x28:
+		case 0x29:
+		case 0x2a:
+		case 0x2b:
+		case 0x2c:
+		case 0x2d:
+			// <t>load_<n>
+			return pd4j_verify_load(state, (opcode - 0x1a) % 4, "IJFDA"[(opcode - 0x1a) / 4]);
+		case 0x2e:
+		case 0x2f:
+		case 0x30:
+		case 0x31:
+		case 0x32:
+		case 0x33:
+		case 0x34:
+		case 0x35: {
+			// <t>aload
+			char c = "IJFDAIII"[opcode - 0x2e];
+			return pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_push_tag(state, pd4j_verify_char_tag(c));
+		}
+		case 0x36:
+		case 0x37:
+		case 0x38:
+		case 0x39:
+		case 0x3a:
+			// <t>store
+			return pd4j_verify_store(state, ins[1], "IJFDA"[opcode - 0x36]);
+		case 0x3b:
+		case 0x3c:
+		case 0x3d:
+		case 0x3e:
+		case 0x3f:
+		case 0x40:
+		case 0x41:
+		case 0x42:
+		case 0x43:
+		case 0x44:
+		case 0x45:
+		case 0x46:
+		case 0x47:
+		case 0x48:
+		case 0x49:
+		case 0x4a:
+		case 0x4b:
+		case 0x4c:
+		case 0x4d:
+		case 0x4e:
+			// <t>store_<n>
+			return pd4j_verify_store(state, (opcode - 0x3b) % 4, "IJFDA"[(opcode - 0x3b) / 4]);
+		case 0x4f:
+		case 0x50:
+		case 0x51:
+		case 0x52:
+		case 0x53:
+		case 0x54:
+		case 0x55:
+		case 0x56: {
+			// <t>astore
+			char c = "IJFDAIII"[opcode - 0x4f];
+			return pd4j_verify_pop_char(state, c) && pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_pop_reference(state, false) != NULL;
+		}
+		case 0x57:
+		case 0x58: {
+			// pop, pop2
+			uint16_t count = opcode - 0x56;
+			
+			if (!pd4j_verify_stack_boundary(state, count)) {
+				return false;
+			}
+			state->sp -= count;
+			return true;
+		}
+		case 0x59:
+			// dup
+			return pd4j_verify_dup(state, 1, 0);
+		case 0x5a:
+			// dup_x1
+			return pd4j_verify_dup(state, 1, 1);
+		case 0x5b:
+			// dup_x2
+			return pd4j_verify_dup(state, 1, 2);
+		case 0x5c:
+			// dup2
+			return pd4j_verify_dup(state, 2, 0);
+		case 0x5d:
+			// dup2_x1
+			return pd4j_verify_dup(state, 2, 1);
+		case 0x5e:
+			// dup2_x2
+			return pd4j_verify_dup(state, 2, 2);
+		case 0x5f: {
+			// swap
+			if (!pd4j_verify_stack_boundary(state, 1) || !pd4j_verify_stack_boundary(state, 2)) {
+				return false;
+			}
+			
+			pd4j_verify_type temp = state->stack[state->sp - 1];
+			state->stack[state->sp - 1] = state->stack[state->sp - 2];
+			state->stack[state->sp - 2] = temp;
+			return true;
+		}
+		case 0x84:
+			// iinc
+			return pd4j_verify_iinc(state, ins[1]);
+		case 0x99:
+		case 0x9a:
+		case 0x9b:
+		case 0x9c:
+		case 0x9d:
+		case 0x9e:
+			// if<cond>
+			return pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_branch(state, (int16_t)pd4j_verify_read16(&ins[1]));
+		case 0x9f:
+		case 0xa0:
+		case 0xa1:
+		case 0xa2:
+		case 0xa3:
+		case 0xa4:
+			// if_icmp<cond>
+			return pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_branch(state, (int16_t)pd4j_verify_read16(&ins[1]));
+		case 0xa5:
+		case 0xa6:
+			// if_acmp<cond>
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_branch(state, (int16_t)pd4j_verify_read16(&ins[1]));
+		case 0xa7:
+			// goto
+			*fallsThrough = false;
+			return pd4j_verify_branch(state, (int16_t)pd4j_verify_read16(&ins[1]));
+		case 0xa8:
+		case 0xa9:
+		case 0xc9:
+			// jsr, ret, jsr_w
+			return pd4j_verify_fail(state, "Subroutines aren't allowed in class files with stack maps");
+		case 0xaa: {
+			// tableswitch
+			uint8_t *operands = &state->code[(state->offset + 4) & ~(uint32_t)3];
+			int32_t lowValue = pd4j_verify_read32(&operands[4]);
+			int32_t highValue = pd4j_verify_read32(&operands[8]);
+			
+			*fallsThrough = false;
+			
+			if (!pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) || !pd4j_verify_branch(state, pd4j_verify_read32(operands))) {
+				return false;
+			}
+			
+			for (uint32_t i = 0; i <= (uint32_t)(highValue - lowValue); i++) {
+				if (!pd4j_verify_branch(state, pd4j_verify_read32(&operands[12 + 4 * i]))) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case 0xab: {
+			// lookupswitch
+			uint8_t *operands = &state->code[(state->offset + 4) & ~(uint32_t)3];
+			int32_t numPairs = pd4j_verify_read32(&operands[4]);
+			
+			*fallsThrough = false;
+			
+			if (!pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) || !pd4j_verify_branch(state, pd4j_verify_read32(operands))) {
+				return false;
+			}
+			
+			for (int32_t i = 0; i < numPairs; i++) {
+				if (i > 0 && pd4j_verify_read32(&operands[8 + 8 * i]) <= pd4j_verify_read32(&operands[8 * i])) {
+					return pd4j_verify_fail(state, "lookupswitch keys aren't sorted");
+				}
+				if (!pd4j_verify_branch(state, pd4j_verify_read32(&operands[12 + 8 * i]))) {
+					return false;
+				}
+			}
+			return true;
+		}
+		case 0xac:
+		case 0xad:
+		case 0xae:
+		case 0xaf:
+		case 0xb0:
+		case 0xb1:
+			// <t>return, return
+			*fallsThrough = false;
+			return pd4j_verify_return(state, "IJFDAV"[opcode - 0xac]);
+		case 0xb2:
+		case 0xb3:
+		case 0xb4:
+		case 0xb5:
+			// getstatic, putstatic, getfield, putfield
+			return pd4j_verify_field(state, opcode, pd4j_verify_read16(&ins[1]));
+		case 0xb6:
+		case 0xb7:
+		case 0xb8:
+		case 0xb9:
+		case 0xba:
+			// invokevirtual, invokespecial, invokestatic, invokeinterface, invokedynamic
+			return pd4j_verify_invoke(state, opcode, pd4j_verify_read16(&ins[1]));
+		case 0xbb: {
+			// new
+			uint16_t idx = pd4j_verify_read16(&ins[1]);
+			
+			if (idx == 0 || idx >= state->class->numConstants || state->class->constantPool[idx - 1].tag != pd4j_CONSTANT_CLASS) {
+				return pd4j_verify_fail(state, "new doesn't refer to a class constant");
+			}
+			
+			pd4j_verify_type type = pd4j_verify_type_new(pd4j_VERIFY_UNINITIALIZED);
+			type.data.newOffset = (uint16_t)state->offset;
+			return pd4j_verify_push(state, type);
+		}
+		case 0xbc:
+			// newarray
+			if (ins[1] < 4 || ins[1] > 11) {
+				return pd4j_verify_fail(state, "newarray has an invalid element type");
+			}
+			return pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_push_tag(state, pd4j_VERIFY_OBJECT);
+		case 0xbd:
+			// anewarray
+			return pd4j_verify_pop(state, pd4j_VERIFY_INTEGER) && pd4j_verify_push_tag(state, pd4j_VERIFY_OBJECT);
+		case 0xbe:
+			// arraylength
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_push_tag(state, pd4j_VERIFY_INTEGER);
+		case 0xbf:
+			// athrow
+			*fallsThrough = false;
+			return pd4j_verify_pop_reference(state, false) != NULL;
+		case 0xc0:
+			// checkcast
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_push_tag(state, pd4j_VERIFY_OBJECT);
+		case 0xc1:
+			// instanceof
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_push_tag(state, pd4j_VERIFY_INTEGER);
+		case 0xc2:
+		case 0xc3:
+			// monitorenter, monitorexit
+			return pd4j_verify_pop_reference(state, false) != NULL;
+		case 0xc4: {
+			// wide
+			uint16_t idx = pd4j_verify_read16(&ins[2]);
+			
+			switch (ins[1]) {
+				case 0x15:
+				case 0x16:
+				case 0x17:
+				case 0x18:
+				case 0x19:
+					return pd4j_verify_load(state, idx, "IJFDA"[ins[1] - 0x15]);
+				case 0x36:
+				case 0x37:
+				case 0x38:
+				case 0x39:
+				case 0x3a:
+					return pd4j_verify_store(state, idx, "IJFDA"[ins[1] - 0x36]);
+				case 0x84:
+					return pd4j_verify_iinc(state, idx);
+				case 0xa9:
+					return pd4j_verify_fail(state, "Subroutines aren't allowed in class files with stack maps");
+				default:
+					return pd4j_verify_fail(state, "Illegal instruction after wide");
+			}
+		}
+		case 0xc5: {
+			// multianewarray
+			if (ins[3] == 0) {
+				return pd4j_verify_fail(state, "multianewarray must create at least one dimension");
+			}
+			
+			for (uint8_t i = 0; i < ins[3]; i++) {
+				if (!pd4j_verify_pop(state, pd4j_VERIFY_INTEGER)) {
+					return false;
+				}
+			}
+			return pd4j_verify_push_tag(state, pd4j_VERIFY_OBJECT);
+		}
+		case 0xc6:
+		case 0xc7:
+			// ifnull, ifnonnull
+			return pd4j_verify_pop_reference(state, false) != NULL && pd4j_verify_branch(state, (int16_t)pd4j_verify_read16(&ins[1]));
+		case 0xc8:
+			// goto_w
+			*fallsThrough = false;
+			return pd4j_verify_branch(state, pd4j_verify_read32(&ins[1]));
+		default:
+			return pd4j_verify_fail(state, "Illegal opcode");
+	}
+}
+
+static bool pd4j_verify_code(pd4j_thread *thread, pd4j_verify_state *state) {
+	pd4j_link_method *link = state->link;
+	pd4j_class_attribute *codeAttribute = link->codeAttribute;
+	uint16_t numLocals;
+	
+	if (state->codeLength == 0) {
+		return pd4j_verify_fail(state, "Method has no code");
+	}
+	
+	for (uint16_t i = 0; i < codeAttribute->parsedData.code.exceptionTableLength; i++) {
+		pd4j_class_exception_table_entry *entry = &codeAttribute->parsedData.code.exceptionTable[i];
+		
+		if (entry->startPc >= entry->endPc || entry->endPc > &state->code[state->codeLength] || entry->handlerPc >= &state->code[state->codeLength]) {
+			return pd4j_verify_fail(state, "Exception table entry is outside the code");
+		}
+	}
+	
+	if (!pd4j_verify_initial_locals(state, &numLocals) || !pd4j_verify_decode_stack_maps(thread, state, numLocals)) {
+		return false;
+	}
+	
+	uint16_t nextMap = 0;
+	bool fallsThrough = true;
+	
+	state->offset = 0;
+	
+	while (state->offset < state->codeLength) {
+		pd4j_verify_stack_map *map = (nextMap < link->numStackMaps) ? &link->stackMaps[nextMap] : NULL;
+		
+		if (map != NULL && map->pcOffset < state->offset) {
+			state->offset = map->pcOffset;
+			return pd4j_verify_fail(state, "StackMapTable frame isn't at the start of an instruction");
+		}
+		
+		if (map != NULL && map->pcOffset == state->offset) {
+			if (fallsThrough && !pd4j_verify_matches_frame(state, map)) {
+				return false;
+			}
+			
+			pd4j_verify_load_frame(state, map);
+			nextMap++;
+		}
+		else if (!fallsThrough) {
+			return pd4j_verify_fail(state, "No StackMapTable frame after an unconditional branch");
+		}
+		
+		uint32_t length = pd4j_link_instruction_length(state->code, state->offset);
+		
+		if (length == 0 || length > state->codeLength - state->offset) {
+			return pd4j_verify_fail(state, "Instruction runs past the end of the code");
+		}
+		
+		if (!pd4j_verify_handlers(state) || !pd4j_verify_instruction(state, &fallsThrough)) {
+			return false;
+		}
+		
+		state->offset += length;
+	}
+	
+	if (fallsThrough) {
+		return pd4j_verify_fail(state, "Execution can fall off the end of the code");
+	}
+	
+	return true;
+}
+
+bool pd4j_verify_method(pd4j_thread *thread, pd4j_link_method *link) {
+	pd4j_class *class = link->class->data.class;
+	pd4j_class_attribute *codeAttribute = link->codeAttribute;
+	
+	link->verified = false;
+	link->numStackMaps = 0;
+	link->stackMaps = NULL;
+	
+	// older class files are meant for the type-inferencing verifier, which isn't implemented
+	// the interpreter doesn't check what the verifier proves, so their code is refused unless it's trusted
+	if (class->majorVersion < 50 || (class->majorVersion == 50 && codeAttribute->parsedData.code.stackMapTable == NULL)) {
+#ifdef PD4J_TRUST_UNVERIFIED
+		return true;
+#else
+		char *message;
+		pd->system->formatString(&message, "Class file version %d can't be verified without a StackMapTable (%s.%s%s)", (int)(class->majorVersion), link->class->name, link->method->name, link->method->descriptor);
+		pd4j_thread_throw_class_with_message(thread, "java/lang/VerifyError", message);
+		pd->system->realloc(message, 0);
+		return false;
+#endif
+	}
+	
+	pd4j_verify_state state;
+	state.link = link;
+	state.class = class;
+	state.code = codeAttribute->parsedData.code.code;
+	state.codeLength = codeAttribute->parsedData.code.codeLength;
+	state.maxLocals = codeAttribute->parsedData.code.maxLocals;
+	state.maxStack = codeAttribute->parsedData.code.maxStack;
+	state.sp = 0;
+	state.offset = 0;
+	state.error = NULL;
+	
+	size_t bufferSize = 2 * (state.maxLocals + state.maxStack) * sizeof(pd4j_verify_type);
+	pd4j_verify_type *buffer = pd4j_malloc(bufferSize);
+	
+	if (buffer == NULL && bufferSize > 0) {
+		pd4j_thread_throw_class_with_message(thread, "java/lang/OutOfMemoryError", "Unable to allocate verifier state: Out of memory");
+		return false;
+	}
+	
+	state.locals = buffer;
+	state.stack = &buffer[state.maxLocals];
+	state.mapLocals = &buffer[state.maxLocals + state.maxStack];
+	state.mapStack = &buffer[2 * state.maxLocals + state.maxStack];
+	
+	bool success = pd4j_verify_code(thread, &state);
+	
+	if (buffer != NULL) {
+		pd4j_free(buffer, bufferSize);
+	}
+	
+	if (!success) {
+		if (state.error != NULL) {
+			char *message;
+			pd->system->formatString(&message, "%s (%s.%s%s at offset %d)", state.error, link->class->name, link->method->name, link->method->descriptor, (int)state.offset);
+			pd4j_thread_throw_class_with_message(thread, "java/lang/VerifyError", message);
+			pd->system->realloc(message, 0);
+		}
+		
+		pd4j_verify_destroy_stack_maps(link);
+		return false;
+	}
+	
+	link->verified = true;
+	return true;
+}
+
+void pd4j_verify_destroy_stack_maps(pd4j_link_method *link) {
+	if (link->stackMaps == NULL) {
+		return;
+	}
+	
+	for (uint16_t i = 0; i < link->numStackMaps; i++) {
+		pd4j_verify_stack_map *map = &link->stackMaps[i];
+		
+		if (map->types != NULL) {
+			pd4j_free(map->types, (map->numLocals + map->numStack) * sizeof(pd4j_verify_type));
+		}
+	}
+	
+	pd4j_free(link->stackMaps, link->numStackMaps * sizeof(pd4j_verify_stack_map));
+	link->stackMaps = NULL;
+	link->numStackMaps = 0;
+}
\ No newline at end of file
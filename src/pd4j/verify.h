@@ -0,0 +1,50 @@
+#ifndef PD4J_VERIFY_H
+#define PD4J_VERIFY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "class.h"
+#include "thread.h"
+
+// same values as the verification_type_info tags in a StackMapTable
+typedef enum {
+	pd4j_VERIFY_TOP = 0,
+	pd4j_VERIFY_INTEGER,
+	pd4j_VERIFY_FLOAT,
+	pd4j_VERIFY_DOUBLE,
+	pd4j_VERIFY_LONG,
+	pd4j_VERIFY_NULL,
+	pd4j_VERIFY_UNINITIALIZED_THIS,
+	pd4j_VERIFY_OBJECT,
+	pd4j_VERIFY_UNINITIALIZED
+} pd4j_verify_type_tag;
+
+// the type of one slot; long and double values are followed by a TOP slot
+typedef struct {
+	pd4j_verify_type_tag tag;
+	union {
+		// NULL when the class isn't known
+		uint8_t *className;
+		// offset of the new instruction that created the object
+		uint16_t newOffset;
+	} data;
+} pd4j_verify_type;
+
+typedef struct {
+	uint16_t pcOffset;
+	
+	uint16_t numLocals;
+	uint16_t numStack;
+	// the local variables followed by the operand stack
+	pd4j_verify_type *types;
+} pd4j_verify_stack_map;
+
+// type-checks a method's code against its StackMapTable and keeps the decoded stack maps in the link, throwing VerifyError if it fails
+bool pd4j_verify_method(pd4j_thread *thread, pd4j_link_method *link);
+void pd4j_verify_destroy_stack_maps(pd4j_link_method *link);
+
+// the slot types at an instruction that starts a basic block, or NULL if the StackMapTable doesn't describe it
+pd4j_verify_stack_map *pd4j_verify_find_stack_map(pd4j_link_method *link, uint32_t pcOffset);
+
+#endif
\ No newline at end of file
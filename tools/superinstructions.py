@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Chooses the superinstructions pd4j applies from opcode profiles.
+
+Build with -DPD4J_PROFILE_OPCODES=ON, run the workloads, call
+pd4j.thread.logOpcodeProfile() from Lua and save the console output. Then:
+
+    tools/superinstructions.py log1.txt [log2.txt ...] > src/pd4j/superinstructions.h
+
+Sequences are ranked by the dispatches fusing them would save. The ones with a
+handler in the interpreter are written to the header, best first, and the best
+of the rest are listed on stderr as candidates for new handlers.
+"""
+
+import argparse
+import collections
+import re
+import sys
+
+MNEMONICS = (
+	"nop aconst_null iconst_m1 iconst_0 iconst_1 iconst_2 iconst_3 iconst_4 iconst_5 lconst_0 lconst_1 "
+	"fconst_0 fconst_1 fconst_2 dconst_0 dconst_1 bipush sipush ldc ldc_w ldc2_w iload lload fload dload "
+	"aload iload_0 iload_1 iload_2 iload_3 lload_0 lload_1 lload_2 lload_3 fload_0 fload_1 fload_2 fload_3 "
+	"dload_0 dload_1 dload_2 dload_3 aload_0 aload_1 aload_2 aload_3 iaload laload faload daload aaload "
+	"baload caload saload istore lstore fstore dstore astore istore_0 istore_1 istore_2 istore_3 lstore_0 "
+	"lstore_1 lstore_2 lstore_3 fstore_0 fstore_1 fstore_2 fstore_3 dstore_0 dstore_1 dstore_2 dstore_3 "
+	"astore_0 astore_1 astore_2 astore_3 iastore lastore fastore dastore aastore bastore castore sastore "
+	"pop pop2 dup dup_x1 dup_x2 dup2 dup2_x1 dup2_x2 swap iadd ladd fadd dadd isub lsub fsub dsub imul lmul "
+	"fmul dmul idiv ldiv fdiv ddiv irem lrem frem drem ineg lneg fneg dneg ishl lshl ishr lshr iushr lushr "
+	"iand land ior lor ixor lxor iinc i2l i2f i2d l2i l2f l2d f2i f2l f2d d2i d2l d2f i2b i2c i2s lcmp "
+	"fcmpl fcmpg dcmpl dcmpg ifeq ifne iflt ifge ifgt ifle if_icmpeq if_icmpne if_icmplt if_icmpge "
+	"if_icmpgt if_icmple if_acmpeq if_acmpne goto jsr ret tableswitch lookupswitch ireturn lreturn "
+	"freturn dreturn areturn return getstatic putstatic getfield putfield invokevirtual invokespecial "
+	"invokestatic invokeinterface invokedynamic new newarray anewarray arraylength athrow checkcast "
+	"instanceof monitorenter monitorexit wide multianewarray ifnull ifnonnull goto_w jsr_w breakpoint "
+	"invokevirtual_quick invokespecial_quick invokestatic_quick invokeinterface_quick invokedirect_quick"
+).split()
+
+# the quickened invokes stand for the instructions they replaced
+QUICK = {0xcb: 0xb6, 0xcc: 0xb7, 0xcd: 0xb8, 0xce: 0xb9, 0xcf: 0xb6}
+
+# sequences the interpreter has a fused handler for, with the pd4j_link_opcode it uses
+HANDLERS = {
+	(0x2a, 0xb4): "pd4j_OPCODE_ALOAD_0_GETFIELD",
+	(0x15, 0x15, 0x60, 0x36): "pd4j_OPCODE_ILOAD_ILOAD_IADD_ISTORE",
+	(0x15, 0x10, 0xa1): "pd4j_OPCODE_ILOAD_BIPUSH_IF_ICMPLT",
+	(0x19, 0x15, 0x2e): "pd4j_OPCODE_ALOAD_ILOAD_IALOAD",
+}
+
+LINE = re.compile(r"opcode sequence ((?:[0-9a-f]{2} ?)+): (\d+)")
+
+
+def name(opcode):
+	return MNEMONICS[opcode] if opcode < len(MNEMONICS) else "0x%02x" % opcode
+
+
+def read_profiles(paths):
+	counts = collections.Counter()
+
+	for path in paths:
+		with open(path, encoding="utf-8", errors="replace") as f:
+			for line in f:
+				match = LINE.search(line)
+				if match:
+					sequence = tuple(QUICK.get(int(op, 16), int(op, 16)) for op in match.group(1).split())
+					counts[sequence] += int(match.group(2))
+
+	return counts
+
+
+def write_header(selected, out):
+	out.write("#ifndef PD4J_SUPERINSTRUCTIONS_H\n")
+	out.write("#define PD4J_SUPERINSTRUCTIONS_H\n\n")
+	out.write('#include "link.h"\n\n')
+	out.write("// generated by tools/superinstructions.py from opcode profiles of the workloads; earlier entries are tried first\n")
+	out.write("static const pd4j_link_superinstruction pd4j_link_superinstructions[] = {\n")
+
+	entries = []
+	for sequence in selected:
+		opcodes = ", ".join("0x%02x" % op for op in sequence)
+		entries.append("\t// %s\n\t{%s, %d, {%s}}" % (", ".join(name(op) for op in sequence), HANDLERS[sequence], len(sequence), opcodes))
+	out.write(",\n".join(entries) + "\n")
+
+	out.write("};\n\n#endif\n")
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+	parser.add_argument("logs", nargs="+", help="console output containing pd4j opcode profiles")
+	parser.add_argument("--min-share", type=float, default=0.001, help="smallest share of all saved dispatches a superinstruction must account for")
+	parser.add_argument("--candidates", type=int, default=10, help="number of sequences without a handler to suggest")
+	args = parser.parse_args()
+
+	counts = read_profiles(args.logs)
+	if not counts:
+		sys.exit("no opcode profile found in the given logs")
+
+	# fusing n instructions saves n - 1 dispatches each time the sequence runs
+	savings = {sequence: count * (len(sequence) - 1) for sequence, count in counts.items()}
+	total = sum(savings.values())
+	ranked = sorted(savings, key=lambda sequence: (-savings[sequence], sequence))
+
+	selected = [sequence for sequence in ranked if sequence in HANDLERS and savings[sequence] >= args.min_share * total]
+	if not selected:
+		sys.exit("none of the sequences with a handler ran often enough to be worth fusing")
+
+	write_header(selected, sys.stdout)
+
+	for sequence in selected:
+		sys.stderr.write("fused   %6.2f%%  %s\n" % (100.0 * savings[sequence] / total, ", ".join(name(op) for op in sequence)))
+
+	candidates = [sequence for sequence in ranked if sequence not in HANDLERS][:args.candidates]
+	for sequence in candidates:
+		sys.stderr.write("no handler %6.2f%%  %s\n" % (100.0 * savings[sequence] / total, ", ".join(name(op) for op in sequence)))
+
+
+if __name__ == "__main__":
+	main()